@@ -0,0 +1,158 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <fmt/format.h>
+#include "../src/avif/av1/Parser.hpp"
+#include "../src/avif/av1/BitStreamReader.hpp"
+#include "../src/avif/av1/OBUScanner.hpp"
+#include "../src/avif/util/FileLogger.hpp"
+#include "Bench.hpp"
+
+namespace {
+
+std::vector<uint8_t> makeNoise(size_t const size) {
+  std::vector<uint8_t> buffer(size);
+  uint32_t state = 0x12345678u;
+  for(auto& v : buffer) {
+    state = state * 1664525u + 1013904223u;
+    v = static_cast<uint8_t>(state >> 24u);
+  }
+  return buffer;
+}
+
+// Every byte but the last of each number has the continuation bit.
+std::vector<uint8_t> makeLEB128s(size_t const count) {
+  std::vector<uint8_t> buffer;
+  for(size_t i = 0; i < count; ++i) {
+    uint32_t value = static_cast<uint32_t>(i * 2654435761u) >> (i % 4u * 7u);
+    do {
+      uint8_t const byte = value & 0x7fu;
+      value >>= 7u;
+      buffer.emplace_back(value != 0 ? byte | 0x80u : byte);
+    } while(value != 0);
+  }
+  return buffer;
+}
+
+// uvlc() codes of small numbers: as frame header fields are.
+std::vector<uint8_t> makeUVLCs(size_t const count) {
+  std::vector<uint8_t> buffer;
+  uint64_t acc = 0;
+  size_t bits = 0;
+  auto const put = [&](uint32_t const value, size_t const width) {
+    for(size_t i = width; i > 0; --i) {
+      acc = acc << 1u | ((value >> (i - 1)) & 1u);
+      if(++bits == 8) {
+        buffer.emplace_back(static_cast<uint8_t>(acc));
+        acc = 0;
+        bits = 0;
+      }
+    }
+  };
+  for(size_t i = 0; i < count; ++i) {
+    uint32_t const value = static_cast<uint32_t>(i % 200u);
+    uint32_t const coded = value + 1;
+    size_t leadingZeros = 0;
+    while((coded >> (leadingZeros + 1)) != 0) {
+      ++leadingZeros;
+    }
+    put(0, leadingZeros);
+    put(coded, leadingZeros + 1);
+  }
+  put(0, (8 - bits) % 8);
+  return buffer;
+}
+
+// Tile group OBUs of 1 byte to 8 KiB, every other one with an extension header, as layered streams have.
+std::vector<uint8_t> makeOBUs(size_t const size) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(size + 8 * 1024 + 16);
+  uint32_t state = 0x9e3779b9u;
+  for(size_t i = 0; buffer.size() < size; ++i) {
+    state = state * 1664525u + 1013904223u;
+    size_t payloadSize = (state >> 8u) % (8u * 1024u) + 1u;
+    bool const extension = i % 2u == 1u;
+    buffer.emplace_back(static_cast<uint8_t>(4u << 3u | (extension ? 0x04u : 0u) | 0x02u));
+    if(extension) {
+      buffer.emplace_back(static_cast<uint8_t>((i % 8u) << 5u | (i % 4u) << 3u));
+    }
+    do {
+      uint8_t const byte = payloadSize & 0x7fu;
+      payloadSize >>= 7u;
+      buffer.emplace_back(payloadSize != 0 ? byte | 0x80u : byte);
+    } while(payloadSize != 0);
+    buffer.resize(buffer.size() + ((state >> 8u) % (8u * 1024u) + 1u), static_cast<uint8_t>(i));
+  }
+  return buffer;
+}
+
+}
+
+int main() {
+  using avif::av1::BitStreamReader;
+  avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::INFO);
+
+  std::vector<uint8_t> const noise = makeNoise(64 * 1024);
+  avif::bench::measure("readBits 1..8 over 64 KiB", [&]() {
+    BitStreamReader reader(log, noise);
+    uint32_t sum = 0;
+    for(uint8_t bits = 1; reader.posInBits() + 8 <= noise.size() * 8; bits = bits % 8u + 1u) {
+      sum += reader.readBits(bits);
+    }
+    avif::bench::doNotOptimize(sum);
+  });
+  avif::bench::measure("readUint 1..32 over 64 KiB", [&]() {
+    BitStreamReader reader(log, noise);
+    uint64_t sum = 0;
+    for(size_t bits = 1; reader.posInBits() + 32 <= noise.size() * 8; bits = bits % 32u + 1u) {
+      sum += reader.readUint(bits);
+    }
+    avif::bench::doNotOptimize(sum);
+  });
+
+  std::vector<uint8_t> const lebs = makeLEB128s(16 * 1024);
+  avif::bench::measure(fmt::format("readLEB128 x {}", 16 * 1024), [&]() {
+    BitStreamReader reader(log, lebs);
+    uint64_t sum = 0;
+    while(!reader.consumed()) {
+      sum += reader.readLEB128();
+    }
+    avif::bench::doNotOptimize(sum);
+  });
+
+  std::vector<uint8_t> const uvlcs = makeUVLCs(16 * 1024);
+  avif::bench::measure(fmt::format("readUVLC x {}", 16 * 1024), [&]() {
+    BitStreamReader reader(log, uvlcs);
+    uint64_t sum = 0;
+    for(size_t i = 0; i < 16 * 1024; ++i) {
+      sum += reader.readUVLC();
+    }
+    avif::bench::doNotOptimize(sum);
+  });
+
+  // The sequence header OBU of an av1C.
+  std::vector<uint8_t> const sequenceHeader = {0x0a, 0x0b, 0x20, 0x00, 0x00, 0x42, 0x6b, 0xbf, 0xbc, 0x6f, 0xff, 0xcc, 0x10};
+  avif::bench::measure("parse sequence header OBU", [&]() {
+    avif::av1::Parser parser(log, sequenceHeader);
+    auto const result = parser.parse();
+    avif::bench::doNotOptimize(result->ok());
+  });
+
+  std::vector<uint8_t> const obus = makeOBUs(16 * 1024 * 1024);
+  avif::bench::measure("scanOBUs over 16 MiB", [&]() {
+    size_t sum = 0;
+    for(avif::av1::OBU const& obu : avif::av1::scanOBUs(obus)) {
+      sum += obu.payloadSize + obu.temporalID;
+    }
+    avif::bench::doNotOptimize(sum);
+  });
+  avif::bench::measure("Parser::parse over 16 MiB", [&]() {
+    avif::av1::Parser parser(log, obus);
+    auto const result = parser.parse();
+    avif::bench::doNotOptimize(result->ok());
+  });
+  return 0;
+}
@@ -0,0 +1,44 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <fmt/format.h>
+
+namespace avif::bench {
+
+// Runs "f" repeatedly for about "budget" and prints the average time per run.
+template <typename F>
+double measure(std::string const& name, F&& f, std::chrono::milliseconds const budget = std::chrono::milliseconds(500)) {
+  using clock = std::chrono::steady_clock;
+  f(); // warm up
+  size_t runs = 0;
+  auto const beg = clock::now();
+  auto now = beg;
+  do {
+    f();
+    ++runs;
+    now = clock::now();
+  } while(now - beg < budget);
+  double const nsPerRun = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - beg).count()) / static_cast<double>(runs);
+  fmt::print("{:<48} {:>14.1f} us/run ({} runs)\n", name, nsPerRun / 1000.0, runs);
+  std::fflush(stdout);
+  return nsPerRun;
+}
+
+// Prevents the compiler from optimizing away the result.
+template <typename T>
+void doNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile T sink;
+  sink = value;
+#endif
+}
+
+}
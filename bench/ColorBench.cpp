@@ -0,0 +1,129 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <fmt/format.h>
+#include "../src/avif/img/Conversion.hpp"
+#include "Bench.hpp"
+
+namespace {
+
+char const* nameOf(avif::img::simd::InstructionSet const set) {
+  using avif::img::simd::InstructionSet;
+  switch(set) {
+    case InstructionSet::None: return "scalar";
+    case InstructionSet::SSE41: return "SSE4.1";
+    case InstructionSet::AVX2: return "AVX2";
+    case InstructionSet::NEON: return "NEON";
+  }
+  return "?";
+}
+
+template <uint8_t rgbBits>
+avif::img::Image<rgbBits> makeImage(uint32_t const width, uint32_t const height) {
+  auto img = avif::img::Image<rgbBits>::createEmptyImage(avif::img::PixelOrder::RGBA, width, height);
+  for(size_t i = 0; i < img.stride() * img.height(); ++i) {
+    img.data()[i] = static_cast<uint8_t>(i * 7u + i / 4093u);
+  }
+  return img;
+}
+
+// Runs "f" for each instruction set this CPU supports, and for the scalar templates.
+template <typename F>
+void measureEachInstructionSet(std::string const& name, F&& f) {
+  using avif::img::simd::InstructionSet;
+  using avif::img::simd::useInstructionSet;
+  using avif::img::simd::instructionSet;
+  for(auto const set : {InstructionSet::None, InstructionSet::SSE41, InstructionSet::AVX2, InstructionSet::NEON}) {
+    useInstructionSet(set);
+    if(instructionSet() != set) {
+      continue;
+    }
+    avif::bench::measure(fmt::format("{} [{}]", name, nameOf(set)), f);
+  }
+  useInstructionSet(avif::img::simd::detectInstructionSet());
+}
+
+template <uint8_t rgbBits, uint8_t yuvBits>
+void benchFromRGB(uint32_t const width, uint32_t const height) {
+  using Converter = avif::img::color::ColorConverter<avif::img::color::MatrixCoefficients::MC_BT_709>;
+  using FromRGB = avif::img::FromRGB<Converter, rgbBits, yuvBits, false, true>;
+  using YUVType = typename avif::img::color::YUV<yuvBits>::Type;
+  auto const src = makeImage<rgbBits>(width, height);
+  size_t const strideY = width * sizeof(YUVType);
+  size_t const strideC = (width + 1) / 2 * sizeof(YUVType);
+  std::vector<uint8_t> y(strideY * height), u(strideC * ((height + 1) / 2)), v(strideC * ((height + 1) / 2));
+  measureEachInstructionSet(fmt::format("FromRGB<{}, {}>::toI420 {}x{}", rgbBits, yuvBits, width, height), [&]() {
+    FromRGB::toI420(src, y.data(), strideY, u.data(), strideC, v.data(), strideC);
+    avif::bench::doNotOptimize(y.data());
+  });
+  avif::bench::measure(fmt::format("FromRGB<{}, {}>::toI420 {}x{} [fixed-point]", rgbBits, yuvBits, width, height), [&]() {
+    FromRGB::toI420(src, y.data(), strideY, u.data(), strideC, v.data(), strideC, avif::img::ConversionOptions{avif::img::Arithmetic::FixedPoint});
+    avif::bench::doNotOptimize(y.data());
+  });
+  avif::img::ConversionOptions box;
+  box.chromaDownsampling = avif::img::ChromaDownsampling::Box;
+  measureEachInstructionSet(fmt::format("FromRGB<{}, {}>::toI420 {}x{} [box]", rgbBits, yuvBits, width, height), [&]() {
+    FromRGB::toI420(src, y.data(), strideY, u.data(), strideC, v.data(), strideC, box);
+    avif::bench::doNotOptimize(u.data());
+  });
+}
+
+template <uint8_t rgbBits, uint8_t yuvBits>
+void benchToRGB(uint32_t const width, uint32_t const height) {
+  using Converter = avif::img::color::ColorConverter<avif::img::color::MatrixCoefficients::MC_BT_709>;
+  using ToRGB = avif::img::ToRGB<Converter, rgbBits, yuvBits, false, true>;
+  using YUVType = typename avif::img::color::YUV<yuvBits>::Type;
+  size_t const strideY = width * sizeof(YUVType);
+  size_t const strideC = (width + 1) / 2 * sizeof(YUVType);
+  std::vector<uint8_t> y(strideY * height), u(strideC * ((height + 1) / 2)), v(strideC * ((height + 1) / 2));
+  for(auto* plane : {&y, &u, &v}) {
+    auto* const samples = reinterpret_cast<YUVType*>(plane->data());
+    for(size_t i = 0; i < plane->size() / sizeof(YUVType); ++i) {
+      samples[i] = static_cast<YUVType>((i * 7u + i / 4093u) & ((1u << yuvBits) - 1u));
+    }
+  }
+  auto dst = avif::img::Image<rgbBits>::createEmptyImage(avif::img::PixelOrder::RGBA, width, height);
+  measureEachInstructionSet(fmt::format("ToRGB<{}, {}>::fromI420 {}x{}", rgbBits, yuvBits, width, height), [&]() {
+    ToRGB::fromI420(dst, y.data(), strideY, u.data(), strideC, v.data(), strideC);
+    avif::bench::doNotOptimize(dst.data());
+  });
+  avif::bench::measure(fmt::format("ToRGB<{}, {}>::fromI420 {}x{} [fixed-point]", rgbBits, yuvBits, width, height), [&]() {
+    ToRGB::fromI420(dst, y.data(), strideY, u.data(), strideC, v.data(), strideC, avif::img::ConversionOptions{avif::img::Arithmetic::FixedPoint});
+    avif::bench::doNotOptimize(dst.data());
+  });
+  avif::img::ConversionOptions bilinear;
+  bilinear.chromaUpsampling = avif::img::ChromaUpsampling::Bilinear;
+  measureEachInstructionSet(fmt::format("ToRGB<{}, {}>::fromI420 {}x{} [bilinear]", rgbBits, yuvBits, width, height), [&]() {
+    ToRGB::fromI420(dst, y.data(), strideY, u.data(), strideC, v.data(), strideC, bilinear);
+    avif::bench::doNotOptimize(dst.data());
+  });
+  avif::img::ConversionOptions parallel;
+  parallel.threads = 0;
+  avif::bench::measure(fmt::format("ToRGB<{}, {}>::fromI420 {}x{} [{} threads]", rgbBits, yuvBits, width, height, std::thread::hardware_concurrency()), [&]() {
+    ToRGB::fromI420(dst, y.data(), strideY, u.data(), strideC, v.data(), strideC, parallel);
+    avif::bench::doNotOptimize(dst.data());
+  });
+  if(yuvBits == 8) {
+    avif::bench::measure(fmt::format("ToRGB<{}, {}>::fromI420 {}x{} [lookup-table]", rgbBits, yuvBits, width, height), [&]() {
+      ToRGB::fromI420(dst, y.data(), strideY, u.data(), strideC, v.data(), strideC, avif::img::ConversionOptions{avif::img::Arithmetic::LookupTable});
+      avif::bench::doNotOptimize(dst.data());
+    });
+  }
+}
+
+}
+
+int main() {
+  fmt::print("Detected: {}\n", nameOf(avif::img::simd::detectInstructionSet()));
+  benchFromRGB<8, 8>(1920, 1080);
+  benchFromRGB<16, 10>(1920, 1080);
+  benchToRGB<8, 8>(1920, 1080);
+  benchToRGB<8, 8>(8192, 6144);
+  benchToRGB<16, 8>(1920, 1080);
+  benchToRGB<16, 10>(1920, 1080);
+  return 0;
+}
@@ -0,0 +1,132 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <cstdint>
+#include <algorithm>
+#include <fmt/format.h>
+#include "../src/avif/img/Image.hpp"
+#include "../src/avif/img/Crop.hpp"
+#include "../src/avif/img/Transform.hpp"
+#include "Bench.hpp"
+
+namespace {
+
+char const* nameOf(avif::img::simd::InstructionSet const set) {
+  using avif::img::simd::InstructionSet;
+  switch(set) {
+    case InstructionSet::None: return "scalar";
+    case InstructionSet::SSE41: return "SSE4.1";
+    case InstructionSet::AVX2: return "AVX2";
+    case InstructionSet::NEON: return "NEON";
+  }
+  return "?";
+}
+
+// Allocates a frame and writes every pixel, as a decoder does, then drops it.
+void benchCreateEmptyImage(char const* policyName, avif::img::AllocationPolicy const& policy, uint32_t const width, uint32_t const height) {
+  avif::bench::measure(fmt::format("createEmptyImage {}x{} [{}]", width, height, policyName), [&]() {
+    auto img = avif::img::Image<8>::createEmptyImage(avif::img::PixelOrder::RGBA, width, height, policy);
+    std::fill_n(img.data(), img.stride() * img.height(), static_cast<uint8_t>(0x80));
+    avif::bench::doNotOptimize(img.data());
+  });
+}
+
+// The former transform::fill: one source coordinate per destination pixel.
+template <typename Trans>
+void fillPerPixel(avif::img::Image<8> const& src, avif::img::Image<8>& dst) {
+  Trans trans;
+  size_t const bytesPerPixel = src.bytesPerPixel();
+  for(size_t y = 0; y < dst.height(); ++y) {
+    uint8_t* dstPixel = dst.data() + dst.stride() * y;
+    for(size_t x = 0; x < dst.width(); ++x, dstPixel += bytesPerPixel) {
+      auto const from = trans(src.width(), x, src.height(), y);
+      uint8_t const* srcPixel = src.data() + src.stride() * std::get<1>(from) + bytesPerPixel * std::get<0>(from);
+      std::copy(srcPixel, srcPixel + bytesPerPixel, dstPixel);
+    }
+  }
+}
+
+void benchTransform(avif::img::PixelOrder const pixelOrder, uint32_t const width, uint32_t const height) {
+  using avif::ImageRotationBox;
+  using avif::ImageMirrorBox;
+  using namespace avif::img;
+  auto src = Image<8>::createEmptyImage(pixelOrder, width, height);
+  for(size_t i = 0; i < src.stride() * src.height(); ++i) {
+    src.data()[i] = static_cast<uint8_t>(i * 7u + i / 4093u);
+  }
+  auto const bpp = src.bytesPerPixel();
+  auto rotated = Image<8>::createEmptyImage(pixelOrder, height, width);
+  avif::bench::measure(fmt::format("rotate90 {}x{}x{} [per-pixel]", width, height, bpp), [&]() {
+    fillPerPixel<transform::RotateTrans<ImageRotationBox::Rotation::Rot90>>(src, rotated);
+    avif::bench::doNotOptimize(rotated.data());
+  });
+  // Into the same image each time, so page faults of new allocations do not hide the copy.
+  for(auto const set : {simd::InstructionSet::None, simd::InstructionSet::SSE41, simd::InstructionSet::AVX2, simd::InstructionSet::NEON}) {
+    simd::useInstructionSet(set);
+    if(simd::instructionSet() != set) {
+      continue;
+    }
+    avif::bench::measure(fmt::format("rotate90 {}x{}x{} [tiled, {}]", width, height, bpp, nameOf(set)), [&]() {
+      transform::fill<8, transform::RotateTrans<ImageRotationBox::Rotation::Rot90>>(src, rotated);
+      avif::bench::doNotOptimize(rotated.data());
+    });
+  }
+  simd::useInstructionSet(simd::detectInstructionSet());
+  auto same = Image<8>::createEmptyImage(pixelOrder, width, height);
+  avif::bench::measure(fmt::format("rotate180 {}x{}x{}", width, height, bpp), [&]() {
+    transform::fill<8, transform::RotateTrans<ImageRotationBox::Rotation::Rot180>>(src, same);
+    avif::bench::doNotOptimize(same.data());
+  });
+  avif::bench::measure(fmt::format("flip horizontal {}x{}x{}", width, height, bpp), [&]() {
+    transform::fill<8, transform::FlipTrans<ImageMirrorBox::Axis::Horizontal>>(src, same);
+    avif::bench::doNotOptimize(same.data());
+  });
+}
+
+// clap, irot and imir of a camera image: crop a margin away, turn it upright and mirror it.
+void benchApplyTransforms(uint32_t const width, uint32_t const height) {
+  using avif::ImageRotationBox;
+  using avif::ImageMirrorBox;
+  using namespace avif::img;
+  auto src = Image<8>::createEmptyImage(PixelOrder::RGBA, width, height);
+  std::fill_n(src.data(), src.stride() * src.height(), static_cast<uint8_t>(0x80));
+  avif::CleanApertureBox clap{};
+  clap.cleanApertureWidthN = width - 64;
+  clap.cleanApertureWidthD = 1;
+  clap.cleanApertureHeightN = height - 64;
+  clap.cleanApertureHeightD = 1;
+  clap.horizOffN = 0;
+  clap.horizOffD = 1;
+  clap.vertOffN = 0;
+  clap.vertOffD = 1;
+  ImageRotationBox irot{};
+  irot.angle = ImageRotationBox::Rotation::Rot90;
+  ImageMirrorBox imir{};
+  imir.axis = ImageMirrorBox::Axis::Horizontal;
+  avif::bench::measure(fmt::format("clap+irot+imir {}x{} [one by one]", width, height), [&]() {
+    auto const dst = flip(rotate(crop(src, clap), irot.angle), imir.axis);
+    avif::bench::doNotOptimize(dst.data());
+  });
+  avif::bench::measure(fmt::format("clap+irot+imir {}x{} [fused]", width, height), [&]() {
+    auto const dst = applyTransforms(src, clap, irot, imir);
+    avif::bench::doNotOptimize(dst.data());
+  });
+}
+
+}
+
+int main() {
+  avif::img::AllocationPolicy pooled = avif::img::AllocationPolicy::uninitialized();
+  pooled.pooled = true;
+  for(auto const& [width, height] : {std::make_pair(1920u, 1080u), std::make_pair(7680u, 4320u)}) {
+    benchCreateEmptyImage("zero-filled", avif::img::AllocationPolicy{}, width, height);
+    benchCreateEmptyImage("uninitialized", avif::img::AllocationPolicy::uninitialized(), width, height);
+    benchCreateEmptyImage("pooled", pooled, width, height);
+  }
+  benchTransform(avif::img::PixelOrder::Mono, 7680, 4320);
+  benchTransform(avif::img::PixelOrder::MonoA, 7680, 4320);
+  benchTransform(avif::img::PixelOrder::RGBA, 7680, 4320);
+  benchApplyTransforms(7680, 4320);
+  return 0;
+}
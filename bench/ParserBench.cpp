@@ -0,0 +1,126 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <fmt/format.h>
+#include "../src/avif/Parser.hpp"
+#include "../src/avif/Writer.hpp"
+#include "../src/avif/util/StreamWriter.hpp"
+#include "../src/avif/util/StreamReader.hpp"
+#include "../src/avif/util/FileLogger.hpp"
+#include "Bench.hpp"
+
+namespace {
+
+// A grid image with a lot of tiles has large 'iloc' and 'ipma' tables.
+std::vector<uint8_t> makeFileWithManyItems(avif::util::Logger& log, uint32_t const numItems) {
+  using namespace avif;
+  FileBox fileBox{};
+  fileBox.fileTypeBox.majorBrand = "avif";
+  fileBox.fileTypeBox.minorVersion = 0;
+  fileBox.fileTypeBox.compatibleBrands = {"avif", "mif1", "miaf"};
+  MetaBox& meta = fileBox.metaBox;
+  meta.handlerBox.handler = "pict";
+  meta.itemLocationBox.setFullBoxHeader(2, 0);
+  meta.itemLocationBox.offsetSize = 4;
+  meta.itemLocationBox.lengthSize = 4;
+  meta.itemLocationBox.baseOffsetSize = 4;
+  meta.itemLocationBox.indexSize = 0;
+  meta.itemInfoBox.setFullBoxHeader(1, 0);
+  ImageSpatialExtentsProperty ispe{};
+  ispe.imageWidth = 512;
+  ispe.imageHeight = 512;
+  meta.itemPropertiesBox.propertyContainers.properties.emplace_back(ispe);
+  PixelInformationProperty pixi{};
+  pixi.bitsPerChannel = {8, 8, 8};
+  meta.itemPropertiesBox.propertyContainers.properties.emplace_back(pixi);
+  ItemPropertyAssociation ipma{};
+  ipma.setFullBoxHeader(1, 1);
+  for(uint32_t id = 1; id <= numItems; ++id) {
+    meta.itemLocationBox.items.emplace_back(ItemLocationBox::Item{id, 0, 0, 0, {
+        ItemLocationBox::Item::Extent{0, id * 16, 8},
+        ItemLocationBox::Item::Extent{0, id * 16 + 8, 8},
+    }});
+    ItemInfoEntry infe{};
+    infe.setFullBoxHeader(3, 0);
+    infe.itemID = id;
+    infe.itemType = "av01";
+    meta.itemInfoBox.itemInfos.emplace_back(infe);
+    ipma.items.emplace_back(ItemPropertyAssociation::Item{id, {{true, 1}, {false, 2}}});
+  }
+  meta.itemPropertiesBox.associations.emplace_back(ipma);
+  MediaDataBox mdat{};
+  mdat.size = numItems * 16 + 16;
+  fileBox.mediaDataBoxes.emplace_back(mdat);
+  {
+    util::StreamWriter out;
+    Writer(log, out).write(fileBox);
+  }
+  util::StreamWriter out;
+  Writer(log, out).write(fileBox);
+  return out.buffer();
+}
+
+// How StreamReader used to read: std::vector::at() for every byte.
+uint32_t readU32ByteByByte(std::vector<uint8_t> const& buff, size_t& pos) {
+  uint32_t const res =
+      static_cast<uint32_t>(buff.at(pos + 0)) << 24u |
+      static_cast<uint32_t>(buff.at(pos + 1)) << 16u |
+      static_cast<uint32_t>(buff.at(pos + 2)) << 8u |
+      static_cast<uint32_t>(buff.at(pos + 3)) << 0u;
+  pos += 4;
+  return res;
+}
+
+}
+
+int main() {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::ERROR);
+
+  {
+    std::vector<uint8_t> words(1u << 20u);
+    for(size_t i = 0; i < words.size(); ++i) {
+      words[i] = static_cast<uint8_t>(i * 31u);
+    }
+    avif::bench::measure("readU32 via vector::at() per byte (1MiB)", [&]() {
+      size_t pos = 0;
+      uint32_t sum = 0;
+      while(pos < words.size()) {
+        sum += readU32ByteByByte(words, pos);
+      }
+      avif::bench::doNotOptimize(sum);
+    });
+    avif::bench::measure("StreamReader::readU32 (1MiB)", [&]() {
+      avif::util::StreamReader reader(log, words);
+      uint32_t sum = 0;
+      while(!reader.consumed()) {
+        sum += reader.readU32();
+      }
+      avif::bench::doNotOptimize(sum);
+    });
+    avif::bench::measure("StreamReader::readU32Unchecked (1MiB)", [&]() {
+      avif::util::StreamReader reader(log, words);
+      reader.require(words.size());
+      uint32_t sum = 0;
+      for(size_t i = 0; i < words.size(); i += 4) {
+        sum += reader.readU32Unchecked();
+      }
+      avif::bench::doNotOptimize(sum);
+    });
+  }
+  for(uint32_t const numItems : {1000u, 20000u}) {
+    std::vector<uint8_t> const file = makeFileWithManyItems(log, numItems);
+    avif::bench::measure(fmt::format("Parser::parse with {} items ({} bytes)", numItems, file.size()), [&]() {
+      avif::Parser parser(log, file.data(), file.size());
+      auto const result = parser.parse();
+      if(!result->ok()) {
+        throw std::runtime_error(result->error());
+      }
+      avif::bench::doNotOptimize(result->fileBox().metaBox.itemLocationBox.items.size());
+    });
+  }
+  return 0;
+}
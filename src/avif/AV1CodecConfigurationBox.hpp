@@ -6,6 +6,7 @@
 
 #include <vector>
 #include "Box.hpp"
+#include "util/Buffer.hpp"
 
 namespace avif {
 
@@ -26,7 +27,8 @@ struct AV1CodecConfigurationRecord {
   bool initialPresentationDelayPresent;
   uint8_t initialPresentationDelay;
 
-  std::vector<uint8_t> configOBUs;
+  // Refers to the parsed file. Use toVector() to own a copy.
+  util::Buffer configOBUs;
 };
 
 struct AV1CodecConfigurationRecordBox : public Box {
@@ -8,12 +8,13 @@
 #include <string>
 #include <vector>
 #include "FullBox.hpp"
+#include "util/Buffer.hpp"
 
 namespace avif {
 
 struct AuxiliaryTypeProperty : public FullBox {
   std::string auxType{};
-  std::vector<uint8_t> auxSubtype{};
+  util::Buffer auxSubtype{}; // Refers to the parsed file.
 };
 
 }
\ No newline at end of file
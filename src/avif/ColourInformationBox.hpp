@@ -3,6 +3,7 @@
 #include <variant>
 #include <vector>
 #include "Box.hpp"
+#include "util/Buffer.hpp"
 
 namespace avif {
 
@@ -15,11 +16,12 @@ struct ColourInformationBox final : public Box {
     uint16_t matrixCoefficients = 5 /* or 6 */;
     bool fullRangeFlag = true;
   };
+  // The payloads refer to the parsed file. Use toVector() to own a copy.
   struct RestrictedICC {
-    std::vector<uint8_t> payload;
+    util::Buffer payload;
   };
   struct UnrestrictedICC {
-    std::vector<uint8_t> payload;
+    util::Buffer payload;
   };
   std::variant<std::monostate, CICP, RestrictedICC, UnrestrictedICC> profile;
 };
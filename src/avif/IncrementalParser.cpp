@@ -0,0 +1,176 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <algorithm>
+#include "IncrementalParser.hpp"
+#include "util/FourCC.hpp"
+
+using avif::util::str2uint;
+using avif::util::uint2str;
+
+namespace avif {
+
+IncrementalParser::IncrementalParser(util::Logger& log, Listener& listener, size_t const bufferLimit)
+:log_(log)
+,listener_(listener)
+,bufferLimit_(bufferLimit)
+{
+}
+
+bool IncrementalParser::feed(uint8_t const* data, size_t size) {
+  try {
+    while(size > 0 && this->state_ != State::Failed) {
+      size_t used = 0;
+      switch(this->state_) {
+        case State::Header:
+          used = this->feedHeader(data, size);
+          break;
+        case State::Buffering:
+        case State::Skipping:
+          used = this->feedPayload(data, size);
+          break;
+        case State::Failed:
+          break;
+      }
+      data += used;
+      size -= used;
+      this->offset_ += used;
+      if(this->state_ != State::Header && !this->untilEnd_ && this->offset_ == this->hdr_.end()) {
+        this->completeBox();
+      }
+    }
+  } catch(Parser::Error& err) {
+    this->fail(std::move(err));
+  } catch(std::exception& err) {
+    this->fail(Parser::Error(err));
+  }
+  return this->ok();
+}
+
+bool IncrementalParser::finish() {
+  if(this->state_ == State::Failed) {
+    return false;
+  }
+  if(this->state_ == State::Header) {
+    if(this->headSize_ == 0) {
+      return true;
+    }
+    this->fail(Parser::Error("File truncated: box header from {} is incomplete at {}.", this->offset_ - this->headSize_, this->offset_));
+    return false;
+  }
+  if(this->untilEnd_) {
+    try {
+      this->hdr_.size = this->offset_ - this->hdr_.offset;
+      this->untilEnd_ = false;
+      this->completeBox();
+    } catch(Parser::Error& err) {
+      this->fail(std::move(err));
+    } catch(std::exception& err) {
+      this->fail(Parser::Error(err));
+    }
+    return this->ok();
+  }
+  this->fail(Parser::Error("File truncated: {} box from {} is incomplete at {}.", uint2str(this->hdr_.type), this->hdr_.offset, this->offset_));
+  return false;
+}
+
+size_t IncrementalParser::feedHeader(uint8_t const* const data, size_t const size) {
+  size_t const used = std::min(sizeof(this->head_) - this->headSize_, size);
+  std::copy(data, data + used, this->head_ + this->headSize_);
+  this->headSize_ += used;
+  if(this->headSize_ == sizeof(this->head_)) {
+    this->hdr_.offset = this->offset_ + used - sizeof(this->head_);
+    this->hdr_.size =
+        static_cast<uint32_t>(head_[0]) << 24u | static_cast<uint32_t>(head_[1]) << 16u |
+        static_cast<uint32_t>(head_[2]) << 8u | static_cast<uint32_t>(head_[3]) << 0u;
+    this->hdr_.type =
+        static_cast<uint32_t>(head_[4]) << 24u | static_cast<uint32_t>(head_[5]) << 16u |
+        static_cast<uint32_t>(head_[6]) << 8u | static_cast<uint32_t>(head_[7]) << 0u;
+    this->headSize_ = 0;
+    this->beginBox();
+  }
+  return used;
+}
+
+size_t IncrementalParser::feedPayload(uint8_t const* const data, size_t const size) {
+  size_t const used = this->untilEnd_ ? size : std::min(this->hdr_.end() - this->offset_, size);
+  if(this->state_ == State::Buffering) {
+    if(this->box_.size() + used > this->bufferLimit_) {
+      throw Parser::Error("{} box from {} exceeds the buffering limit of {} bytes.", uint2str(this->hdr_.type), this->hdr_.offset, this->bufferLimit_);
+    }
+    // The box grows as its bytes arrive: its size field alone is not trusted enough to allocate for.
+    this->box_.insert(this->box_.end(), data, data + used);
+  }
+  return used;
+}
+
+void IncrementalParser::beginBox() {
+  if(this->hdr_.size == 1) {
+    throw Parser::Error("LargeSize box is not supported.");
+  }
+  this->untilEnd_ = this->hdr_.size == 0;
+  if(!this->untilEnd_ && this->hdr_.size < sizeof(this->head_)) {
+    throw Parser::Error("File corrupted. Detected at {} box, from {} with size = {}.", uint2str(this->hdr_.type), this->hdr_.offset, this->hdr_.size);
+  }
+  switch(this->hdr_.type) {
+    case str2uint("ftyp"):
+    case str2uint("meta"):
+      if(!this->untilEnd_ && this->hdr_.size > this->bufferLimit_) {
+        throw Parser::Error("{} box from {} with size = {} exceeds the buffering limit of {} bytes.", uint2str(this->hdr_.type), this->hdr_.offset, this->hdr_.size, this->bufferLimit_);
+      }
+      this->state_ = State::Buffering;
+      this->box_.clear();
+      this->box_.insert(this->box_.end(), std::begin(this->head_), std::end(this->head_));
+      break;
+    case str2uint("mdat"):
+    case str2uint("free"):
+    case str2uint("skip"):
+      this->state_ = State::Skipping;
+      break;
+    default:
+      log().warn("Unknown box type={}(=0x{:x}) with size={}({}~{})", uint2str(this->hdr_.type), this->hdr_.type, this->hdr_.size, this->hdr_.offset, this->hdr_.end());
+      this->state_ = State::Skipping;
+      break;
+  }
+  if(!this->untilEnd_ && this->hdr_.size == sizeof(this->head_)) {
+    this->completeBox();
+  }
+}
+
+void IncrementalParser::completeBox() {
+  Box::Header const hdr = this->hdr_;
+  State const state = this->state_;
+  this->state_ = State::Header;
+  if(state == State::Buffering) {
+    Parser parser(log(), util::Buffer(std::move(this->box_)), hdr.offset);
+    this->box_ = std::vector<uint8_t>();
+    std::shared_ptr<Parser::Result> const result = parser.parse();
+    if(!result->ok()) {
+      throw Parser::Error(result->error());
+    }
+    this->buffers_.emplace_back(result->buffer());
+    if(hdr.type == str2uint("ftyp")) {
+      this->fileBox_.fileTypeBox = result->fileBox().fileTypeBox;
+      this->listener_.onFileTypeBox(this->fileBox_.fileTypeBox);
+    } else {
+      this->fileBox_.metaBox = result->fileBox().metaBox;
+      this->listener_.onMetaBox(this->fileBox_.metaBox);
+      this->listener_.onItemLocationBox(this->fileBox_.metaBox.itemLocationBox);
+    }
+  } else if(hdr.type == str2uint("mdat")) {
+    MediaDataBox mdat{};
+    mdat.hdr = hdr;
+    mdat.offset = hdr.offset + sizeof(this->head_);
+    mdat.size = hdr.size - sizeof(this->head_);
+    this->fileBox_.mediaDataBoxes.emplace_back(mdat);
+    this->listener_.onMediaDataBox(this->fileBox_.mediaDataBoxes.back());
+  }
+}
+
+void IncrementalParser::fail(Parser::Error&& err) {
+  this->state_ = State::Failed;
+  this->error_ = std::move(err);
+}
+
+}
@@ -0,0 +1,96 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <string>
+
+#include "util/Logger.hpp"
+#include "util/Buffer.hpp"
+#include "Parser.hpp"
+#include "FileBox.hpp"
+
+namespace avif {
+
+// Push-style parser for files arriving chunk by chunk.
+// 'ftyp' and 'meta' are buffered until they are complete, then parsed by avif::Parser.
+// The payloads of 'mdat' and the other boxes are never buffered.
+class IncrementalParser final {
+public:
+  // 'ftyp' or 'meta' larger than this fails the stream, instead of being buffered.
+  constexpr static size_t DEFAULT_BUFFER_LIMIT = 16u * 1024u * 1024u;
+
+  class Listener {
+  public:
+    Listener() = default;
+    Listener(Listener const&) = delete;
+    Listener(Listener&&) = delete;
+    Listener& operator=(Listener const&) = delete;
+    Listener& operator=(Listener&&) = delete;
+    virtual ~Listener() noexcept = default;
+  public:
+    virtual void onFileTypeBox(FileTypeBox const& /* box */) {}
+    virtual void onMetaBox(MetaBox const& /* box */) {}
+    virtual void onItemLocationBox(ItemLocationBox const& /* box */) {}
+    virtual void onMediaDataBox(MediaDataBox const& /* box */) {}
+  };
+
+private:
+  enum class State {
+    Header,
+    Buffering,
+    Skipping,
+    Failed,
+  };
+  util::Logger& log_;
+  Listener& listener_;
+  size_t const bufferLimit_;
+private: // intermediate states
+  State state_ = State::Header;
+  size_t offset_ = 0; // Bytes fed so far.
+  uint8_t head_[8] = {};
+  size_t headSize_ = 0;
+  Box::Header hdr_{};
+  bool untilEnd_ = false; // The current box lasts until the end of file (size = 0).
+  std::vector<uint8_t> box_{};
+private: // parsed results
+  FileBox fileBox_{};
+  std::vector<util::Buffer> buffers_{};
+  std::optional<Parser::Error> error_{};
+
+public:
+  IncrementalParser() = delete;
+  IncrementalParser(IncrementalParser&&) = delete;
+  IncrementalParser(IncrementalParser const&) = delete;
+  IncrementalParser& operator=(IncrementalParser&&) = delete;
+  IncrementalParser& operator=(IncrementalParser const&) = delete;
+  ~IncrementalParser() noexcept = default;
+
+public: //entry point
+  IncrementalParser(util::Logger& log, Listener& listener, size_t bufferLimit = DEFAULT_BUFFER_LIMIT);
+  // Returns false once the stream turns out to be broken. See error().
+  bool feed(uint8_t const* data, size_t size);
+  // Tells the end of the stream. Returns false when the last box is truncated.
+  bool finish();
+
+public: // getters
+  [[nodiscard]] util::Logger& log() { return this->log_; }
+  [[nodiscard]] bool ok() const { return !this->error_.has_value(); }
+  [[nodiscard]] std::string error() const { return this->error_.has_value() ? this->error_->msg() : "<no-error>"; }
+  [[nodiscard]] size_t consumed() const { return this->offset_; }
+  // Boxes parsed so far. Payloads referred from here are kept alive by this parser.
+  [[nodiscard]] FileBox const& fileBox() const { return this->fileBox_; }
+
+private:
+  size_t feedHeader(uint8_t const* data, size_t size);
+  size_t feedPayload(uint8_t const* data, size_t size);
+  void beginBox();
+  void completeBox();
+  void fail(Parser::Error&& err);
+};
+
+}
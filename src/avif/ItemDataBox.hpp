@@ -0,0 +1,20 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include "Box.hpp"
+#include "util/Buffer.hpp"
+
+namespace avif {
+
+// ISO/IEC 14496-12:2015(E)
+// 8.11.11 Item Data Box
+// Items with construction_method = 1 refer to this box.
+struct ItemDataBox : public Box {
+  size_t offset; // Where the data begins in the file.
+  util::Buffer data; // Refers to the parsed file.
+};
+
+}
@@ -0,0 +1,151 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <algorithm>
+#include <variant>
+#include "ItemIndex.hpp"
+
+namespace avif {
+
+namespace {
+
+template <typename T>
+ItemIndex::Range<T> rangeOf(std::vector<T> const& vec, std::pair<typename std::vector<T>::const_iterator, typename std::vector<T>::const_iterator> const& range) {
+  return ItemIndex::Range<T>(vec.data() + (range.first - vec.begin()), vec.data() + (range.second - vec.begin()));
+}
+
+}
+
+ItemIndex::ItemIndex(FileBox const& fileBox)
+:fileBox_(&fileBox)
+{
+  MetaBox const& meta = fileBox.metaBox;
+  auto const byID = [](Entry const& a, uint32_t const itemID) { return a.itemID < itemID; };
+
+  // Every item mentioned in infe, iloc or ipma gets an entry.
+  std::vector<uint32_t> ids;
+  ids.reserve(meta.itemInfoBox.itemInfos.size() + meta.itemLocationBox.items.size());
+  for(ItemInfoEntry const& info : meta.itemInfoBox.itemInfos) {
+    ids.emplace_back(info.itemID);
+  }
+  for(ItemLocationBox::Item const& item : meta.itemLocationBox.items) {
+    ids.emplace_back(item.itemID);
+  }
+  for(ItemPropertyAssociation const& assoc : meta.itemPropertiesBox.associations) {
+    for(ItemPropertyAssociation::Item const& item : assoc.items) {
+      ids.emplace_back(item.itemID);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  this->entries_.reserve(ids.size());
+  for(uint32_t const id : ids) {
+    this->entries_.emplace_back(Entry{id, nullptr, nullptr, 0, 0, 0, false});
+  }
+  auto const entryOf = [&](uint32_t const itemID) -> Entry& {
+    return *std::lower_bound(this->entries_.begin(), this->entries_.end(), itemID, byID);
+  };
+
+  // The first box wins when an item appears more than once.
+  for(ItemInfoEntry const& info : meta.itemInfoBox.itemInfos) {
+    Entry& entry = entryOf(info.itemID);
+    if(entry.info == nullptr) {
+      entry.info = &info;
+    }
+  }
+  for(ItemLocationBox::Item const& item : meta.itemLocationBox.items) {
+    Entry& entry = entryOf(item.itemID);
+    if(entry.location == nullptr) {
+      entry.location = &item;
+    }
+  }
+
+  // Properties: count per item first, then fill the flat table in ipma order.
+  auto const& props = meta.itemPropertiesBox.propertyContainers.properties;
+  for(ItemPropertyAssociation const& assoc : meta.itemPropertiesBox.associations) {
+    for(ItemPropertyAssociation::Item const& item : assoc.items) {
+      Entry& entry = entryOf(item.itemID);
+      for(ItemPropertyAssociation::Item::Entry const& e : item.entries) {
+        if(e.propertyIndex == 0) {
+          continue;
+        }
+        if(e.propertyIndex > props.size()) {
+          entry.invalidProperties++;
+          entry.invalidEssentialProperty = entry.invalidEssentialProperty || e.essential;
+          continue;
+        }
+        entry.propertiesEnd++;
+      }
+    }
+  }
+  uint32_t total = 0;
+  for(Entry& entry : this->entries_) {
+    uint32_t const count = entry.propertiesEnd;
+    entry.propertiesBegin = total;
+    entry.propertiesEnd = total;
+    total += count;
+  }
+  this->properties_.resize(total);
+  for(ItemPropertyAssociation const& assoc : meta.itemPropertiesBox.associations) {
+    for(ItemPropertyAssociation::Item const& item : assoc.items) {
+      Entry& entry = entryOf(item.itemID);
+      for(ItemPropertyAssociation::Item::Entry const& e : item.entries) {
+        if(e.propertyIndex == 0 || e.propertyIndex > props.size()) {
+          continue;
+        }
+        this->properties_[entry.propertiesEnd++] = Property{e.essential, &props[e.propertyIndex - 1]};
+      }
+    }
+  }
+
+  // References
+  if(meta.itemReferenceBox.has_value()) {
+    std::visit([&](auto const& refs) {
+      for(auto const& ref : refs) {
+        for(auto const& toItemID : ref.toItemIDs) {
+          this->outgoing_.emplace_back(Reference{ref.hdr.type, ref.fromItemID, toItemID});
+        }
+      }
+    }, meta.itemReferenceBox->references);
+    this->incoming_ = this->outgoing_;
+    std::stable_sort(this->outgoing_.begin(), this->outgoing_.end(), [](Reference const& a, Reference const& b) {
+      return a.fromItemID < b.fromItemID;
+    });
+    std::stable_sort(this->incoming_.begin(), this->incoming_.end(), [](Reference const& a, Reference const& b) {
+      return a.toItemID < b.toItemID;
+    });
+  }
+}
+
+ItemIndex::Entry const* ItemIndex::find(uint32_t const itemID) const {
+  auto const it = std::lower_bound(this->entries_.begin(), this->entries_.end(), itemID, [](Entry const& a, uint32_t const id) {
+    return a.itemID < id;
+  });
+  if(it == this->entries_.end() || it->itemID != itemID) {
+    return nullptr;
+  }
+  return &(*it);
+}
+
+ItemIndex::Range<ItemIndex::Property> ItemIndex::properties(uint32_t const itemID) const {
+  Entry const* const entry = this->find(itemID);
+  if(entry == nullptr) {
+    return Range<Property>(nullptr, nullptr);
+  }
+  return Range<Property>(this->properties_.data() + entry->propertiesBegin, this->properties_.data() + entry->propertiesEnd);
+}
+
+ItemIndex::Range<ItemIndex::Reference> ItemIndex::outgoingReferences(uint32_t const itemID) const {
+  return rangeOf(this->outgoing_, std::equal_range(this->outgoing_.begin(), this->outgoing_.end(), Reference{0, itemID, 0}, [](Reference const& a, Reference const& b) {
+    return a.fromItemID < b.fromItemID;
+  }));
+}
+
+ItemIndex::Range<ItemIndex::Reference> ItemIndex::incomingReferences(uint32_t const itemID) const {
+  return rangeOf(this->incoming_, std::equal_range(this->incoming_.begin(), this->incoming_.end(), Reference{0, 0, itemID}, [](Reference const& a, Reference const& b) {
+    return a.toItemID < b.toItemID;
+  }));
+}
+
+}
@@ -0,0 +1,98 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include "FileBox.hpp"
+
+namespace avif {
+
+// Per-item lookup table built once from a FileBox.
+// Items are sorted by itemID, and their properties and references are stored in flat arrays,
+// so each lookup is a binary search instead of a scan over all boxes.
+// It refers to the boxes of the FileBox, which must outlive the index.
+class ItemIndex final {
+public:
+  template <typename T>
+  class Range final {
+  private:
+    T const* begin_;
+    T const* end_;
+  public:
+    Range(T const* const begin, T const* const end) noexcept
+    :begin_(begin)
+    ,end_(end)
+    {
+    }
+    [[nodiscard]] T const* begin() const noexcept { return this->begin_; }
+    [[nodiscard]] T const* end() const noexcept { return this->end_; }
+    [[nodiscard]] size_t size() const noexcept { return static_cast<size_t>(this->end_ - this->begin_); }
+    [[nodiscard]] bool empty() const noexcept { return this->begin_ == this->end_; }
+  };
+  struct Property {
+    bool essential;
+    ItemPropertyContainer::Property const* property;
+  };
+  struct Reference {
+    uint32_t type; // 4CC like 'auxl', 'thmb' or 'dimg'.
+    uint32_t fromItemID;
+    uint32_t toItemID;
+  };
+  struct Entry {
+    uint32_t itemID;
+    ItemInfoEntry const* info;
+    ItemLocationBox::Item const* location;
+    // [propertiesBegin, propertiesEnd) of the flat property table.
+    uint32_t propertiesBegin;
+    uint32_t propertiesEnd;
+    // ipma entries of the item pointing out of 'ipco'. They are left out of the property table.
+    uint32_t invalidProperties;
+    // Whether any of them is marked essential: then the item must not be processed, as ISO/IEC 23008-12 requires.
+    // The queries of Query.hpp which pick an item by themselves skip it.
+    bool invalidEssentialProperty;
+  };
+
+private:
+  FileBox const* fileBox_;
+  std::vector<Entry> entries_{};
+  std::vector<Property> properties_{};
+  std::vector<Reference> outgoing_{}; // sorted by fromItemID
+  std::vector<Reference> incoming_{}; // sorted by toItemID
+
+public:
+  ItemIndex() = delete;
+  ItemIndex(ItemIndex const&) = delete;
+  ItemIndex(ItemIndex&&) = default;
+  ItemIndex& operator=(ItemIndex const&) = delete;
+  ItemIndex& operator=(ItemIndex&&) = default;
+  explicit ItemIndex(FileBox const& fileBox);
+  ~ItemIndex() noexcept = default;
+
+public:
+  [[nodiscard]] FileBox const& fileBox() const { return *this->fileBox_; }
+  [[nodiscard]] Entry const* find(uint32_t itemID) const;
+  [[nodiscard]] std::vector<Entry> const& entries() const { return this->entries_; }
+  // Properties associated to the item, in the order of the ipma entries.
+  [[nodiscard]] Range<Property> properties(uint32_t itemID) const;
+  // References from the item.
+  [[nodiscard]] Range<Reference> outgoingReferences(uint32_t itemID) const;
+  // References to the item.
+  [[nodiscard]] Range<Reference> incomingReferences(uint32_t itemID) const;
+
+public:
+  template <typename T>
+  [[nodiscard]] T const* findProperty(uint32_t const itemID) const {
+    for(Property const& prop : this->properties(itemID)) {
+      if(std::holds_alternative<T>(*prop.property)) {
+        return &std::get<T>(*prop.property);
+      }
+    }
+    return nullptr;
+  }
+};
+
+}
@@ -14,6 +14,7 @@
 #include "ItemInfoBox.hpp"
 #include "PrimaryItemBox.hpp"
 #include "ItemReferenceBox.hpp"
+#include "ItemDataBox.hpp"
 
 namespace avif {
 
@@ -24,6 +25,7 @@ struct MetaBox final : public FullBox {
   std::optional<PrimaryItemBox> primaryItemBox{};
   ItemInfoBox itemInfoBox{};
   std::optional<ItemReferenceBox> itemReferenceBox{};
+  std::optional<ItemDataBox> itemDataBox{};
 };
 
 }
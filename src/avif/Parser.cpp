@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <string>
 #include <memory>
+#include <algorithm>
 
 #include <fmt/format.h>
 #include "util/Logger.hpp"
@@ -26,13 +27,28 @@ constexpr uint32_t boxType(const char *str) {
 //-----------------------------------------------------------------------------
 
 Parser::Parser(util::Logger& log, std::vector<uint8_t> buff)
+:Parser(log, util::Buffer(std::move(buff)))
+{
+}
+
+Parser::Parser(util::Logger& log, util::Buffer buff)
+:Parser(log, std::move(buff), 0)
+{
+}
+
+Parser::Parser(util::Logger& log, util::Buffer buff, size_t const offset)
 :log_(log)
 ,buffer_(std::move(buff))
-,reader_(log, buffer_)
+,reader_(log, buffer_.data(), buffer_.size(), offset)
 ,fileBox_()
 {
 }
 
+Parser::Parser(util::Logger& log, uint8_t const* const data, size_t const size)
+:Parser(log, util::Buffer(data, size))
+{
+}
+
 std::shared_ptr<Parser::Result> Parser::parse() {
   if(this->result_) {
     return this->result_;
@@ -50,6 +66,95 @@ std::shared_ptr<Parser::Result> Parser::parse() {
   return this->result_;
 }
 
+std::shared_ptr<Parser::ProbeResult> Parser::probe(util::Logger& log, RangeReader const& reader) {
+  try {
+    FileBox fileBox{};
+    std::vector<util::Buffer> buffers;
+    size_t offset = 0;
+    while(true) {
+      uint8_t head[8] = {};
+      if(reader(offset, sizeof(head), head) < sizeof(head)) {
+        return std::make_shared<ProbeResult>(ProbeResult::NeedMoreData{offset + sizeof(head)});
+      }
+      uint32_t const size =
+          static_cast<uint32_t>(head[0]) << 24u | static_cast<uint32_t>(head[1]) << 16u |
+          static_cast<uint32_t>(head[2]) << 8u | static_cast<uint32_t>(head[3]) << 0u;
+      uint32_t const type =
+          static_cast<uint32_t>(head[4]) << 24u | static_cast<uint32_t>(head[5]) << 16u |
+          static_cast<uint32_t>(head[6]) << 8u | static_cast<uint32_t>(head[7]) << 0u;
+      if(size == 1) {
+        throw Error("LargeSize box is not supported.");
+      }
+      if(size == 0) {
+        throw Error("{} box at {} lasts until the end of file, but 'meta' has not been found yet.", uint2str(type), offset);
+      }
+      if(size < sizeof(head)) {
+        throw Error("File corrupted. Detected at {} box, from {} with size = {}.", uint2str(type), offset, size);
+      }
+      switch(type) {
+        case boxType("ftyp"):
+        case boxType("meta"): {
+          // The size is not trusted until the bytes are actually there, so the buffer grows as they are read.
+          std::vector<uint8_t> data;
+          size_t chunk = 64u * 1024u;
+          while(data.size() < size) {
+            size_t const beg = data.size();
+            data.resize(beg + std::min<size_t>(chunk, size - beg));
+            size_t const len = data.size() - beg;
+            if(reader(offset + beg, len, data.data() + beg) < len) {
+              return std::make_shared<ProbeResult>(ProbeResult::NeedMoreData{offset + size});
+            }
+            chunk *= 2;
+          }
+          Parser parser(log, util::Buffer(std::move(data)), offset);
+          std::shared_ptr<Result> const result = parser.parse();
+          if(!result->ok()) {
+            throw Error(result->error());
+          }
+          buffers.emplace_back(result->buffer());
+          if(type == boxType("ftyp")) {
+            fileBox.fileTypeBox = result->fileBox().fileTypeBox;
+            break;
+          }
+          fileBox.metaBox = result->fileBox().metaBox;
+          return std::make_shared<ProbeResult>(std::move(buffers), std::move(fileBox));
+        }
+        case boxType("mdat"): {
+          MediaDataBox mdat{};
+          mdat.hdr.offset = offset;
+          mdat.hdr.size = size;
+          mdat.hdr.type = type;
+          mdat.offset = offset + sizeof(head);
+          mdat.size = size - sizeof(head);
+          fileBox.mediaDataBoxes.emplace_back(mdat);
+          break;
+        }
+        default:
+          // We do not have to read the others to decide how to handle the image.
+          break;
+      }
+      offset += size;
+    }
+  } catch(Parser::Error& err) {
+    return std::make_shared<ProbeResult>(std::move(err));
+  } catch(std::exception& err) {
+    return std::make_shared<ProbeResult>(Parser::Error(err));
+  } catch(...) {
+    return std::make_shared<ProbeResult>(Parser::Error("Unknwon error"));
+  }
+}
+
+std::shared_ptr<Parser::ProbeResult> Parser::probe(util::Logger& log, util::Buffer const& prefix) {
+  return Parser::probe(log, [&prefix](size_t const offset, size_t const size, uint8_t* const dst) -> size_t {
+    if(offset >= prefix.size()) {
+      return 0;
+    }
+    size_t const len = std::min(size, prefix.size() - offset);
+    std::copy(std::next(prefix.begin(), offset), std::next(prefix.begin(), offset + len), dst);
+    return len;
+  });
+}
+
 void Parser::parseFile() {
   while(!this->consumed()) {
     this->parseBoxInFile();
@@ -108,6 +213,7 @@ void Parser::parseFileTypeBox(FileTypeBox& box, size_t const end) {
     throw Error("We currently just support version 0(!={})", minorVersion);
   }
   std::vector<std::string> compatibleBrands;
+  compatibleBrands.reserve(this->pos() < end ? (end - this->pos()) / 4 : 0);
   while(this->pos() < end) {
     uint32_t const compatBrand = readU32();
     compatibleBrands.emplace_back(uint2str(compatBrand));
@@ -168,6 +274,15 @@ void Parser::parseBoxInMeta(MetaBox& box, size_t const endOfBox) {
       box.itemReferenceBox = iref;
       break;
     }
+    case boxType("idat"): {
+      // 8.11.11 Item Data Box
+      // See: ISOBMFF p.86
+      ItemDataBox idat{};
+      idat.hdr = hdr;
+      this->parseItemDataBox(idat, hdr.end());
+      box.itemDataBox = std::move(idat);
+      break;
+    }
     default:
       warningUnknownBox(hdr);
       break;
@@ -235,7 +350,7 @@ void Parser::parseItemPropertiesBox(ItemPropertiesBox& box, size_t const end) {
     ItemPropertyAssociation itemPropertyAssociation{};
     itemPropertyAssociation.hdr = hdr;
     this->parseItemPropertyAssociation(itemPropertyAssociation);
-    box.associations.emplace_back(itemPropertyAssociation);
+    box.associations.emplace_back(std::move(itemPropertyAssociation));
     this->seek(hdr.end());
   }
 }
@@ -248,14 +363,14 @@ void Parser::parseBoxInItemPropertyContainer(ItemPropertyContainer& container) {
       PixelAspectRatioBox box{};
       box.hdr = hdr;
       this->parsePixelAspectRatioBox(box, hdr.end());
-      container.properties.emplace_back(box);
+      container.properties.emplace_back(std::move(box));
       break;
     }
     case boxType("ispe"): {
       ImageSpatialExtentsProperty box{};
       box.hdr = hdr;
       this->parseImageSpatialExtentsProperty(box, hdr.end());
-      container.properties.emplace_back(box);
+      container.properties.emplace_back(std::move(box));
       break;
     }
     case boxType("pixi"): {
@@ -265,21 +380,21 @@ void Parser::parseBoxInItemPropertyContainer(ItemPropertyContainer& container) {
       PixelInformationProperty box{};
       box.hdr = hdr;
       this->parsePixelInformationProperty(box, hdr.end());
-      container.properties.emplace_back(box);
+      container.properties.emplace_back(std::move(box));
       break;
     }
     case boxType("rloc"): {
       RelativeLocationProperty rloc{};
       rloc.hdr = hdr;
       this->parseRelativeLocationProperty(rloc, hdr.end());
-      container.properties.emplace_back(rloc);
+      container.properties.emplace_back(std::move(rloc));
       break;
     }
     case boxType("auxC"): {
       AuxiliaryTypeProperty aux{};
       aux.hdr = hdr;
       this->parseAuxiliaryTypeProperty(aux, hdr.end());
-      container.properties.emplace_back(aux);
+      container.properties.emplace_back(std::move(aux));
       break;
     }
     case boxType("clap"): {
@@ -288,49 +403,49 @@ void Parser::parseBoxInItemPropertyContainer(ItemPropertyContainer& container) {
       CleanApertureBox clap{};
       clap.hdr = hdr;
       this->parseCleanApertureBox(clap, hdr.end());
-      container.properties.emplace_back(clap);
+      container.properties.emplace_back(std::move(clap));
       break;
     }
     case boxType("irot"): {
       ImageRotationBox irot;
       irot.hdr = hdr;
       this->parseImageRotationBox(irot, hdr.end());
-      container.properties.emplace_back(irot);
+      container.properties.emplace_back(std::move(irot));
       break;
     }
     case boxType("imir"): {
       ImageMirrorBox imir;
       imir.hdr = hdr;
       this->parseImageMirrorBox(imir, hdr.end());
-      container.properties.emplace_back(imir);
+      container.properties.emplace_back(std::move(imir));
       break;
     }
     case boxType("colr"): {
       ColourInformationBox colr;
       colr.hdr = hdr;
       this->parseColourInformationBox(colr, hdr.end());
-      container.properties.emplace_back(colr);
+      container.properties.emplace_back(std::move(colr));
       break;
     }
     case boxType("clli"): {
       ContentLightLevelBox clli;
       clli.hdr = hdr;
       this->parseContentLightLevelBox(clli, hdr.end());
-      container.properties.emplace_back(clli);
+      container.properties.emplace_back(std::move(clli));
       break;
     }
     case boxType("mdcv"): {
       MasteringDisplayColourVolumeBox mdcv;
       mdcv.hdr = hdr;
       this->parseMasteringDisplayColourVolumeBox(mdcv, hdr.end());
-      container.properties.emplace_back(mdcv);
+      container.properties.emplace_back(std::move(mdcv));
       break;
     }
     case boxType("av1C"): {
       AV1CodecConfigurationRecordBox box{};
       box.hdr = hdr;
       this->parseAV1CodecConfigurationRecordBox(box, hdr.end());
-      container.properties.emplace_back(box);
+      container.properties.emplace_back(std::move(box));
       break;
     }
     case boxType("free"):
@@ -368,6 +483,7 @@ void Parser::parsePixelInformationProperty(PixelInformationProperty& prop, size_
   // 6.5.6.1 Pixel information
   parseFullBoxHeader(prop);
   uint8_t const numChannels = readU8();
+  prop.bitsPerChannel.reserve(capacityFor(numChannels, 1));
   for(uint8_t i =0; i < numChannels; ++i) {
     prop.bitsPerChannel.emplace_back(readU8());
   }
@@ -388,7 +504,7 @@ void Parser::parseAuxiliaryTypeProperty(AuxiliaryTypeProperty& aux, size_t const
   // 6.5.7 Relative location
   parseFullBoxHeader(aux);
   aux.auxType = readString();
-  aux.auxSubtype = std::vector<uint8_t>(std::next(std::begin(buffer_), pos()), std::next(std::begin(buffer_), end));
+  aux.auxSubtype = slice(pos(), end);
 }
 
 void Parser::parseCleanApertureBox(CleanApertureBox& box, size_t const end) {
@@ -448,16 +564,14 @@ void Parser::parseColourInformationBox(ColourInformationBox& box, uint32_t end)
       break;
     }
     case str2uint("rICC"): {
-      std::vector<uint8_t> data(std::next(buffer_.begin(), pos()), std::next(buffer_.begin(), end));
       box.profile = ColourInformationBox::RestrictedICC {
-        .payload = std::move(data),
+        .payload = slice(pos(), end),
       };
       break;
     }
     case str2uint("prof"): {
-      std::vector<uint8_t> data(std::next(buffer_.begin(), pos()), std::next(buffer_.begin(), end));
       box.profile = ColourInformationBox::UnrestrictedICC {
-          .payload = std::move(data),
+          .payload = slice(pos(), end),
       };
       break;
     }
@@ -505,35 +619,41 @@ void Parser::parseAV1CodecConfigurationRecordBox(AV1CodecConfigurationRecordBox&
   } else {
     conf.initialPresentationDelay = 0;
   }
-  conf.configOBUs = std::vector<uint8_t>(std::next(this->buffer_.begin(), this->pos()), std::next(this->buffer_.begin(), end));
+  conf.configOBUs = slice(pos(), end);
 }
 
 void Parser::parseItemPropertyAssociation(ItemPropertyAssociation& assoc) {
   // https://github.com/nokiatech/heif/blob/master/srcs/common/itempropertyassociation.cpp
   parseFullBoxHeader(assoc);
   uint32_t const itemCount = readU32();
+  size_t const itemIDSize = assoc.version() < 1 ? 2 : 4;
+  size_t const entrySize = (assoc.flags() & 1u) == 1u ? 2 : 1;
+  assoc.items.reserve(capacityFor(itemCount, itemIDSize + 1));
   for(uint32_t i = 0; i < itemCount; ++i) {
     ItemPropertyAssociation::Item item;
+    require(itemIDSize + 1);
     if(assoc.version() < 1) {
-      item.itemID = readU16();
+      item.itemID = readU16Unchecked();
     } else {
-      item.itemID = readU32();
+      item.itemID = readU32Unchecked();
     }
-    uint8_t entryCount = readU8();
+    uint8_t entryCount = readU8Unchecked();
+    require(entrySize * entryCount);
+    item.entries.reserve(entryCount);
     for(uint8_t j = 0; j < entryCount; ++j) {
       ItemPropertyAssociation::Item::Entry entry{};
       if((assoc.flags() & 1u) == 1u) {
-        uint16_t const v = readU16();
+        uint16_t const v = readU16Unchecked();
         entry.essential = (v & 0x8000u) == 0x8000u;
         entry.propertyIndex = v & 0x7fffu;
       } else {
-        uint8_t const v = readU8();
+        uint8_t const v = readU8Unchecked();
         entry.essential = (v & 0x80u) == 0x80u;
         entry.propertyIndex = v & 0x7fu;
       }
       item.entries.emplace_back(entry);
     }
-    assoc.items.emplace_back(item);
+    assoc.items.emplace_back(std::move(item));
   }
 }
 
@@ -547,6 +667,7 @@ void Parser::parseItemInfoBox(ItemInfoBox& box, size_t const end) {
   } else {
     entryCount = readU32();
   }
+  box.itemInfos.reserve(capacityFor(entryCount, 12)); // the smallest infe: box header + full box header
   for(uint32_t i = 0; i < entryCount; ++i) {
     Box::Header hdr = readBoxHeader();
     if(hdr.type != str2uint("infe")) {
@@ -579,6 +700,7 @@ void Parser::parseItemInfoEntry(ItemInfoEntry& box, size_t const end) {
       ext.contentLength = readU64();
       ext.transferLength = readU64();
       uint8_t entryCount = readU8();
+      ext.groupIDs.reserve(capacityFor(entryCount, 1));
       for(uint8_t i = 0; i < entryCount; ++i) {
         ext.groupIDs.emplace_back(readU8());
       }
@@ -647,32 +769,42 @@ void Parser::parseItemLocationBox(ItemLocationBox& box, size_t const end) {
   }else{
     throw Error("Unknwon ItemLocationBox version={}", box.version());
   }
+  bool const hasIndex = (box.version() == 1 || box.version() == 2) && (box.indexSize > 0);
+  size_t const itemHeaderSize =
+      (box.version() < 2 ? 2 : 4) + /* item_ID */
+      (box.version() == 1 || box.version() == 2 ? 2 : 0) + /* construction_method */
+      2 + /* data_reference_index */
+      box.baseOffsetSize +
+      2; /* extent_count */
+  size_t const extentSize = (hasIndex ? box.indexSize : 0) + box.offsetSize + box.lengthSize;
+  box.items.reserve(capacityFor(itemCount, itemHeaderSize));
   for(uint32_t i = 0; i < itemCount; ++i) {
     ItemLocationBox::Item item{};
+    require(itemHeaderSize);
     if (box.version() < 2) {
-      item.itemID = readU16();
-    } else if (box.version() == 2) {
-      item.itemID = readU32();
+      item.itemID = readU16Unchecked();
     } else {
-      throw Error("Unknwon ItemLocationBox version={}", box.version());
+      item.itemID = readU32Unchecked();
     }
     if (box.version() == 1 || box.version() == 2) {
-      item.constructionMethod = readU16() & 0x7u;
+      item.constructionMethod = readU16Unchecked() & 0x7u;
     }
-    item.dataReferenceIndex = readU16();
-    item.baseOffset = readUint(box.baseOffsetSize).value();
-    uint16_t const extentCount = readU16();
+    item.dataReferenceIndex = readU16Unchecked();
+    item.baseOffset = readUintUnchecked(box.baseOffsetSize);
+    uint16_t const extentCount = readU16Unchecked();
+    require(extentSize * extentCount);
+    item.extents.reserve(extentCount);
     for (uint32_t j = 0; j < extentCount; ++j) {
       ItemLocationBox::Item::Extent extent{};
-      if((box.version() == 1 || box.version() == 2) && (box.indexSize > 0)) {
-        extent.extentIndex = readUint(box.indexSize).value();
+      if(hasIndex) {
+        extent.extentIndex = readUintUnchecked(box.indexSize);
       }
-      extent.extentOffset = readUint(box.offsetSize).value();
-      extent.extentLength = readUint(box.lengthSize).value();
+      extent.extentOffset = readUintUnchecked(box.offsetSize);
+      extent.extentLength = readUintUnchecked(box.lengthSize);
 
       item.extents.emplace_back(extent);
     }
-    box.items.emplace_back(item);
+    box.items.emplace_back(std::move(item));
   }
 }
 
@@ -693,12 +825,13 @@ void Parser::parseItemReferenceBox(ItemReferenceBox& box, size_t const end) {
       item.hdr = readBoxHeader();
       item.fromItemID = readU16();
       size_t const referenceCount = readU16();
+      item.toItemIDs.reserve(capacityFor(referenceCount, 2));
       for(size_t i = 0; i < referenceCount; ++i) {
         uint16_t const toID = readU16();
         item.toItemIDs.emplace_back(toID);
       }
       this->seek(item.hdr.end());
-      items.emplace_back(item);
+      items.emplace_back(std::move(item));
     }
     box.references = std::move(items);
   } else {
@@ -708,17 +841,23 @@ void Parser::parseItemReferenceBox(ItemReferenceBox& box, size_t const end) {
       item.hdr = readBoxHeader();
       item.fromItemID = readU32();
       size_t const referenceCount = readU16();
+      item.toItemIDs.reserve(capacityFor(referenceCount, 4));
       for(size_t i = 0; i < referenceCount; ++i) {
         uint32_t const toID = readU32();
         item.toItemIDs.emplace_back(toID);
       }
       this->seek(item.hdr.end());
-      items.emplace_back(item);
+      items.emplace_back(std::move(item));
     }
     box.references = std::move(items);
   }
 }
 
+void Parser::parseItemDataBox(ItemDataBox& box, size_t const end) {
+  box.offset = this->pos();
+  box.data = slice(this->pos(), end);
+}
+
 void Parser::parseMediaDataBox(MediaDataBox& box, size_t const end) {
   box.offset = this->pos();
   box.size = end - box.offset;
@@ -737,10 +876,10 @@ Box::Header Parser::readBoxHeader() {
     throw Error("LargeSize box is not supported.");
   }
   if(hdr.size == 0) {
-    hdr.size = this->buffer_.size() - hdr.offset;
+    hdr.size = this->endOfBuffer() - hdr.offset;
   }
-  if((hdr.end()) > this->buffer_.size()) {
-    throw Error("File corrupted. Detected at {} box, from {} to {}, but buffer.size = {}.", uint2str(hdr.type), hdr.offset, hdr.end(), this->buffer_.size());
+  if((hdr.end()) > this->endOfBuffer()) {
+    throw Error("File corrupted. Detected at {} box, from {} to {}, but buffer ends at {}.", uint2str(hdr.type), hdr.offset, hdr.end(), this->endOfBuffer());
   }
   return hdr;
 }
@@ -755,7 +894,7 @@ void Parser::parseFullBoxHeader(FullBox& fullBox) {
 
 void Parser::warningUnknownBox(Box::Header const& hdr) {
   std::string typeStr = uint2str(hdr.type);
-  log().warn("Unknown box type={}(=0x{:x}) with size={}({}~{}/{})", typeStr.c_str(), hdr.type, hdr.size, hdr.offset, hdr.end(), this->buffer_.size());
+  log().warn("Unknown box type={}(=0x{:x}) with size={}({}~{}/{})", typeStr.c_str(), hdr.type, hdr.size, hdr.offset, hdr.end(), this->endOfBuffer());
 }
 
 }
\ No newline at end of file
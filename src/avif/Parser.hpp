@@ -3,16 +3,19 @@
 //
 
 #pragma once
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <cstdint>
 #include <memory>
 #include <variant>
 #include <string>
+#include <functional>
 #include <fmt/format.h>
 
 #include "util/Logger.hpp"
 #include "util/StreamReader.hpp"
+#include "util/Buffer.hpp"
 #include "Box.hpp"
 #include "FullBox.hpp"
 #include "FileBox.hpp"
@@ -57,15 +60,15 @@ public:
   };
   class Result final {
     private:
-      std::vector<uint8_t> const buffer_;
+      util::Buffer const buffer_;
       std::variant<FileBox, Parser::Error> const result_;
     public:
-      Result(std::vector<uint8_t> buffer, FileBox&& fileBox)
+      Result(util::Buffer buffer, FileBox&& fileBox)
       :buffer_(std::move(buffer))
       ,result_(std::move(fileBox))
       {
       }
-      Result(std::vector<uint8_t> buffer, Parser::Error&& err)
+      Result(util::Buffer buffer, Parser::Error&& err)
           :buffer_(std::move(buffer))
           ,result_(std::move(err))
       {
@@ -78,7 +81,7 @@ public:
       Result(Result&&) = delete;
     public:
       [[ nodiscard ]] bool ok() const { return std::holds_alternative<FileBox>(this->result_); }
-      [[ nodiscard ]] std::vector<uint8_t> const& buffer() const { return this->buffer_; }
+      [[ nodiscard ]] util::Buffer const& buffer() const { return this->buffer_; }
       [[ nodiscard ]] std::string error() const {
         if (this->ok()) {
           return "<no-error>";
@@ -94,11 +97,74 @@ public:
         }
       }
     };
+  class ProbeResult final {
+    public:
+      // The prefix did not contain the whole 'meta' box.
+      struct NeedMoreData final {
+        // Bytes from the beginning of the file required to continue.
+        size_t requiredSize;
+      };
+    private:
+      std::vector<util::Buffer> const buffers_;
+      std::variant<FileBox, NeedMoreData, Parser::Error> const result_;
+    public:
+      ProbeResult(std::vector<util::Buffer> buffers, FileBox&& fileBox)
+      :buffers_(std::move(buffers))
+      ,result_(std::move(fileBox))
+      {
+      }
+      explicit ProbeResult(NeedMoreData const needMoreData)
+      :buffers_()
+      ,result_(needMoreData)
+      {
+      }
+      explicit ProbeResult(Parser::Error&& err)
+      :buffers_()
+      ,result_(std::move(err))
+      {
+      }
+      ~ProbeResult() noexcept = default;
+      ProbeResult() = delete;
+      ProbeResult& operator=(ProbeResult const&) = delete;
+      ProbeResult& operator=(ProbeResult&&) = delete;
+      ProbeResult(ProbeResult const&) = delete;
+      ProbeResult(ProbeResult&&) = delete;
+    public:
+      [[ nodiscard ]] bool ok() const { return std::holds_alternative<FileBox>(this->result_); }
+      [[ nodiscard ]] bool needsMoreData() const { return std::holds_alternative<NeedMoreData>(this->result_); }
+      [[ nodiscard ]] size_t requiredSize() const {
+        if(this->needsMoreData()) {
+          return std::get<NeedMoreData>(this->result_).requiredSize;
+        } else {
+          throw std::domain_error("ProbeResult does not need more data.");
+        }
+      }
+      [[ nodiscard ]] std::string error() const {
+        if (std::holds_alternative<Parser::Error>(this->result_)) {
+          return std::get<Parser::Error>(this->result_).msg();
+        } else {
+          return "<no-error>";
+        }
+      }
+      // Contains 'ftyp', 'meta' and the 'mdat's located before 'meta'.
+      [[ nodiscard ]] FileBox const& fileBox() const {
+        if(this->ok()) {
+          return std::get<FileBox>(this->result_);
+        } else if(this->needsMoreData()) {
+          throw std::domain_error(fmt::format("ProbeResult needs {} bytes", this->requiredSize()));
+        } else {
+          throw std::domain_error(fmt::format("ProbeResult is an error: {}", error()));
+        }
+      }
+  };
+  // Reads [offset, offset + size) of the file into dst, and returns the number of bytes actually read.
+  // It may return less than "size" at the end of file or when the bytes are not available yet.
+  using RangeReader = std::function<size_t(size_t offset, size_t size, uint8_t* dst)>;
 
 private:
   util::Logger& log_;
 private: // intermediate states
-  std::vector<uint8_t> buffer_;
+  util::Buffer buffer_;
   util::StreamReader reader_;
 private: // parsed results
   FileBox fileBox_;
@@ -118,13 +184,28 @@ public:
 
 public: //entry point
   Parser(util::Logger& log, std::vector<uint8_t> buff);
+  // Parses memory-mapped or otherwise shared bytes without copying them (See: util::mapFile).
+  Parser(util::Logger& log, util::Buffer buff);
+  // Non-owning. The caller must keep [data, data+size) alive while using the parsed result.
+  Parser(util::Logger& log, uint8_t const* data, size_t size);
+  // Parses boxes in a window of the file. "buff" holds the bytes at [offset, offset + buff.size()).
+  // Offsets in the parsed boxes are still relative to the beginning of the file.
+  Parser(util::Logger& log, util::Buffer buff, size_t offset);
   std::shared_ptr<Result> parse();
 
+  // Parses just enough top-level boxes to read 'meta', skipping the payload of 'mdat's and others.
+  static std::shared_ptr<ProbeResult> probe(util::Logger& log, RangeReader const& reader);
+  // Same as above, but reads from the first bytes of the file.
+  static std::shared_ptr<ProbeResult> probe(util::Logger& log, util::Buffer const& prefix);
+
 public: // getters
   [[nodiscard]] util::Logger& log() { return this->log_; }
 
 private:
   [[nodiscard]] size_t pos() { return this->reader_.pos(); }
+  [[nodiscard]] size_t endOfBuffer() { return this->reader_.end(); }
+  // [beg, end) of the file without copying. It keeps the buffer alive if the buffer is owned.
+  [[nodiscard]] util::Buffer slice(size_t const beg, size_t const end) { return this->buffer_.slice(beg - this->reader_.origin(), end - beg); }
   void seek(size_t pos) { this->reader_.seek(pos); }
   [[nodiscard]] bool consumed() { return this->reader_.consumed(); }
   [[nodiscard]] uint8_t  readU8() { return this->reader_.readU8(); }
@@ -133,6 +214,18 @@ private:
   [[nodiscard]] uint64_t readU64() { return this->reader_.readU64(); }
   [[nodiscard]] std::optional<uint64_t> readUint(size_t const octets) { return this->reader_.readUint(octets); }
   [[nodiscard]] std::string readString() { return this->reader_.readString(); }
+  // Checks the bounds once for the following unchecked reads.
+  void require(size_t const octets) { this->reader_.require(octets); }
+  [[nodiscard]] uint8_t  readU8Unchecked() { return this->reader_.readU8Unchecked(); }
+  [[nodiscard]] uint16_t readU16Unchecked() { return this->reader_.readU16Unchecked(); }
+  [[nodiscard]] uint32_t readU32Unchecked() { return this->reader_.readU32Unchecked(); }
+  [[nodiscard]] uint64_t readUintUnchecked(size_t const octets) { return this->reader_.readUintUnchecked(octets); }
+  // How many entries of at least "entrySize" bytes can follow, to reserve containers before reading them.
+  // A broken count can not make us allocate more than the rest of the buffer.
+  [[nodiscard]] size_t capacityFor(size_t const count, size_t const entrySize) {
+    size_t const rest = this->pos() < this->endOfBuffer() ? this->endOfBuffer() - this->pos() : 0;
+    return std::min(count, rest / std::max<size_t>(entrySize, 1));
+  }
 
 private:
   void parseFullBoxHeader(FullBox& fullBox);
@@ -174,6 +267,7 @@ private:
 
   void parseItemReferenceBox(ItemReferenceBox& box, size_t end);
 
+  void parseItemDataBox(ItemDataBox& box, size_t end);
   void parseMediaDataBox(MediaDataBox& box, size_t end);
 
   void parseItemPropertyAssociation(ItemPropertyAssociation &assoc);
@@ -5,24 +5,106 @@
 #pragma once
 
 #include <optional>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <variant>
+#include <stdexcept>
+#include <fmt/format.h>
 #include "FileBox.hpp"
+#include "ItemIndex.hpp"
+#include "util/Buffer.hpp"
 
 namespace avif::util::query {
 
+// The overloads taking a FileBox scan the boxes for the one item asked, without building anything.
+// Build an ItemIndex once and use the ItemIndex overloads when you query the same file repeatedly.
+
+namespace detail {
+
+// The first ItemLocationBox::Item of the item, as ItemIndex picks.
+inline avif::ItemLocationBox::Item const* findItemLocation(avif::FileBox const& fileBox, uint32_t const itemID) {
+  for(avif::ItemLocationBox::Item const& item : fileBox.metaBox.itemLocationBox.items) {
+    if(item.itemID == itemID) {
+      return &item;
+    }
+  }
+  return nullptr;
+}
+
+// Whether the item has an essential ipma entry pointing out of 'ipco', as ItemIndex::Entry::invalidEssentialProperty.
+inline bool hasInvalidEssentialProperty(avif::FileBox const& fileBox, uint32_t const itemID) {
+  size_t const numProps = fileBox.metaBox.itemPropertiesBox.propertyContainers.properties.size();
+  for(avif::ItemPropertyAssociation const& assoc : fileBox.metaBox.itemPropertiesBox.associations) {
+    for(avif::ItemPropertyAssociation::Item const& item : assoc.items) {
+      if(item.itemID != itemID) {
+        continue;
+      }
+      for(avif::ItemPropertyAssociation::Item::Entry const& e : item.entries) {
+        if(e.essential && e.propertyIndex > numProps) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+// The first property of type T associated to the item, in the order of the ipma entries.
+// Entries pointing out of 'ipco' are skipped, as in ItemIndex.
 template <typename T>
-std::optional<T> findProperty(avif::FileBox const& fileBox, std::optional<uint32_t> itemID) {
-  for(auto const& assoc : fileBox.metaBox.itemPropertiesBox.associations) {
-    for(auto const& item : assoc.items) {
-      if(itemID.has_value() && item.itemID != itemID.value()) {
+T const* findItemProperty(avif::FileBox const& fileBox, uint32_t const itemID) {
+  auto const& props = fileBox.metaBox.itemPropertiesBox.propertyContainers.properties;
+  for(avif::ItemPropertyAssociation const& assoc : fileBox.metaBox.itemPropertiesBox.associations) {
+    for(avif::ItemPropertyAssociation::Item const& item : assoc.items) {
+      if(item.itemID != itemID) {
         continue;
       }
-      for(auto const& entry : item.entries) {
-        if(entry.propertyIndex == 0) {
+      for(avif::ItemPropertyAssociation::Item::Entry const& e : item.entries) {
+        if(e.propertyIndex == 0 || e.propertyIndex > props.size()) {
+          continue;
+        }
+        if(auto const* const prop = std::get_if<T>(&props[e.propertyIndex - 1]); prop != nullptr) {
+          return prop;
+        }
+      }
+    }
+  }
+  return nullptr;
+}
+
+}
+
+template <typename T>
+std::optional<T> findProperty(avif::ItemIndex const& index, std::optional<uint32_t> itemID) {
+  if(itemID.has_value()) {
+    T const* const prop = index.findProperty<T>(itemID.value());
+    return prop != nullptr ? std::optional<T>(*prop) : std::optional<T>();
+  }
+  for(avif::ItemIndex::Entry const& entry : index.entries()) {
+    if(T const* const prop = index.findProperty<T>(entry.itemID); prop != nullptr) {
+      return *prop;
+    }
+  }
+  return {};
+}
+
+template <typename T>
+std::optional<T> findProperty(avif::FileBox const& fileBox, std::optional<uint32_t> itemID) {
+  if(itemID.has_value()) {
+    T const* const prop = detail::findItemProperty<T>(fileBox, itemID.value());
+    return prop != nullptr ? std::optional<T>(*prop) : std::optional<T>();
+  }
+  // ipma lists the items in increasing order of their IDs, so this is the same item as with ItemIndex.
+  auto const& props = fileBox.metaBox.itemPropertiesBox.propertyContainers.properties;
+  for(avif::ItemPropertyAssociation const& assoc : fileBox.metaBox.itemPropertiesBox.associations) {
+    for(avif::ItemPropertyAssociation::Item const& item : assoc.items) {
+      for(avif::ItemPropertyAssociation::Item::Entry const& e : item.entries) {
+        if(e.propertyIndex == 0 || e.propertyIndex > props.size()) {
           continue;
         }
-        auto& prop = fileBox.metaBox.itemPropertiesBox.propertyContainers.properties.at(entry.propertyIndex - 1);
-        if(std::holds_alternative<T>(prop)){
-          return std::get<T>(prop);
+        if(auto const* const prop = std::get_if<T>(&props[e.propertyIndex - 1]); prop != nullptr) {
+          return *prop;
         }
       }
     }
@@ -30,69 +112,195 @@ std::optional<T> findProperty(avif::FileBox const& fileBox, std::optional<uint32
   return {};
 }
 
-std::pair<size_t, size_t> findItemRegion(avif::FileBox const& fileBox, std::optional<uint32_t> const itemID, std::optional<uint32_t> const extentID = {}) {
-  size_t const itemIdx = itemID.has_value() ? (itemID.value() - 1) : 0;
+// Where the item is stored, as [begin, end) offsets in the file, one per extent.
+// Extents with construction_method = 1 point into the 'idat' box.
+namespace detail {
+
+inline std::vector<std::pair<size_t, size_t>> findItemExtents(avif::FileBox const& fileBox, avif::ItemLocationBox::Item const& location) {
+  uint32_t const itemID = location.itemID;
+  if(location.dataReferenceIndex != 0) {
+    throw std::domain_error(fmt::format("Item {} is stored in another file (data_reference_index={}).", itemID, location.dataReferenceIndex));
+  }
+  // [begin, end) of the box the extents refer to. An extent with length 0 lasts until its end.
+  std::vector<std::pair<size_t, size_t>> containers;
+  switch(location.constructionMethod) {
+    case 0: // file offset
+      for(avif::MediaDataBox const& mdat : fileBox.mediaDataBoxes) {
+        containers.emplace_back(mdat.offset, mdat.offset + mdat.size);
+      }
+      break;
+    case 1: { // idat offset
+      if(!fileBox.metaBox.itemDataBox.has_value()) {
+        throw std::out_of_range(fmt::format("Item {} refers to 'idat', but there is no 'idat' box.", itemID));
+      }
+      avif::ItemDataBox const& idat = fileBox.metaBox.itemDataBox.value();
+      containers.emplace_back(idat.offset, idat.offset + idat.data.size());
+      break;
+    }
+    default:
+      throw std::domain_error(fmt::format("Item {} has unsupported construction_method={}.", itemID, location.constructionMethod));
+  }
+  size_t const origin = location.constructionMethod == 1 ? containers.front().first : 0;
+  std::vector<std::pair<size_t, size_t>> extents;
+  extents.reserve(location.extents.size());
+  for(avif::ItemLocationBox::Item::Extent const& extent : location.extents) {
+    size_t const begin = origin + location.baseOffset + extent.extentOffset;
+    size_t end = begin + extent.extentLength;
+    if(extent.extentLength == 0) {
+      auto const it = std::find_if(containers.begin(), containers.end(), [begin](auto const& c) { return c.first <= begin && begin <= c.second; });
+      if(it == containers.end()) {
+        throw std::out_of_range(fmt::format("Item {} has an extent with unknown length at {}.", itemID, begin));
+      }
+      end = it->second;
+    }
+    if(location.constructionMethod == 1 && end > containers.front().second) {
+      throw std::out_of_range(fmt::format("Item {} has an extent [{}, {}) out of 'idat'.", itemID, begin, end));
+    }
+    extents.emplace_back(begin, end);
+  }
+  return extents;
+}
+
+}
+
+inline std::vector<std::pair<size_t, size_t>> findItemExtents(avif::ItemIndex const& index, uint32_t const itemID) {
+  avif::ItemIndex::Entry const* const entry = index.find(itemID);
+  if(entry == nullptr || entry->location == nullptr) {
+    throw std::out_of_range(fmt::format("Item {} does not have its location.", itemID));
+  }
+  return detail::findItemExtents(index.fileBox(), *entry->location);
+}
+
+inline std::vector<std::pair<size_t, size_t>> findItemExtents(avif::FileBox const& fileBox, uint32_t const itemID) {
+  avif::ItemLocationBox::Item const* const location = detail::findItemLocation(fileBox, itemID);
+  if(location == nullptr) {
+    throw std::out_of_range(fmt::format("Item {} does not have its location.", itemID));
+  }
+  return detail::findItemExtents(fileBox, *location);
+}
+
+// Total bytes of the item, the size copyItem() needs.
+inline size_t findItemSize(avif::ItemIndex const& index, uint32_t const itemID) {
+  size_t size = 0;
+  for(auto const& extent : findItemExtents(index, itemID)) {
+    size += extent.second - extent.first;
+  }
+  return size;
+}
+
+// Concatenates the extents of the item into dst, and returns the bytes written.
+// "file" is the whole file. Extents in 'idat' are read from the parsed 'idat' box, so it may not include the meta box.
+inline size_t copyItem(avif::ItemIndex const& index, uint32_t const itemID, avif::util::Buffer const& file, uint8_t* const dst, size_t const dstSize) {
+  std::vector<std::pair<size_t, size_t>> const extents = findItemExtents(index, itemID);
+  bool const inItemData = index.find(itemID)->location->constructionMethod == 1;
+  avif::util::Buffer const& src = inItemData ? index.fileBox().metaBox.itemDataBox->data : file;
+  size_t const origin = inItemData ? index.fileBox().metaBox.itemDataBox->offset : 0;
+  size_t written = 0;
+  for(auto const& extent : extents) {
+    size_t const size = extent.second - extent.first;
+    if(size > dstSize - written) {
+      throw std::out_of_range(fmt::format("Item {} does not fit in {} bytes.", itemID, dstSize));
+    }
+    if(extent.second - origin > src.size()) {
+      throw std::out_of_range(fmt::format("Item {} has an extent [{}, {}) out of the file.", itemID, extent.first, extent.second));
+    }
+    std::copy(src.data() + (extent.first - origin), src.data() + (extent.second - origin), dst + written);
+    written += size;
+  }
+  return written;
+}
+
+// Items with an essential property the file does not have must not be processed (ISO/IEC 23008-12),
+// so the queries below that pick an item by themselves never return one of them.
+
+inline std::pair<size_t, size_t> findItemRegion(avif::ItemIndex const& index, std::optional<uint32_t> const itemID, std::optional<uint32_t> const extentID = {}) {
   size_t const extentIdx = extentID.has_value() ? (extentID.value() - 1) : 0;
-  size_t const baseOffset = fileBox.metaBox.itemLocationBox.items.at(itemIdx).baseOffset;
-  size_t const extentOffset = fileBox.metaBox.itemLocationBox.items.at(itemIdx).extents.at(extentIdx).extentOffset;
-  size_t const extentLength = fileBox.metaBox.itemLocationBox.items.at(itemIdx).extents.at(extentIdx).extentLength;
-  return std::make_pair(baseOffset + extentOffset, baseOffset + extentOffset + extentLength);
+  uint32_t id = itemID.value_or(0);
+  if(!itemID.has_value()) {
+    auto const it = std::find_if(index.entries().begin(), index.entries().end(), [](avif::ItemIndex::Entry const& e) {
+      return e.location != nullptr && !e.invalidEssentialProperty;
+    });
+    if(it == index.entries().end()) {
+      throw std::out_of_range("No item has its location.");
+    }
+    id = it->itemID;
+  }
+  return findItemExtents(index, id).at(extentIdx);
 }
 
-std::optional<uint32_t> findPrimaryItemID(avif::FileBox const& fileBox) {
+inline std::pair<size_t, size_t> findItemRegion(avif::FileBox const& fileBox, std::optional<uint32_t> const itemID, std::optional<uint32_t> const extentID = {}) {
+  size_t const extentIdx = extentID.has_value() ? (extentID.value() - 1) : 0;
+  uint32_t id = itemID.value_or(0);
+  if(!itemID.has_value()) {
+    std::optional<uint32_t> found;
+    for(avif::ItemLocationBox::Item const& item : fileBox.metaBox.itemLocationBox.items) {
+      if((!found.has_value() || item.itemID < found.value()) && !detail::hasInvalidEssentialProperty(fileBox, item.itemID)) {
+        found = item.itemID;
+      }
+    }
+    if(!found.has_value()) {
+      throw std::out_of_range("No item has its location.");
+    }
+    id = found.value();
+  }
+  return findItemExtents(fileBox, id).at(extentIdx);
+}
+
+inline std::optional<uint32_t> findPrimaryItemID(avif::ItemIndex const& index) {
+  if(index.fileBox().metaBox.primaryItemBox.has_value()) {
+    uint32_t const itemID = index.fileBox().metaBox.primaryItemBox.value().itemID;
+    avif::ItemIndex::Entry const* const entry = index.find(itemID);
+    if(entry == nullptr || !entry->invalidEssentialProperty) {
+      return itemID;
+    }
+  }
+  return std::optional<uint32_t>();
+}
+
+inline std::optional<uint32_t> findPrimaryItemID(avif::FileBox const& fileBox) {
   if(fileBox.metaBox.primaryItemBox.has_value()) {
-    return fileBox.metaBox.primaryItemBox.value().itemID;
+    uint32_t const itemID = fileBox.metaBox.primaryItemBox.value().itemID;
+    if(!detail::hasInvalidEssentialProperty(fileBox, itemID)) {
+      return itemID;
+    }
   }
   return std::optional<uint32_t>();
 }
 
-std::optional<uint32_t> findAuxItemID(avif::FileBox const& fileBox, uint32_t const itemID, std::string const& auxType) {
+// Finds the item which refers to the item and has an AuxiliaryTypeProperty with the auxType.
+inline std::optional<uint32_t> findAuxItemID(avif::ItemIndex const& index, uint32_t const itemID, std::string const& auxType) {
+  for(avif::ItemIndex::Reference const& ref : index.incomingReferences(itemID)) {
+    avif::ItemIndex::Entry const* const from = index.find(ref.fromItemID);
+    if(from != nullptr && from->invalidEssentialProperty) {
+      continue;
+    }
+    auto const* const aux = index.findProperty<AuxiliaryTypeProperty>(ref.fromItemID);
+    if(aux != nullptr && aux->auxType == auxType) {
+      return ref.fromItemID;
+    }
+  }
+  return std::optional<uint32_t>();
+}
+
+inline std::optional<uint32_t> findAuxItemID(avif::FileBox const& fileBox, uint32_t const itemID, std::string const& auxType) {
   if(!fileBox.metaBox.itemReferenceBox.has_value()) {
     return std::optional<uint32_t>();
   }
-  auto const& refs = fileBox.metaBox.itemReferenceBox->references;
-  if(std::holds_alternative<std::vector<SingleItemTypeReferenceBoxLarge>>(refs)) {
-    for(auto const& ref : std::get<std::vector<SingleItemTypeReferenceBoxLarge>>(refs)) {
-      for(auto const& toItemID : ref.toItemIDs) {
-        if(toItemID == itemID) {
-          for(auto const& assoc : fileBox.metaBox.itemPropertiesBox.associations){
-            for(auto const& item : assoc.items){
-              if(item.itemID == ref.fromItemID) {
-                for(auto const& prop : fileBox.metaBox.itemPropertiesBox.propertyContainers.properties) {
-                  if(std::holds_alternative<AuxiliaryTypeProperty>(prop)) {
-                    if(std::get<AuxiliaryTypeProperty>(prop).auxType == auxType) {
-                      return ref.fromItemID;
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
+  return std::visit([&](auto const& refs) -> std::optional<uint32_t> {
+    for(auto const& ref : refs) {
+      if(std::find(ref.toItemIDs.begin(), ref.toItemIDs.end(), itemID) == ref.toItemIDs.end()) {
+        continue;
       }
-    }
-  } else {
-    for(auto const& ref : std::get<std::vector<SingleItemTypeReferenceBox>>(refs)) {
-      for(auto const& toItemID : ref.toItemIDs) {
-        if(toItemID == itemID) {
-          for(auto const& assoc : fileBox.metaBox.itemPropertiesBox.associations){
-            for(auto const& item : assoc.items){
-              if(item.itemID == ref.fromItemID) {
-                for(auto const& prop : fileBox.metaBox.itemPropertiesBox.propertyContainers.properties) {
-                  if(std::holds_alternative<AuxiliaryTypeProperty>(prop)) {
-                    if(std::get<AuxiliaryTypeProperty>(prop).auxType == auxType) {
-                      return ref.fromItemID;
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
+      if(detail::hasInvalidEssentialProperty(fileBox, ref.fromItemID)) {
+        continue;
+      }
+      auto const* const aux = detail::findItemProperty<AuxiliaryTypeProperty>(fileBox, ref.fromItemID);
+      if(aux != nullptr && aux->auxType == auxType) {
+        return ref.fromItemID;
       }
     }
-  }
-  return std::optional<uint32_t>();
+    return std::optional<uint32_t>();
+  }, fileBox.metaBox.itemReferenceBox->references);
 }
 
-}
\ No newline at end of file
+}
@@ -111,6 +111,9 @@ void Writer::writeMetaBox(MetaBox& box) {
     this->writeItemReferenceBox(box.itemReferenceBox.value());
   }
   this->writeItemPropertiesBox(box.itemPropertiesBox);
+  if(box.itemDataBox.has_value()) {
+    this->writeItemDataBox(box.itemDataBox.value());
+  }
 }
 
 void Writer::writeHandlerBox(HandlerBox& box) {
@@ -476,6 +479,12 @@ void Writer::writeItemReferenceBox(ItemReferenceBox& box) {
   }
 }
 
+void Writer::writeItemDataBox(ItemDataBox& box) {
+  auto context = this->beginBoxHeader("idat", box);
+  box.offset = this->stream_.size();
+  append(box.data);
+}
+
 void Writer::writeMediaDataBox(MediaDataBox& box) {
   auto context = this->beginBoxHeader("mdat", box);
   std::vector<uint8_t> dummy;
@@ -6,6 +6,7 @@
 
 #include "util/Logger.hpp"
 #include "util/StreamWriter.hpp"
+#include "util/Buffer.hpp"
 #include "FileBox.hpp"
 #include "ItemReferenceBox.hpp"
 
@@ -48,6 +49,7 @@ private:
   void putU32(uint32_t const data) { this->stream_.putU32B(data); }
   void putU64(uint64_t const data) { this->stream_.putU64B(data); }
   void append(std::vector<uint8_t> const& data) { this->stream_.append(data); }
+  void append(util::Buffer const& data) { this->stream_.append(data.data(), data.size()); }
   void append(uint8_t const*const data, size_t const length) { this->stream_.append(data, length); }
   void putTypeString(std::string const& type);
   void putString(std::string const& str);
@@ -81,6 +83,7 @@ private:
   void writePrimaryItemBox(PrimaryItemBox& box);
   void writeItemReferenceBox(ItemReferenceBox& box);
 
+  void writeItemDataBox(ItemDataBox& box);
   void writeMediaDataBox(MediaDataBox& box);
 };
 
@@ -3,139 +3,156 @@
 //
 
 #include <cassert>
+#include <stdexcept>
+#include "../util/Endian.hpp"
 #include "BitStreamReader.hpp"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace avif::av1 {
 
+namespace {
+
+// v must not be 0.
+inline uint32_t countLeadingZeros(uint64_t const v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<uint32_t>(__builtin_clzll(v));
+#elif defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanReverse64(&index, v);
+  return 63u - static_cast<uint32_t>(index);
+#else
+  uint32_t n = 0;
+  for (uint64_t bit = uint64_t(1) << 63u; (v & bit) == 0; bit >>= 1u) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+}
+
 BitStreamReader::BitStreamReader(avif::util::Logger& log, std::vector<uint8_t> const& buffer)
-:reader_(log, buffer)
-,log_(log)
-,bits_(0)
-,posInBits_(0)
+:BitStreamReader(log, buffer.data(), buffer.size())
+{
+}
+
+BitStreamReader::BitStreamReader(avif::util::Logger& log, uint8_t const* const data, size_t const size)
+:log_(log)
+,data_(data)
+,size_(size)
+,next_(0)
+,cache_(0)
+,cacheBits_(0)
 {
-  this->bits_ = this->reader_.readU8();
 }
 
-size_t BitStreamReader::posInBits() const {
-  return (posInBytes() * 8u) + posInBits_;
+void BitStreamReader::throwOverrun() {
+  throw std::range_error("Buffer overrun.");
 }
 
-size_t BitStreamReader::posInBytes() const {
-  return posInBits_ == 8 ? reader_.pos() : (reader_.pos() - 1u);
+void BitStreamReader::seekInBytes(size_t const posInBytes) {
+  this->next_ = posInBytes;
+  this->cache_ = 0;
+  this->cacheBits_ = 0;
 }
 
-bool BitStreamReader::consumed() const {
-  return reader_.consumed() && posInBits_ == 8;
+void BitStreamReader::refill() {
+  if (this->next_ + 8u <= this->size_) {
+    // The bytes that do not fit whole go into the bits after the unread ones, where they will be read again.
+    this->cache_ |= util::loadU64BE(this->data_ + this->next_) >> this->cacheBits_;
+    size_t const bytes = (63u - this->cacheBits_) / 8u;
+    this->next_ += bytes;
+    this->cacheBits_ += static_cast<uint8_t>(bytes * 8u);
+    return;
+  }
+  // The last 7 bytes.
+  while (this->cacheBits_ < 56u && this->next_ < this->size_) {
+    this->cache_ |= static_cast<uint64_t>(this->data_[this->next_]) << (56u - this->cacheBits_);
+    ++this->next_;
+    this->cacheBits_ += 8u;
+  }
 }
 
-void BitStreamReader::seekInBytes(size_t posInBytes) {
-  this->reader_.seek(posInBytes);
-  if (!reader_.consumed()) {
-    this->bits_ = this->reader_.readU8();
-    this->posInBits_ = 0;
-  } else {
-    this->bits_ = 0;
-    this->posInBits_ = 8;
+uint64_t BitStreamReader::readUint(size_t const bits) {
+  assert(bits <= 64 && "readUint can read less then or equal to 64 bits.");
+  if (bits <= 56) {
+    return this->take(bits);
   }
+  uint64_t const upper = this->take(bits - 32u);
+  return upper << 32u | this->take(32u);
 }
 
 uint32_t BitStreamReader::readLEB128() {
+  // 4.10.5. leb128(): at most 8 bytes.
   uint64_t value = 0;
-  for(size_t i = 0; i < 8; i++) {
-    uint8_t const v = readU8();
-    value |= static_cast<uint64_t>(v & 0x7fu) << (i*7u);
-    if ( (v & 0x80u) != 0x80u ) {
+  for (size_t i = 0; i < 8; i++) {
+    uint64_t const v = this->take(8);
+    value |= (v & 0x7fu) << (i * 7u);
+    if ((v & 0x80u) == 0) {
       break;
     }
   }
-  return value;
+  return static_cast<uint32_t>(value);
 }
 
 uint32_t BitStreamReader::readUVLC() {
+  // 4.10.3. uvlc(): the number of leading zeros, then that many bits of value.
   uint32_t leadingZeros = 0;
-  while(true) {
-    bool done = readBool();
-    if(done) {
+  while (true) {
+    if (this->cacheBits_ == 0) {
+      this->refill();
+      if (this->cacheBits_ == 0) {
+        throwOverrun();
+      }
+    }
+    uint64_t const unread = this->cache_ & ~(~uint64_t(0) >> this->cacheBits_);
+    if (unread != 0) {
+      uint32_t const zeros = countLeadingZeros(unread);
+      leadingZeros += zeros;
+      // The zeros and the one after them.
+      this->cache_ = (this->cache_ << zeros) << 1u;
+      this->cacheBits_ -= static_cast<uint8_t>(zeros + 1u);
       break;
     }
-    leadingZeros++;
+    leadingZeros += this->cacheBits_;
+    this->cache_ <<= this->cacheBits_;
+    this->cacheBits_ = 0;
   }
-  if(leadingZeros >= 32) {
+  if (leadingZeros >= 32) {
     return 0xffffffff;
   }
-  uint32_t value = 0;
-  uint32_t left = 0;
-  while(left < 8) {
-    value = value << 8u | readU8();
-    left -= 8;
-  }
-  value = value << left | readBits(left);
-  return value + (1u << leadingZeros) - 1u;
+  auto const value = static_cast<uint32_t>(this->take(leadingZeros));
+  return value + ((uint32_t(1) << leadingZeros) - 1u);
 }
 
-uint8_t BitStreamReader::readBits(uint8_t const bits) {
-  assert(bits <= 8 && "readBits can read less then or equal to 8 bits.");
-  uint8_t const nextPosInBits = posInBits_ + bits;
-  if(this->reader_.consumed() && nextPosInBits > 8) {
-    throw std::range_error("Buffer overrun.");
-  }
-  if (nextPosInBits < 8 || (nextPosInBits == 8 && this->reader_.consumed())) {
-    posInBits_ = nextPosInBits;
-    return static_cast<uint8_t>(bits_ >> (8u - posInBits_)) & ((1u << bits)-1u);
-  } else {
-    uint8_t const next = this->reader_.readU8();
-    uint8_t upper = static_cast<uint8_t>(bits_ & ((1u << (8u - posInBits_)) - 1u)) << (posInBits_ + bits - 8u);
-    uint8_t lower = static_cast<uint8_t>(next >> (16u - nextPosInBits)) & ((1u << (posInBits_ + bits - 8u)) - 1u);
-    posInBits_ = nextPosInBits - 8;
-    bits_ = next;
-    return upper | lower;
-  }
-}
-
-bool BitStreamReader::readBool() {
-  return this->readBits(1) == 1u;
-}
-
-uint8_t BitStreamReader::readU8() {
-  return readBits(8);
-}
-
-uint16_t BitStreamReader::readU16() {
-  return
-      static_cast<uint16_t>(static_cast<uint16_t>(readU8()) << 8u) |
-      static_cast<uint16_t>(static_cast<uint16_t>(readU8()) << 0u);
+int32_t BitStreamReader::readSU(size_t const bits) {
+  assert(1 <= bits && bits <= 32 && "readSU can read 1 to 32 bits.");
+  auto const value = static_cast<int64_t>(this->take(bits));
+  int64_t const signMask = int64_t(1) << (bits - 1u);
+  return static_cast<int32_t>((value & signMask) != 0 ? value - 2 * signMask : value);
 }
 
-uint32_t BitStreamReader::readU32() {
-  return
-      static_cast<uint32_t>(readU8()) << 24u |
-      static_cast<uint32_t>(readU8()) << 16u |
-      static_cast<uint32_t>(readU8()) << 8u |
-      static_cast<uint32_t>(readU8()) << 0u;
-}
-
-uint64_t BitStreamReader::readU64() {
-  return
-      static_cast<uint64_t>(readU8()) << 56u |
-      static_cast<uint64_t>(readU8()) << 48u |
-      static_cast<uint64_t>(readU8()) << 40u |
-      static_cast<uint64_t>(readU8()) << 32u |
-      static_cast<uint64_t>(readU8()) << 24u |
-      static_cast<uint64_t>(readU8()) << 16u |
-      static_cast<uint64_t>(readU8()) << 8u |
-      static_cast<uint64_t>(readU8()) << 0u;
+uint32_t BitStreamReader::readNS(uint32_t const n) {
+  assert(n > 0 && "ns(0) has no value to read.");
+  uint32_t const w = 64u - countLeadingZeros(n);
+  uint64_t const m = (uint64_t(1) << w) - n;
+  uint64_t const v = this->take(w - 1u);
+  if (v < m) {
+    return static_cast<uint32_t>(v);
+  }
+  return static_cast<uint32_t>((v << 1u) - m + this->take(1));
 }
 
-uint64_t BitStreamReader::readUint(size_t const bits) {
-  assert(bits <= 64 && "readUint can read less then or equal to 64 bits.");
-  size_t left = bits;
-  uint64_t value = 0u;
-  while(left >= 8) {
-    value = value << 8u | readU8();
-    left -= 8u;
+uint64_t BitStreamReader::readLE(size_t const bytes) {
+  assert(bytes <= 8 && "readLE can read less then or equal to 8 bytes.");
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; i++) {
+    value |= this->take(8) << (i * 8u);
   }
-  value = value << left | readBits(left);
   return value;
 }
 
-}
\ No newline at end of file
+}
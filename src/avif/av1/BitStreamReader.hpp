@@ -4,40 +4,80 @@
 
 #pragma once
 
-#include "../util/StreamReader.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../util/Logger.hpp"
 
 namespace avif::av1 {
 
+// Reads the bits of an OBU stream, most significant bit first.
+// Up to 64 bits are kept in a cache, refilled 8 bytes at a time, so most reads do not touch the buffer.
+// Reading past the end throws std::range_error.
 class BitStreamReader final {
 private:
-  avif::util::StreamReader reader_;
   avif::util::Logger& log_;
+  uint8_t const* const data_;
+  size_t const size_;
 private:
-  uint8_t bits_;
-  uint8_t posInBits_; // Ordinarily, in [0, 7]. 8 means "End of Buffer".
+  // The bytes before this are in the cache, or already read.
+  size_t next_;
+  // The unread bits, from the most significant bit. The bits after them are either zero or the bits that follow in the buffer.
+  uint64_t cache_;
+  // Number of unread bits in cache_. At most 63.
+  uint8_t cacheBits_;
 public:
   BitStreamReader() = delete;
   BitStreamReader(BitStreamReader&&) = delete;
   BitStreamReader(BitStreamReader const&) = delete;
   BitStreamReader& operator=(BitStreamReader&&) = delete;
   BitStreamReader& operator=(BitStreamReader&) = delete;
+  // The buffer must outlive the reader.
   explicit BitStreamReader(avif::util::Logger& log, std::vector<uint8_t> const& buffer);
+  explicit BitStreamReader(avif::util::Logger& log, uint8_t const* data, size_t size);
   ~BitStreamReader() noexcept = default;
 
 public:
-  [[nodiscard]] size_t posInBits() const;
-  [[nodiscard]] size_t posInBytes() const;
+  [[nodiscard]] size_t posInBits() const { return this->next_ * 8u - this->cacheBits_; }
+  [[nodiscard]] size_t posInBytes() const { return this->posInBits() / 8u; }
   void seekInBytes(size_t posInBytes);
-  [[nodiscard]] bool consumed() const;
-  [[nodiscard]] uint8_t  readBits(uint8_t bits);
+  [[nodiscard]] bool consumed() const { return this->next_ >= this->size_ && this->cacheBits_ == 0; }
+  // bits must be 8 or less.
+  [[nodiscard]] uint8_t  readBits(uint8_t bits) { return static_cast<uint8_t>(this->take(bits)); }
+  // bits must be 64 or less.
   [[nodiscard]] uint64_t readUint(size_t bits);
-  [[nodiscard]] bool  readBool();
-  [[nodiscard]] uint8_t  readU8();
-  [[nodiscard]] uint16_t readU16();
-  [[nodiscard]] uint32_t readU32();
-  [[nodiscard]] uint64_t readU64();
+  [[nodiscard]] bool  readBool() { return this->take(1) == 1u; }
+  [[nodiscard]] uint8_t  readU8() { return static_cast<uint8_t>(this->take(8)); }
+  [[nodiscard]] uint16_t readU16() { return static_cast<uint16_t>(this->take(16)); }
+  [[nodiscard]] uint32_t readU32() { return static_cast<uint32_t>(this->take(32)); }
+  [[nodiscard]] uint64_t readU64() { return this->readUint(64); }
   [[nodiscard]] uint32_t readLEB128();
   [[nodiscard]] uint32_t readUVLC();
+  // 4.10.6. su(n): n bits, signed.
+  [[nodiscard]] int32_t readSU(size_t bits);
+  // 4.10.7. ns(n): a number in [0, n), in fewer bits for the smaller values.
+  [[nodiscard]] uint32_t readNS(uint32_t n);
+  // 4.10.4. le(n): n bytes, little-endian.
+  [[nodiscard]] uint64_t readLE(size_t bytes);
+
+private:
+  // Fills the cache with as many whole bytes as fit.
+  void refill();
+  // bits must be 56 or less.
+  uint64_t take(size_t const bits) {
+    if (this->cacheBits_ < bits) {
+      this->refill();
+      if (this->cacheBits_ < bits) {
+        this->throwOverrun();
+      }
+    }
+    // Shifted in two steps, so that 0 bits give 0 instead of shifting by 64.
+    uint64_t const value = (this->cache_ >> 1u) >> (63u - bits);
+    this->cache_ <<= bits;
+    this->cacheBits_ -= static_cast<uint8_t>(bits);
+    return value;
+  }
+  [[noreturn]] static void throwOverrun();
 };
 
 }
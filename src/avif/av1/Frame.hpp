@@ -0,0 +1,18 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include "FrameHeader.hpp"
+#include "TileGroup.hpp"
+
+namespace avif::av1 {
+
+// 5.10. Frame OBU syntax: a frame header and a tile group in one OBU.
+struct Frame final {
+  FrameHeader frameHeader{};
+  TileGroup tileGroup{};
+};
+
+}
@@ -0,0 +1,128 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace avif::av1 {
+
+// 5.9. Frame header OBU syntax, as far as the layout of the frame goes.
+// Loop filter, CDEF, loop restoration, global motion and film grain parameters are read but not kept.
+struct FrameHeader final {
+  enum class FrameType : uint8_t {
+    KeyFrame = 0,
+    InterFrame = 1,
+    IntraOnlyFrame = 2,
+    SwitchFrame = 3,
+  };
+  constexpr static uint8_t PRIMARY_REF_NONE = 7;
+  constexpr static size_t NUM_REF_FRAMES = 8;
+  constexpr static size_t REFS_PER_FRAME = 7;
+  constexpr static size_t MAX_SEGMENTS = 8;
+  constexpr static size_t SEG_LVL_MAX = 8;
+
+  // With show_existing_frame, only frameToShowMapIdx and what is taken from the shown frame (type, id, order hint and sizes) are set.
+  bool showExistingFrame{};
+  uint8_t frameToShowMapIdx{};
+  FrameType frameType{};
+  bool frameIsIntra{};
+  bool showFrame{};
+  bool showableFrame{};
+  bool errorResilientMode{};
+  bool disableCDFUpdate{};
+  bool allowScreenContentTools{};
+  bool forceIntegerMV{};
+  uint32_t currentFrameID{};
+  bool frameSizeOverrideFlag{};
+  uint32_t orderHint{};
+  uint8_t primaryRefFrame{};
+  uint8_t refreshFrameFlags{};
+  // Slots of the reference frames LAST_FRAME to ALTREF_FRAME. Inter frames only.
+  std::array<uint8_t, REFS_PER_FRAME> refFrameIdx{};
+
+  // 5.9.5. - 5.9.8. Frame size, superres and render size.
+  // frameWidth is the coded width; upscaledWidth is the width after superres.
+  uint32_t frameWidth{};
+  uint32_t frameHeight{};
+  uint32_t upscaledWidth{};
+  uint32_t renderWidth{};
+  uint32_t renderHeight{};
+  bool useSuperres{};
+  uint8_t superresDenom{};
+  // In units of 4x4 luma samples.
+  uint32_t miCols{};
+  uint32_t miRows{};
+  bool allowIntrabc{};
+
+  // 5.9.15. Tile info syntax
+  struct TileInfo final {
+    bool uniformTileSpacing{};
+    uint32_t tileCols{};
+    uint32_t tileRows{};
+    uint8_t tileColsLog2{};
+    uint8_t tileRowsLog2{};
+    // tileCols + 1 and tileRows + 1 entries: tile i spans [starts[i], starts[i + 1]) in 4x4 luma samples.
+    std::vector<uint32_t> miColStarts{};
+    std::vector<uint32_t> miRowStarts{};
+    uint32_t contextUpdateTileID{};
+    // Bytes of tile_size_minus_1 in tile groups.
+    uint8_t tileSizeBytes{};
+  };
+  TileInfo tileInfo{};
+
+  // 5.9.12. Quantization params syntax
+  struct QuantizationParams final {
+    uint8_t baseQIdx{};
+    int8_t deltaQYDc{};
+    bool diffUVDelta{};
+    int8_t deltaQUDc{};
+    int8_t deltaQUAc{};
+    int8_t deltaQVDc{};
+    int8_t deltaQVAc{};
+    bool usingQMatrix{};
+    uint8_t qmY{};
+    uint8_t qmU{};
+    uint8_t qmV{};
+  };
+  QuantizationParams quantizationParams{};
+
+  // 5.9.14. Segmentation params syntax. The features are inherited from the primary reference frame unless updated.
+  struct SegmentationParams final {
+    bool enabled{};
+    bool updateMap{};
+    bool temporalUpdate{};
+    bool updateData{};
+    std::array<std::array<bool, SEG_LVL_MAX>, MAX_SEGMENTS> featureEnabled{};
+    std::array<std::array<int16_t, SEG_LVL_MAX>, MAX_SEGMENTS> featureData{};
+  };
+  SegmentationParams segmentationParams{};
+
+  // 5.9.17. and 5.9.18. Delta quantizer and delta loop filter params
+  bool deltaQPresent{};
+  uint8_t deltaQRes{};
+  bool deltaLFPresent{};
+  uint8_t deltaLFRes{};
+  bool deltaLFMulti{};
+
+  // Every segment is coded losslessly.
+  bool codedLossless{};
+  // codedLossless, without superres.
+  bool allLossless{};
+
+  // Tile (col, row) spans these luma samples, clipped to the frame.
+  [[ nodiscard ]] uint32_t tileWidth(size_t const col) const {
+    uint32_t const end = std::min(this->tileInfo.miColStarts.at(col + 1) * 4u, this->frameWidth);
+    return end - std::min(this->tileInfo.miColStarts.at(col) * 4u, end);
+  }
+  [[ nodiscard ]] uint32_t tileHeight(size_t const row) const {
+    uint32_t const end = std::min(this->tileInfo.miRowStarts.at(row + 1) * 4u, this->frameHeight);
+    return end - std::min(this->tileInfo.miRowStarts.at(row) * 4u, end);
+  }
+};
+
+}
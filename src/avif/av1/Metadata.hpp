@@ -0,0 +1,127 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include "../ContentLightLevelBox.hpp"
+#include "../MasteringDisplayColourVolumeBox.hpp"
+
+namespace avif::av1 {
+
+// 5.8. Metadata OBU syntax. Each metadata_type below has a struct of its own in Parser::Result::Packet::Content.
+// Other types, including the unregistered user private ones, are skipped.
+enum class MetadataType : uint32_t {
+  HDR_CLL = 1,
+  HDR_MDCV = 2,
+  SCALABILITY = 3,
+  ITUT_T35 = 4,
+  TIMECODE = 5,
+};
+
+// 5.8.3. Metadata high dynamic range content light level syntax, in cd/m^2 as in ContentLightLevelBox.
+struct MetadataHDRCLL final {
+  uint16_t maxCLL{};
+  uint16_t maxFALL{};
+
+  [[ nodiscard ]] ContentLightLevelBox toBox() const {
+    ContentLightLevelBox box{};
+    box.maxContentLightLevel = this->maxCLL;
+    box.maxPicAverageLightLevel = this->maxFALL;
+    return box;
+  }
+};
+
+// 5.8.4. Metadata high dynamic range mastering display color volume syntax.
+// The units differ from those of MasteringDisplayColourVolumeBox, so use toBox() to compare them.
+struct MetadataHDRMDCV final {
+  // R, G, B in 0.16 fixed point.
+  std::array<uint16_t, 3> primaryChromaticityX{};
+  std::array<uint16_t, 3> primaryChromaticityY{};
+  uint16_t whitePointChromaticityX{};
+  uint16_t whitePointChromaticityY{};
+  // 24.8 fixed point, in cd/m^2.
+  uint32_t luminanceMax{};
+  // 18.14 fixed point, in cd/m^2.
+  uint32_t luminanceMin{};
+
+  // In the units of ISO/IEC 23001-8: chromaticities in 0.00002, luminances in 0.0001 cd/m^2, rounded to the nearest.
+  // MasteringDisplayColourVolumeBox lists the primaries in the order of G, B, R, so they are rotated.
+  [[ nodiscard ]] MasteringDisplayColourVolumeBox toBox() const {
+    auto const chromaticity = [](uint16_t const v) -> uint16_t {
+      return static_cast<uint16_t>((static_cast<uint32_t>(v) * 50000u + 32768u) >> 16u);
+    };
+    MasteringDisplayColourVolumeBox box{};
+    for (size_t c = 0; c < 3; ++c) {
+      box.displayPrimariesX[c] = chromaticity(this->primaryChromaticityX[(c + 1) % 3]);
+      box.displayPrimariesY[c] = chromaticity(this->primaryChromaticityY[(c + 1) % 3]);
+    }
+    box.whitePointX = chromaticity(this->whitePointChromaticityX);
+    box.whitePointY = chromaticity(this->whitePointChromaticityY);
+    box.maxDisplayMasteringLuminance = static_cast<uint32_t>((static_cast<uint64_t>(this->luminanceMax) * 10000u + 128u) >> 8u);
+    box.minDisplayMasteringLuminance = static_cast<uint32_t>((static_cast<uint64_t>(this->luminanceMin) * 10000u + 8192u) >> 14u);
+    return box;
+  }
+};
+
+// 5.8.5. Metadata scalability syntax
+struct MetadataScalability final {
+  constexpr static uint8_t SCALABILITY_SS = 14;
+  uint8_t scalabilityModeIdc{};
+
+  // 5.8.6. Scalability structure syntax, only with SCALABILITY_SS.
+  struct ScalabilityStructure final {
+    uint8_t spatialLayersCntMinus1{};
+    bool spatialLayerDimensionsPresentFlag{};
+    bool spatialLayerDescriptionPresentFlag{};
+    bool temporalGroupDescriptionPresentFlag{};
+    struct SpatialLayer final {
+      // Only with spatialLayerDimensionsPresentFlag.
+      uint16_t maxWidth{};
+      uint16_t maxHeight{};
+      // Only with spatialLayerDescriptionPresentFlag.
+      uint8_t refID{};
+    };
+    std::vector<SpatialLayer> spatialLayers{};
+    struct TemporalGroup final {
+      uint8_t temporalID{};
+      bool temporalSwitchingUpPointFlag{};
+      bool spatialSwitchingUpPointFlag{};
+      std::vector<uint8_t> refPicDiffs{};
+    };
+    std::vector<TemporalGroup> temporalGroups{};
+  };
+  std::optional<ScalabilityStructure> scalabilityStructure{};
+};
+
+// 5.8.2. Metadata ITUT T35 syntax. The payload is kept as is, without the trailing bits.
+struct MetadataITUTT35 final {
+  uint8_t countryCode{};
+  // Only when countryCode is 0xff.
+  std::optional<uint8_t> countryCodeExtensionByte{};
+  std::vector<uint8_t> payloadBytes{};
+};
+
+// 5.8.7. Metadata timecode syntax. With fullTimestampFlag, the seconds, minutes and hours flags are all set.
+// Fields the flags leave out are 0.
+struct MetadataTimecode final {
+  uint8_t countingType{};
+  bool fullTimestampFlag{};
+  bool discontinuityFlag{};
+  bool cntDroppedFlag{};
+  uint16_t nFrames{};
+  bool secondsFlag{};
+  uint8_t secondsValue{};
+  bool minutesFlag{};
+  uint8_t minutesValue{};
+  bool hoursFlag{};
+  uint8_t hoursValue{};
+  uint8_t timeOffsetLength{};
+  uint32_t timeOffsetValue{};
+};
+
+}
@@ -0,0 +1,15 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <stdexcept>
+#include <fmt/format.h>
+#include "OBUScanner.hpp"
+
+namespace avif::av1 {
+
+void OBUScanner::Iterator::throwOutOfRange(size_t const headerOffset, char const* const what) {
+  throw std::out_of_range(fmt::format("OBUScanner: {} of the OBU at {} runs past the end.", what, headerOffset));
+}
+
+}
@@ -0,0 +1,166 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include "Header.hpp"
+
+namespace avif::av1 {
+
+// Where an OBU is, without its payload parsed. Offsets are in bytes, from the beginning of the scanned memory.
+struct OBU final {
+  Header::Type type{};
+  bool extensionFlag{};
+  // 0 unless the OBU has an extension header.
+  uint8_t temporalID{};
+  uint8_t spatialID{};
+  size_t headerOffset{};
+  size_t payloadOffset{};
+  size_t payloadSize{};
+
+  [[ nodiscard ]] size_t end() const noexcept {
+    return this->payloadOffset + this->payloadSize;
+  }
+  [[ nodiscard ]] size_t size() const noexcept {
+    return this->end() - this->headerOffset;
+  }
+};
+
+// Walks the OBU headers of a stream and skips the payloads, for callers that only need the boundaries:
+// stripping padding or metadata, counting frames, and so on. Unlike Parser, it never allocates.
+// An OBU without obu_size extends to the end of the memory, as in Parser.
+// Iterating throws std::out_of_range when a header or a payload runs past the end.
+//
+//   for(avif::av1::OBU const& obu : avif::av1::scanOBUs(data, size)) { ... }
+//
+// The memory must outlive the scanner and its iterators.
+class OBUScanner final {
+public:
+  class Iterator final {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = OBU;
+    using difference_type = std::ptrdiff_t;
+    using pointer = OBU const*;
+    using reference = OBU const&;
+  private:
+    uint8_t const* data_{};
+    size_t size_{};
+    // The OBU at headerOffset == size_ is the end.
+    OBU obu_{};
+  public:
+    Iterator() = default;
+    Iterator(Iterator const&) = default;
+    Iterator(Iterator&&) noexcept = default;
+    Iterator& operator=(Iterator const&) = default;
+    Iterator& operator=(Iterator&&) noexcept = default;
+    ~Iterator() noexcept = default;
+    Iterator(uint8_t const* const data, size_t const size, size_t const offset)
+    :data_(data)
+    ,size_(size)
+    {
+      this->scan(offset);
+    }
+  public:
+    [[ nodiscard ]] OBU const& operator*() const noexcept { return this->obu_; }
+    [[ nodiscard ]] OBU const* operator->() const noexcept { return &this->obu_; }
+    Iterator& operator++() {
+      this->scan(this->obu_.end());
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator const prev = *this;
+      ++*this;
+      return prev;
+    }
+    [[ nodiscard ]] bool operator==(Iterator const& other) const noexcept {
+      return this->obu_.headerOffset == other.obu_.headerOffset;
+    }
+    [[ nodiscard ]] bool operator!=(Iterator const& other) const noexcept {
+      return !(*this == other);
+    }
+  private:
+    // 5.3.1. General OBU syntax, up to the payload.
+    void scan(size_t pos) {
+      this->obu_ = OBU{};
+      this->obu_.headerOffset = pos;
+      if (pos >= this->size_) {
+        this->obu_.headerOffset = this->size_;
+        return;
+      }
+      uint8_t const header = this->data_[pos++];
+      bool const hasSizeField = (header & 0x02u) != 0;
+      this->obu_.type = static_cast<Header::Type>((header >> 3u) & 0x0fu);
+      this->obu_.extensionFlag = (header & 0x04u) != 0;
+      if (this->obu_.extensionFlag) {
+        if (pos >= this->size_) {
+          throwOutOfRange(this->obu_.headerOffset, "extension header");
+        }
+        uint8_t const ext = this->data_[pos++];
+        this->obu_.temporalID = ext >> 5u;
+        this->obu_.spatialID = (ext >> 3u) & 0x03u;
+      }
+      size_t payloadSize = 0;
+      if (hasSizeField) {
+        uint64_t obuSize = 0;
+        // 4.10.5. leb128(): at most 8 bytes.
+        for (size_t i = 0; ; ++i) {
+          if (i == 8 || pos >= this->size_) {
+            throwOutOfRange(this->obu_.headerOffset, "obu_size");
+          }
+          uint8_t const byte = this->data_[pos++];
+          obuSize |= static_cast<uint64_t>(byte & 0x7fu) << (i * 7u);
+          if ((byte & 0x80u) == 0) {
+            break;
+          }
+        }
+        if (obuSize > this->size_ - pos) {
+          throwOutOfRange(this->obu_.headerOffset, "payload");
+        }
+        payloadSize = static_cast<size_t>(obuSize);
+      } else {
+        payloadSize = this->size_ - pos;
+      }
+      this->obu_.payloadOffset = pos;
+      this->obu_.payloadSize = payloadSize;
+    }
+    [[noreturn]] static void throwOutOfRange(size_t headerOffset, char const* what);
+  };
+private:
+  uint8_t const* data_;
+  size_t size_;
+public:
+  OBUScanner() = delete;
+  OBUScanner(OBUScanner const&) = default;
+  OBUScanner(OBUScanner&&) noexcept = default;
+  OBUScanner& operator=(OBUScanner const&) = default;
+  OBUScanner& operator=(OBUScanner&&) noexcept = default;
+  ~OBUScanner() noexcept = default;
+  OBUScanner(uint8_t const* const data, size_t const size)
+  :data_(data)
+  ,size_(size)
+  {
+  }
+public:
+  [[ nodiscard ]] Iterator begin() const {
+    return Iterator(this->data_, this->size_, 0);
+  }
+  [[ nodiscard ]] Iterator end() const {
+    return Iterator(this->data_, this->size_, this->size_);
+  }
+};
+
+[[ nodiscard ]] inline OBUScanner scanOBUs(uint8_t const* const data, size_t const size) {
+  return OBUScanner(data, size);
+}
+
+[[ nodiscard ]] inline OBUScanner scanOBUs(std::vector<uint8_t> const& buffer) {
+  return OBUScanner(buffer.data(), buffer.size());
+}
+
+}
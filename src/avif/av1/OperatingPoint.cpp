@@ -0,0 +1,87 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "OperatingPoint.hpp"
+#include "Parser.hpp"
+#include "Query.hpp"
+
+namespace avif::av1 {
+
+avif::util::Buffer extractOperatingPoint(avif::util::Buffer const& buffer, SequenceHeader const& shdr, size_t const operatingPoint) {
+  if (operatingPoint >= shdr.operatingPoints.size()) {
+    throw std::out_of_range(fmt::format("Operating point {} is not in the sequence header, which has {}.", operatingPoint, shdr.operatingPoints.size()));
+  }
+  uint16_t const idc = shdr.operatingPoints[operatingPoint].idc;
+  OBUScanner const scanner = scanOBUs(buffer.data(), buffer.size());
+
+  // First, find the runs of OBUs to keep.
+  size_t runs = 0;
+  size_t runBeg = 0;
+  size_t runEnd = 0;
+  size_t size = 0;
+  for (OBU const& obu : scanner) {
+    if (!isInOperatingPoint(idc, obu)) {
+      continue;
+    }
+    if (runs == 0 || runEnd != obu.headerOffset) {
+      runs++;
+      runBeg = obu.headerOffset;
+    }
+    runEnd = obu.end();
+    size += obu.size();
+  }
+  if (runs == 0) {
+    return avif::util::Buffer();
+  }
+  if (runs == 1) {
+    return buffer.slice(runBeg, runEnd - runBeg);
+  }
+
+  // Then copy them, a run at a time.
+  std::vector<uint8_t> extracted;
+  extracted.reserve(size);
+  auto const append = [&](size_t const beg, size_t const end) {
+    extracted.insert(extracted.end(), buffer.data() + beg, buffer.data() + end);
+  };
+  bool inRun = false;
+  for (OBU const& obu : scanner) {
+    if (!isInOperatingPoint(idc, obu)) {
+      if (inRun) {
+        append(runBeg, runEnd);
+        inRun = false;
+      }
+      continue;
+    }
+    if (!inRun) {
+      runBeg = obu.headerOffset;
+      inRun = true;
+    }
+    runEnd = obu.end();
+  }
+  if (inRun) {
+    append(runBeg, runEnd);
+  }
+  return avif::util::Buffer(std::move(extracted));
+}
+
+avif::util::Buffer extractOperatingPoint(avif::util::Logger& log, avif::util::Buffer const& buffer, size_t const operatingPoint) {
+  for (OBU const& obu : scanOBUs(buffer.data(), buffer.size())) {
+    if (obu.type != Header::Type::SequenceHeader) {
+      continue;
+    }
+    Parser parser(log, std::vector<uint8_t>(buffer.data() + obu.headerOffset, buffer.data() + obu.end()));
+    std::shared_ptr<Parser::Result> const result = parser.parse();
+    if (!result->ok()) {
+      throw std::invalid_argument(fmt::format("Failed to parse the sequence header: {}", result->error()));
+    }
+    std::optional<SequenceHeader> const shdr = util::query::find<SequenceHeader>(result->packets());
+    return extractOperatingPoint(buffer, shdr.value(), operatingPoint);
+  }
+  throw std::invalid_argument("No sequence header in the buffer.");
+}
+
+}
@@ -0,0 +1,48 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "../util/Buffer.hpp"
+#include "../util/Logger.hpp"
+#include "Header.hpp"
+#include "SequenceHeader.hpp"
+#include "OBUScanner.hpp"
+
+namespace avif::av1 {
+
+// Whether the layer of temporalID and spatialID is a part of the operating point of idc (operating_point_idc).
+// idc 0 means that the stream has no layers, so every layer is a part of it.
+constexpr bool isInOperatingPoint(uint16_t const idc, uint8_t const temporalID, uint8_t const spatialID) noexcept {
+  if (idc == 0) {
+    return true;
+  }
+  bool const inTemporalLayer = ((idc >> temporalID) & 1u) == 1u;
+  bool const inSpatialLayer = ((idc >> (spatialID + 8u)) & 1u) == 1u;
+  return inTemporalLayer && inSpatialLayer;
+}
+
+// 7.5. Ordering of OBUs: the decoder drops OBUs with an extension header whose layer is not in the operating point.
+// Sequence headers, temporal delimiters and OBUs without extension headers are always kept.
+constexpr bool isInOperatingPoint(uint16_t const idc, OBU const& obu) noexcept {
+  if (obu.type == Header::Type::SequenceHeader || obu.type == Header::Type::TemporalDelimiter || !obu.extensionFlag) {
+    return true;
+  }
+  return isInOperatingPoint(idc, obu.temporalID, obu.spatialID);
+}
+
+// The OBUs of the operating point, e.g. the low resolution spatial layer of a layered image, as a stream of their own.
+// operatingPoint is an index into shdr.operatingPoints; 0 is what decoders choose by default, usually every layer.
+// The OBUs are copied as they are into a new buffer. When they are all in one run, as in streams
+// without layers, the result is a slice of "buffer" instead, and nothing is copied.
+// Throws std::out_of_range if the operating point is not in the sequence header, or if an OBU runs past the end.
+avif::util::Buffer extractOperatingPoint(avif::util::Buffer const& buffer, SequenceHeader const& shdr, size_t operatingPoint);
+
+// The same, with the first sequence header in "buffer".
+// Throws std::invalid_argument if there is none, or it is broken.
+avif::util::Buffer extractOperatingPoint(avif::util::Logger& log, avif::util::Buffer const& buffer, size_t operatingPoint);
+
+}
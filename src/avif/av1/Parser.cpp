@@ -2,15 +2,22 @@
 // Created by psi on 2020/01/05.
 //
 
+#include <stdexcept>
 #include "Parser.hpp"
 #include "../img/color/Matrix.hpp"
 
 namespace avif::av1 {
 
 Parser::Parser(util::Logger& log, std::vector<uint8_t> buffer)
+:Parser(log, std::move(buffer), 0)
+{
+}
+
+Parser::Parser(util::Logger& log, std::vector<uint8_t> buffer, size_t const operatingPoint)
 :log_(log)
 ,buffer_(std::move(buffer))
 ,reader_(log, buffer_)
+,operatingPoint_(operatingPoint)
 {
 }
 
@@ -42,40 +49,118 @@ std::optional<Parser::Result::Packet> Parser::parsePacket() {
   Header hdr = parseHeader();
   uint32_t const size = hdr.hasSizeField ? readLEB128() : ((buffer_.size() - beg) - 1 - (hdr.extensionFlag ? 1 : 0));
   size_t const startPositionInBytes = posInBytes();
+  if (size > this->buffer_.size() - startPositionInBytes) {
+    throw Error("OBU at {} with {} bytes of payload runs past the end of the stream, which has {} bytes.", beg, size, this->buffer_.size());
+  }
   size_t const end = startPositionInBytes + size;
   size_t const startPosition = posInBits();
   if(
       hdr.type != Header::Type::SequenceHeader && hdr.type != Header::Type::TemporalDelimiter &&
       this->OperatingPointIdc != 0 && hdr.extensionFlag) {
     ExtensionHeader ehdr = hdr.extensionHeader.value();
-    bool const inTemporalLayer = (static_cast<uint16_t>(OperatingPointIdc >> ehdr.temporalID ) & 1u) == 1u;
-    bool const inSpatialLayer = (static_cast<uint16_t>(OperatingPointIdc >> (ehdr.spatialID + 8u)) & 1u) == 1u;
-    if( !inTemporalLayer || !inSpatialLayer) {
+    if(!isInOperatingPoint(this->OperatingPointIdc, ehdr.temporalID, ehdr.spatialID)) {
       seekInBytes(end);
       return std::optional<Parser::Result::Packet>();
     }
   }
   bool skipTrailingCheck = false; // To skip unnecessary packets without errors.
+  // A broken frame or metadata does not keep the sequence header and the other OBUs from being read,
+  // so the OBU is dropped with a warning. Broken sequence headers still fail the stream.
+  auto const parseOrDrop = [&](char const* const what, auto&& parse) -> bool {
+    try {
+      parse();
+      return true;
+    } catch (Error& err) {
+      this->log_.warn("Dropping the broken {} OBU at {}: {}", what, beg, err.msg());
+    } catch (std::range_error& err) {
+      this->log_.warn("Dropping the broken {} OBU at {}: {}", what, beg, err.what());
+    }
+    this->seekInBytes(end);
+    return false;
+  };
   Result::Packet::Content content;
   switch(hdr.type) {
     case Header::Type::Reserved:
       break;
-    case Header::Type::SequenceHeader:
-      content = this->parseSequenceHeader();
+    case Header::Type::SequenceHeader: {
+      SequenceHeader shdr = this->parseSequenceHeader();
+      if (this->operatingPoint_ >= shdr.operatingPoints.size()) {
+        throw Error("Operating point {} is not in the sequence header, which has {}.", this->operatingPoint_, shdr.operatingPoints.size());
+      }
+      // 7.5. choose_operating_point()
+      this->OperatingPointIdc = shdr.operatingPoints[this->operatingPoint_].idc;
+      this->sequenceHeader_ = shdr;
+      content = std::move(shdr);
       break;
+    }
     case Header::Type::TemporalDelimiter:
       // 5.6.
       // Note: The temporal delimiter has an empty payload.
       if(size != 0) {
         throw Error("Invalid temporal delimiter with size={}", size);
       }
+      this->frameHeader_.reset();
       content = TemporalDelimiter();
       break;
     case Header::Type::FrameHeader:
+    case Header::Type::RedunduntFrameHeader:
+      if (!this->sequenceHeader_.has_value()) {
+        this->seekInBytes(end);
+        skipTrailingCheck = true;
+      } else if (this->frameHeader_.has_value()) {
+        // 5.9.1. frame_header_copy(): the same header again, for the frame being decoded.
+        content = this->frameHeader_.value();
+        this->seekInBytes(end);
+        skipTrailingCheck = true;
+      } else {
+        bool const parsed = parseOrDrop("frame header", [&] {
+          content = this->parseFrameHeader(hdr);
+          this->trailingBits(startPosition, size);
+        });
+        if (!parsed) {
+          // Its tile groups cannot be read either.
+          this->frameHeader_.reset();
+          return std::optional<Parser::Result::Packet>();
+        }
+      }
+      skipTrailingCheck = true;
+      break;
+    case Header::Type::Frame:
+      if (!this->sequenceHeader_.has_value()) {
+        this->seekInBytes(end);
+      } else {
+        bool const parsed = parseOrDrop("frame", [&] {
+          Frame frame{};
+          frame.frameHeader = this->parseFrameHeader(hdr);
+          if (frame.frameHeader.showExistingFrame) {
+            throw Error("A frame OBU must not show an existing frame.");
+          }
+          this->byteAlignment();
+          frame.tileGroup = this->parseTileGroup(frame.frameHeader, end);
+          content = std::move(frame);
+        });
+        if (!parsed) {
+          this->frameHeader_.reset();
+          return std::optional<Parser::Result::Packet>();
+        }
+      }
+      skipTrailingCheck = true;
+      break;
     case Header::Type::TileGroup:
+      if (!this->frameHeader_.has_value()) {
+        this->seekInBytes(end);
+      } else if (!parseOrDrop("tile group", [&] { content = this->parseTileGroup(this->frameHeader_.value(), end); })) {
+        this->frameHeader_.reset();
+        return std::optional<Parser::Result::Packet>();
+      }
+      skipTrailingCheck = true;
+      break;
     case Header::Type::Metadata:
-    case Header::Type::Frame:
-    case Header::Type::RedunduntFrameHeader:
+      if (!parseOrDrop("metadata", [&] { content = this->parseMetadata(startPosition, size, end); })) {
+        return std::optional<Parser::Result::Packet>();
+      }
+      skipTrailingCheck = true;
+      break;
     case Header::Type::TileList:
       this->seekInBytes(startPositionInBytes + size);
       skipTrailingCheck = true;
@@ -89,29 +174,15 @@ std::optional<Parser::Result::Packet> Parser::parsePacket() {
   }
   size_t const currentPosition = this->posInBits();
   size_t const payloadBits = currentPosition - startPosition;
+  if (payloadBits > size * 8u) {
+    throw Error("OBU at {} with {} bytes of payload is shorter than its syntax.", beg, size);
+  }
   if (!skipTrailingCheck &&
       size > 0 &&
       hdr.type != Header::Type::TileGroup &&
       hdr.type != Header::Type::TileList &&
       hdr.type != Header::Type::Frame) {
-    size_t bitsToRead = size * 8 - payloadBits;
-    // 5.3.4. Trailing bits syntax
-    uint8_t const trailingOneBit = readBits(1);
-    if(trailingOneBit != 1u) {
-      throw Error("trailing_one_bit must be 1, but got 0. Is that a corrupted file?");
-    }
-    bitsToRead--;
-    while(bitsToRead >= 8u) {
-      uint8_t const zero = this->readU8();
-      if(zero != 0u) {
-        throw Error("trailing_zero_bit must be 0, but got {}. Is that a corrupted file?", zero);
-      }
-      bitsToRead -= 8u;
-    }
-    uint8_t const zero = this->readBits(bitsToRead);
-    if(zero != 0u) {
-      throw Error("trailing_zero_bit must be 0, but got {}. Is that a corrupted file?", zero);
-    }
+    this->trailingBits(startPosition, size);
   }
   seekInBytes(end);
   return Result::Packet(beg, end, hdr, std::move(content));
@@ -128,7 +199,7 @@ Header Parser::parseHeader() {
     ExtensionHeader ehdr{};
     ehdr.temporalID = readBits(3);
     ehdr.spatialID = readBits(2);
-    ehdr.spatialID = readBits(3);
+    ehdr.extensionHeaderReserved3bits = readBits(3);
     hdr.extensionHeader = ehdr;
   }
   return hdr;
@@ -239,12 +310,12 @@ SequenceHeader Parser::parseSequenceHeader() {
     } else {
       shdr.seqForceScreenContentTools = readBits(1);
     }
-    if (shdr.seqChooseScreenContentTools > 0) {
+    if (shdr.seqForceScreenContentTools > 0) {
       shdr.seqChooseIntegerMV = readBool();
       if (shdr.seqChooseIntegerMV) {
         shdr.seqForceIntegerMV = SequenceHeader::SELECT_INTEGER_MV;
       } else {
-        shdr.seqForceIntegerMV = readBool();
+        shdr.seqForceIntegerMV = readBits(1);
       }
     } else {
       shdr.seqForceIntegerMV = SequenceHeader::SELECT_INTEGER_MV;
@@ -347,4 +418,1052 @@ SequenceHeader::ColorConfig Parser::parseColorConfig(SequenceHeader const& shdr)
   return cfg;
 }
 
-}
\ No newline at end of file
+void Parser::trailingBits(size_t const startPosition, size_t const size) {
+  size_t const payloadBits = this->posInBits() - startPosition;
+  if (payloadBits > size * 8u) {
+    throw Error("The payload of {} bytes is shorter than its syntax.", size);
+  }
+  // trailing_one_bit needs a bit of its own.
+  if (payloadBits == size * 8u) {
+    throw Error("The payload of {} bytes has no room for its trailing bits.", size);
+  }
+  size_t bitsToRead = size * 8 - payloadBits;
+  uint8_t const trailingOneBit = readBits(1);
+  if(trailingOneBit != 1u) {
+    throw Error("trailing_one_bit must be 1, but got 0. Is that a corrupted file?");
+  }
+  bitsToRead--;
+  while(bitsToRead >= 8u) {
+    uint8_t const zero = this->readU8();
+    if(zero != 0u) {
+      throw Error("trailing_zero_bit must be 0, but got {}. Is that a corrupted file?", zero);
+    }
+    bitsToRead -= 8u;
+  }
+  uint8_t const zero = this->readBits(bitsToRead);
+  if(zero != 0u) {
+    throw Error("trailing_zero_bit must be 0, but got {}. Is that a corrupted file?", zero);
+  }
+}
+
+void Parser::byteAlignment() {
+  while ((this->posInBits() & 7u) != 0) {
+    if (this->readBool()) {
+      throw Error("zero_bit must be 0, but got 1. Is that a corrupted file?");
+    }
+  }
+}
+
+int32_t Parser::relativeDist(SequenceHeader const& shdr, uint32_t const a, uint32_t const b) const {
+  // 7.12.3. get_relative_dist()
+  if (!shdr.enableOrderHint) {
+    return 0;
+  }
+  int32_t const diff = static_cast<int32_t>(a) - static_cast<int32_t>(b);
+  int32_t const m = 1 << (shdr.orderHintBits - 1u);
+  return (diff & (m - 1)) - (diff & m);
+}
+
+FrameHeader Parser::parseFrameHeader(Header const& hdr) {
+  // 5.9.2. Uncompressed header syntax
+  SequenceHeader const& shdr = this->sequenceHeader_.value();
+  FrameHeader fhdr{};
+  uint8_t const allFrames = 0xff;
+  size_t idLen = 0;
+  if (shdr.frameIDNumbersPresentFlag) {
+    idLen = shdr.additionalFrameIDLength.value() + shdr.deltaFrameIDLength.value();
+  }
+  bool const equalPictureInterval = shdr.timingInfo.has_value() && shdr.timingInfo->equalPictureInterval;
+  if (shdr.reducedStillPictureHeader) {
+    fhdr.showExistingFrame = false;
+    fhdr.frameType = FrameHeader::FrameType::KeyFrame;
+    fhdr.frameIsIntra = true;
+    fhdr.showFrame = true;
+    fhdr.showableFrame = false;
+  } else {
+    fhdr.showExistingFrame = readBool();
+    if (fhdr.showExistingFrame) {
+      fhdr.frameToShowMapIdx = readBits(3);
+      if (shdr.decoderModelInfoPresentFlag && !equalPictureInterval) {
+        // temporal_point_info(): frame_presentation_time
+        static_cast<void>(readUint(shdr.decoderModelInfo->framePresentationTimeLength));
+      }
+      if (shdr.frameIDNumbersPresentFlag) {
+        // display_frame_id
+        static_cast<void>(readUint(idLen));
+      }
+      RefFrame const shown = this->refFrames_[fhdr.frameToShowMapIdx];
+      fhdr.frameType = shown.frameType;
+      fhdr.frameIsIntra = shown.frameType == FrameHeader::FrameType::KeyFrame || shown.frameType == FrameHeader::FrameType::IntraOnlyFrame;
+      fhdr.showFrame = true;
+      fhdr.currentFrameID = shown.frameID;
+      fhdr.orderHint = shown.orderHint;
+      fhdr.upscaledWidth = shown.upscaledWidth;
+      fhdr.frameWidth = shown.frameWidth;
+      fhdr.frameHeight = shown.frameHeight;
+      fhdr.renderWidth = shown.renderWidth;
+      fhdr.renderHeight = shown.renderHeight;
+      fhdr.miCols = shown.miCols;
+      fhdr.miRows = shown.miRows;
+      fhdr.refreshFrameFlags = fhdr.frameType == FrameHeader::FrameType::KeyFrame ? allFrames : 0;
+      // 7.21. Reference frame loading process: the shown key frame becomes every reference.
+      if (fhdr.refreshFrameFlags == allFrames) {
+        this->refFrames_.fill(shown);
+      }
+      return fhdr;
+    }
+    fhdr.frameType = static_cast<FrameHeader::FrameType>(readBits(2));
+    fhdr.frameIsIntra = fhdr.frameType == FrameHeader::FrameType::IntraOnlyFrame || fhdr.frameType == FrameHeader::FrameType::KeyFrame;
+    fhdr.showFrame = readBool();
+    if (fhdr.showFrame && shdr.decoderModelInfoPresentFlag && !equalPictureInterval) {
+      // temporal_point_info(): frame_presentation_time
+      static_cast<void>(readUint(shdr.decoderModelInfo->framePresentationTimeLength));
+    }
+    if (fhdr.showFrame) {
+      fhdr.showableFrame = fhdr.frameType != FrameHeader::FrameType::KeyFrame;
+    } else {
+      fhdr.showableFrame = readBool();
+    }
+    if (fhdr.frameType == FrameHeader::FrameType::SwitchFrame || (fhdr.frameType == FrameHeader::FrameType::KeyFrame && fhdr.showFrame)) {
+      fhdr.errorResilientMode = true;
+    } else {
+      fhdr.errorResilientMode = readBool();
+    }
+  }
+  if (fhdr.frameType == FrameHeader::FrameType::KeyFrame && fhdr.showFrame) {
+    for (RefFrame& ref : this->refFrames_) {
+      ref.orderHint = 0;
+    }
+  }
+  fhdr.disableCDFUpdate = readBool();
+  if (shdr.seqForceScreenContentTools == SequenceHeader::SELECT_SCREEN_CONTENT_TOOLS) {
+    fhdr.allowScreenContentTools = readBool();
+  } else {
+    fhdr.allowScreenContentTools = shdr.seqForceScreenContentTools != 0;
+  }
+  if (fhdr.allowScreenContentTools) {
+    if (shdr.seqForceIntegerMV == SequenceHeader::SELECT_INTEGER_MV) {
+      fhdr.forceIntegerMV = readBool();
+    } else {
+      fhdr.forceIntegerMV = shdr.seqForceIntegerMV != 0;
+    }
+  } else {
+    fhdr.forceIntegerMV = false;
+  }
+  if (fhdr.frameIsIntra) {
+    fhdr.forceIntegerMV = true;
+  }
+  if (shdr.frameIDNumbersPresentFlag) {
+    fhdr.currentFrameID = readUint(idLen);
+  } else {
+    fhdr.currentFrameID = 0;
+  }
+  if (fhdr.frameType == FrameHeader::FrameType::SwitchFrame) {
+    fhdr.frameSizeOverrideFlag = true;
+  } else if (shdr.reducedStillPictureHeader) {
+    fhdr.frameSizeOverrideFlag = false;
+  } else {
+    fhdr.frameSizeOverrideFlag = readBool();
+  }
+  fhdr.orderHint = readUint(shdr.orderHintBits);
+  if (fhdr.frameIsIntra || fhdr.errorResilientMode) {
+    fhdr.primaryRefFrame = FrameHeader::PRIMARY_REF_NONE;
+  } else {
+    fhdr.primaryRefFrame = readBits(3);
+  }
+  if (shdr.decoderModelInfoPresentFlag) {
+    bool const bufferRemovalTimePresentFlag = readBool();
+    if (bufferRemovalTimePresentFlag) {
+      uint8_t const temporalID = hdr.extensionHeader.has_value() ? hdr.extensionHeader->temporalID : 0;
+      uint8_t const spatialID = hdr.extensionHeader.has_value() ? hdr.extensionHeader->spatialID : 0;
+      for (SequenceHeader::OperatingPoint const& pt : shdr.operatingPoints) {
+        if (pt.decoderModelPresentFlag) {
+          if (isInOperatingPoint(pt.idc, temporalID, spatialID)) {
+            // buffer_removal_time
+            static_cast<void>(readUint(shdr.decoderModelInfo->bufferRemovalTimeLength));
+          }
+        }
+      }
+    }
+  }
+  bool allowHighPrecisionMV = false;
+  if (fhdr.frameType == FrameHeader::FrameType::SwitchFrame || (fhdr.frameType == FrameHeader::FrameType::KeyFrame && fhdr.showFrame)) {
+    fhdr.refreshFrameFlags = allFrames;
+  } else {
+    fhdr.refreshFrameFlags = readU8();
+  }
+  if (!fhdr.frameIsIntra || fhdr.refreshFrameFlags != allFrames) {
+    if (fhdr.errorResilientMode && shdr.enableOrderHint) {
+      for (RefFrame& ref : this->refFrames_) {
+        // ref_order_hint: a frame with this order hint is missing, and stands in for it.
+        ref.orderHint = readUint(shdr.orderHintBits);
+      }
+    }
+  }
+  if (fhdr.frameIsIntra) {
+    this->parseFrameSize(shdr, fhdr);
+    this->parseRenderSize(fhdr);
+    if (fhdr.allowScreenContentTools && fhdr.upscaledWidth == fhdr.frameWidth) {
+      fhdr.allowIntrabc = readBool();
+    }
+  } else {
+    bool frameRefsShortSignaling = false;
+    if (shdr.enableOrderHint) {
+      frameRefsShortSignaling = readBool();
+      if (frameRefsShortSignaling) {
+        uint8_t const lastFrameIdx = readBits(3);
+        uint8_t const goldFrameIdx = readBits(3);
+        this->setFrameRefs(shdr, fhdr, lastFrameIdx, goldFrameIdx);
+      }
+    }
+    for (size_t i = 0; i < FrameHeader::REFS_PER_FRAME; ++i) {
+      if (!frameRefsShortSignaling) {
+        fhdr.refFrameIdx[i] = readBits(3);
+      }
+      if (shdr.frameIDNumbersPresentFlag) {
+        // delta_frame_id_minus_1
+        static_cast<void>(readUint(shdr.deltaFrameIDLength.value()));
+      }
+    }
+    if (fhdr.frameSizeOverrideFlag && !fhdr.errorResilientMode) {
+      this->parseFrameSizeWithRefs(shdr, fhdr);
+    } else {
+      this->parseFrameSize(shdr, fhdr);
+      this->parseRenderSize(fhdr);
+    }
+    if (fhdr.forceIntegerMV) {
+      allowHighPrecisionMV = false;
+    } else {
+      allowHighPrecisionMV = readBool();
+    }
+    // read_interpolation_filter()
+    bool const isFilterSwitchable = readBool();
+    if (!isFilterSwitchable) {
+      static_cast<void>(readBits(2));
+    }
+    // is_motion_mode_switchable
+    static_cast<void>(readBool());
+    if (!fhdr.errorResilientMode && shdr.enableRefFrameMVS) {
+      // use_ref_frame_mvs
+      static_cast<void>(readBool());
+    }
+  }
+  if (!shdr.reducedStillPictureHeader && !fhdr.disableCDFUpdate) {
+    // disable_frame_end_update_cdf
+    static_cast<void>(readBool());
+  }
+  fhdr.tileInfo = this->parseTileInfo(shdr, fhdr);
+  fhdr.quantizationParams = this->parseQuantizationParams(shdr);
+  fhdr.segmentationParams = this->parseSegmentationParams(fhdr);
+  // 5.9.17. Quantizer index delta parameters syntax
+  if (fhdr.quantizationParams.baseQIdx > 0) {
+    fhdr.deltaQPresent = readBool();
+  }
+  if (fhdr.deltaQPresent) {
+    fhdr.deltaQRes = readBits(2);
+  }
+  // 5.9.18. Loop filter delta parameters syntax
+  if (fhdr.deltaQPresent) {
+    if (!fhdr.allowIntrabc) {
+      fhdr.deltaLFPresent = readBool();
+    }
+    if (fhdr.deltaLFPresent) {
+      fhdr.deltaLFRes = readBits(2);
+      fhdr.deltaLFMulti = readBool();
+    }
+  }
+  // 7.12.2. Dequantization functions: get_qindex(1, segmentId) of every segment.
+  FrameHeader::QuantizationParams const& q = fhdr.quantizationParams;
+  bool const noDeltas = q.deltaQYDc == 0 && q.deltaQUAc == 0 && q.deltaQUDc == 0 && q.deltaQVAc == 0 && q.deltaQVDc == 0;
+  fhdr.codedLossless = true;
+  for (size_t segmentID = 0; segmentID < FrameHeader::MAX_SEGMENTS; ++segmentID) {
+    int32_t qindex = q.baseQIdx;
+    if (fhdr.segmentationParams.enabled && fhdr.segmentationParams.featureEnabled[segmentID][0]) {
+      qindex = std::clamp(qindex + fhdr.segmentationParams.featureData[segmentID][0], 0, 255);
+    }
+    if (qindex != 0 || !noDeltas) {
+      fhdr.codedLossless = false;
+    }
+  }
+  fhdr.allLossless = fhdr.codedLossless && fhdr.frameWidth == fhdr.upscaledWidth;
+  this->parseLoopFilterParams(shdr, fhdr);
+  this->parseCDEFParams(shdr, fhdr);
+  this->parseLRParams(shdr, fhdr);
+  // read_tx_mode(): tx_mode_select
+  if (!fhdr.codedLossless) {
+    static_cast<void>(readBool());
+  }
+  // frame_reference_mode(): reference_select
+  bool const referenceSelect = fhdr.frameIsIntra ? false : readBool();
+  this->parseSkipModeParams(shdr, fhdr, referenceSelect);
+  if (!fhdr.frameIsIntra && !fhdr.errorResilientMode && shdr.enableWarpedMotion) {
+    // allow_warped_motion
+    static_cast<void>(readBool());
+  }
+  // reduced_tx_set
+  static_cast<void>(readBool());
+  this->parseGlobalMotionParams(fhdr, allowHighPrecisionMV);
+  this->parseFilmGrainParams(shdr, fhdr);
+
+  this->updateRefFrames(fhdr);
+  this->frameHeader_ = fhdr;
+  return fhdr;
+}
+
+void Parser::parseFrameSize(SequenceHeader const& shdr, FrameHeader& fhdr) {
+  // 5.9.5. Frame size syntax
+  if (fhdr.frameSizeOverrideFlag) {
+    fhdr.frameWidth = readUint(shdr.frameWidthBits) + 1;
+    fhdr.frameHeight = readUint(shdr.frameHeightBits) + 1;
+  } else {
+    fhdr.frameWidth = shdr.maxFrameWidth;
+    fhdr.frameHeight = shdr.maxFrameHeight;
+  }
+  this->parseSuperresParams(shdr, fhdr);
+}
+
+void Parser::parseSuperresParams(SequenceHeader const& shdr, FrameHeader& fhdr) {
+  // 5.9.8. Superres params syntax, then 7.4. compute_image_size()
+  constexpr uint32_t SUPERRES_NUM = 8;
+  constexpr uint32_t SUPERRES_DENOM_MIN = 9;
+  constexpr uint32_t SUPERRES_DENOM_BITS = 3;
+  fhdr.useSuperres = shdr.enableSuperres ? readBool() : false;
+  if (fhdr.useSuperres) {
+    fhdr.superresDenom = readBits(SUPERRES_DENOM_BITS) + SUPERRES_DENOM_MIN;
+  } else {
+    fhdr.superresDenom = SUPERRES_NUM;
+  }
+  fhdr.upscaledWidth = fhdr.frameWidth;
+  fhdr.frameWidth = (fhdr.upscaledWidth * SUPERRES_NUM + (fhdr.superresDenom / 2u)) / fhdr.superresDenom;
+  fhdr.miCols = 2u * ((fhdr.frameWidth + 7u) >> 3u);
+  fhdr.miRows = 2u * ((fhdr.frameHeight + 7u) >> 3u);
+}
+
+void Parser::parseRenderSize(FrameHeader& fhdr) {
+  // 5.9.6. Render size syntax
+  bool const renderAndFrameSizeDifferent = readBool();
+  if (renderAndFrameSizeDifferent) {
+    fhdr.renderWidth = readU16() + 1u;
+    fhdr.renderHeight = readU16() + 1u;
+  } else {
+    fhdr.renderWidth = fhdr.upscaledWidth;
+    fhdr.renderHeight = fhdr.frameHeight;
+  }
+}
+
+void Parser::parseFrameSizeWithRefs(SequenceHeader const& shdr, FrameHeader& fhdr) {
+  // 5.9.7. Frame size with refs syntax
+  for (size_t i = 0; i < FrameHeader::REFS_PER_FRAME; ++i) {
+    bool const foundRef = readBool();
+    if (foundRef) {
+      RefFrame const& ref = this->refFrames_[fhdr.refFrameIdx[i]];
+      fhdr.frameWidth = ref.upscaledWidth;
+      fhdr.frameHeight = ref.frameHeight;
+      fhdr.renderWidth = ref.renderWidth;
+      fhdr.renderHeight = ref.renderHeight;
+      this->parseSuperresParams(shdr, fhdr);
+      return;
+    }
+  }
+  this->parseFrameSize(shdr, fhdr);
+  this->parseRenderSize(fhdr);
+}
+
+void Parser::setFrameRefs(SequenceHeader const& shdr, FrameHeader& fhdr, uint8_t const lastFrameIdx, uint8_t const goldFrameIdx) {
+  // 7.8. Set frame refs process
+  constexpr size_t LAST_FRAME = 1;
+  constexpr size_t GOLDEN_FRAME = 4;
+  constexpr size_t BWDREF_FRAME = 5;
+  constexpr size_t ALTREF2_FRAME = 6;
+  constexpr size_t ALTREF_FRAME = 7;
+  std::array<int32_t, FrameHeader::REFS_PER_FRAME> refFrameIdx{};
+  refFrameIdx.fill(-1);
+  refFrameIdx[LAST_FRAME - LAST_FRAME] = lastFrameIdx;
+  refFrameIdx[GOLDEN_FRAME - LAST_FRAME] = goldFrameIdx;
+  std::array<bool, FrameHeader::NUM_REF_FRAMES> usedFrame{};
+  usedFrame[lastFrameIdx] = true;
+  usedFrame[goldFrameIdx] = true;
+  int32_t const curFrameHint = 1 << (shdr.orderHintBits - 1u);
+  std::array<int32_t, FrameHeader::NUM_REF_FRAMES> shiftedOrderHints{};
+  for (size_t i = 0; i < FrameHeader::NUM_REF_FRAMES; ++i) {
+    shiftedOrderHints[i] = curFrameHint + this->relativeDist(shdr, this->refFrames_[i].orderHint, fhdr.orderHint);
+  }
+  // The latest or the earliest unused frame, after the current frame or before it.
+  auto const find = [&](bool const backward, bool const latest) {
+    int32_t ref = -1;
+    int32_t best = 0;
+    for (size_t i = 0; i < FrameHeader::NUM_REF_FRAMES; ++i) {
+      int32_t const hint = shiftedOrderHints[i];
+      if (usedFrame[i] || (hint >= curFrameHint) != backward) {
+        continue;
+      }
+      if (ref < 0 || (latest ? hint >= best : hint < best)) {
+        ref = static_cast<int32_t>(i);
+        best = hint;
+      }
+    }
+    return ref;
+  };
+  auto const assign = [&](size_t const refFrame, int32_t const ref) {
+    if (ref >= 0) {
+      refFrameIdx[refFrame - LAST_FRAME] = ref;
+      usedFrame[ref] = true;
+    }
+  };
+  assign(ALTREF_FRAME, find(true, true));
+  assign(BWDREF_FRAME, find(true, false));
+  assign(ALTREF2_FRAME, find(true, false));
+  // Ref_Frame_List: LAST2_FRAME, LAST3_FRAME, BWDREF_FRAME, ALTREF2_FRAME, ALTREF_FRAME
+  for (size_t const refFrame : {2, 3, 5, 6, 7}) {
+    if (refFrameIdx[refFrame - LAST_FRAME] < 0) {
+      assign(refFrame, find(false, true));
+    }
+  }
+  int32_t ref = -1;
+  int32_t earliestOrderHint = 0;
+  for (size_t i = 0; i < FrameHeader::NUM_REF_FRAMES; ++i) {
+    int32_t const hint = shiftedOrderHints[i];
+    if (ref < 0 || hint < earliestOrderHint) {
+      ref = static_cast<int32_t>(i);
+      earliestOrderHint = hint;
+    }
+  }
+  for (size_t i = 0; i < FrameHeader::REFS_PER_FRAME; ++i) {
+    fhdr.refFrameIdx[i] = static_cast<uint8_t>(refFrameIdx[i] < 0 ? ref : refFrameIdx[i]);
+  }
+}
+
+namespace {
+
+// 5.9.15. tile_log2(): the smallest k such that blkSize << k >= target.
+uint32_t tileLog2(uint32_t const blkSize, uint32_t const target) {
+  uint32_t k = 0;
+  for (; (blkSize << k) < target; k++) {
+  }
+  return k;
+}
+
+}
+
+FrameHeader::TileInfo Parser::parseTileInfo(SequenceHeader const& shdr, FrameHeader const& fhdr) {
+  // 5.9.15. Tile info syntax
+  constexpr uint32_t MAX_TILE_WIDTH = 4096;
+  constexpr uint32_t MAX_TILE_AREA = 4096 * 2304;
+  constexpr uint32_t MAX_TILE_ROWS = 64;
+  constexpr uint32_t MAX_TILE_COLS = 64;
+  FrameHeader::TileInfo info{};
+  uint32_t const sbCols = shdr.use128x128Superblock ? ((fhdr.miCols + 31u) >> 5u) : ((fhdr.miCols + 15u) >> 4u);
+  uint32_t const sbRows = shdr.use128x128Superblock ? ((fhdr.miRows + 31u) >> 5u) : ((fhdr.miRows + 15u) >> 4u);
+  uint32_t const sbShift = shdr.use128x128Superblock ? 5u : 4u;
+  uint32_t const sbSize = sbShift + 2u;
+  uint32_t const maxTileWidthSb = MAX_TILE_WIDTH >> sbSize;
+  uint32_t maxTileAreaSb = MAX_TILE_AREA >> (2u * sbSize);
+  uint32_t const minLog2TileCols = tileLog2(maxTileWidthSb, sbCols);
+  uint32_t const maxLog2TileCols = tileLog2(1, std::min(sbCols, MAX_TILE_COLS));
+  uint32_t const maxLog2TileRows = tileLog2(1, std::min(sbRows, MAX_TILE_ROWS));
+  uint32_t const minLog2Tiles = std::max(minLog2TileCols, tileLog2(maxTileAreaSb, sbRows * sbCols));
+  info.uniformTileSpacing = readBool();
+  if (info.uniformTileSpacing) {
+    uint32_t tileColsLog2 = minLog2TileCols;
+    while (tileColsLog2 < maxLog2TileCols && readBool()) {
+      tileColsLog2++;
+    }
+    uint32_t const tileWidthSb = (sbCols + (1u << tileColsLog2) - 1u) >> tileColsLog2;
+    for (uint32_t startSb = 0; startSb < sbCols; startSb += tileWidthSb) {
+      info.miColStarts.emplace_back(startSb << sbShift);
+    }
+    info.tileColsLog2 = static_cast<uint8_t>(tileColsLog2);
+    uint32_t const minLog2TileRows = minLog2Tiles > tileColsLog2 ? minLog2Tiles - tileColsLog2 : 0;
+    uint32_t tileRowsLog2 = minLog2TileRows;
+    while (tileRowsLog2 < maxLog2TileRows && readBool()) {
+      tileRowsLog2++;
+    }
+    uint32_t const tileHeightSb = (sbRows + (1u << tileRowsLog2) - 1u) >> tileRowsLog2;
+    for (uint32_t startSb = 0; startSb < sbRows; startSb += tileHeightSb) {
+      info.miRowStarts.emplace_back(startSb << sbShift);
+    }
+    info.tileRowsLog2 = static_cast<uint8_t>(tileRowsLog2);
+  } else {
+    uint32_t widestTileSb = 0;
+    for (uint32_t startSb = 0; startSb < sbCols;) {
+      info.miColStarts.emplace_back(startSb << sbShift);
+      uint32_t const maxWidth = std::min(sbCols - startSb, maxTileWidthSb);
+      uint32_t const sizeSb = readNS(maxWidth) + 1u;
+      widestTileSb = std::max(sizeSb, widestTileSb);
+      startSb += sizeSb;
+    }
+    info.tileColsLog2 = static_cast<uint8_t>(tileLog2(1, static_cast<uint32_t>(info.miColStarts.size())));
+    if (minLog2Tiles > 0) {
+      maxTileAreaSb = (sbRows * sbCols) >> (minLog2Tiles + 1u);
+    } else {
+      maxTileAreaSb = sbRows * sbCols;
+    }
+    uint32_t const maxTileHeightSb = std::max(maxTileAreaSb / widestTileSb, 1u);
+    for (uint32_t startSb = 0; startSb < sbRows;) {
+      info.miRowStarts.emplace_back(startSb << sbShift);
+      uint32_t const maxHeight = std::min(sbRows - startSb, maxTileHeightSb);
+      startSb += readNS(maxHeight) + 1u;
+    }
+    info.tileRowsLog2 = static_cast<uint8_t>(tileLog2(1, static_cast<uint32_t>(info.miRowStarts.size())));
+  }
+  info.tileCols = static_cast<uint32_t>(info.miColStarts.size());
+  info.tileRows = static_cast<uint32_t>(info.miRowStarts.size());
+  info.miColStarts.emplace_back(fhdr.miCols);
+  info.miRowStarts.emplace_back(fhdr.miRows);
+  if (info.tileColsLog2 > 0 || info.tileRowsLog2 > 0) {
+    info.contextUpdateTileID = readUint(info.tileRowsLog2 + info.tileColsLog2);
+    info.tileSizeBytes = readBits(2) + 1u;
+  } else {
+    info.contextUpdateTileID = 0;
+  }
+  return info;
+}
+
+FrameHeader::QuantizationParams Parser::parseQuantizationParams(SequenceHeader const& shdr) {
+  // 5.9.12. Quantization params syntax
+  FrameHeader::QuantizationParams q{};
+  // 5.9.13. read_delta_q()
+  auto const readDeltaQ = [this]() -> int8_t {
+    return readBool() ? static_cast<int8_t>(readSU(7)) : 0;
+  };
+  q.baseQIdx = readU8();
+  q.deltaQYDc = readDeltaQ();
+  if (!shdr.colorConfig.monochrome) {
+    q.diffUVDelta = shdr.colorConfig.separateUVDeltaQ ? readBool() : false;
+    q.deltaQUDc = readDeltaQ();
+    q.deltaQUAc = readDeltaQ();
+    if (q.diffUVDelta) {
+      q.deltaQVDc = readDeltaQ();
+      q.deltaQVAc = readDeltaQ();
+    } else {
+      q.deltaQVDc = q.deltaQUDc;
+      q.deltaQVAc = q.deltaQUAc;
+    }
+  }
+  q.usingQMatrix = readBool();
+  if (q.usingQMatrix) {
+    q.qmY = readBits(4);
+    q.qmU = readBits(4);
+    if (!shdr.colorConfig.separateUVDeltaQ) {
+      q.qmV = q.qmU;
+    } else {
+      q.qmV = readBits(4);
+    }
+  }
+  return q;
+}
+
+FrameHeader::SegmentationParams Parser::parseSegmentationParams(FrameHeader const& fhdr) {
+  // 5.9.14. Segmentation params syntax
+  constexpr std::array<uint8_t, FrameHeader::SEG_LVL_MAX> Segmentation_Feature_Bits = {8, 6, 6, 6, 6, 3, 0, 0};
+  constexpr std::array<bool, FrameHeader::SEG_LVL_MAX> Segmentation_Feature_Signed = {true, true, true, true, true, false, false, false};
+  constexpr std::array<int16_t, FrameHeader::SEG_LVL_MAX> Segmentation_Feature_Max = {255, 63, 63, 63, 63, 7, 0, 0};
+  FrameHeader::SegmentationParams seg{};
+  seg.enabled = readBool();
+  if (!seg.enabled) {
+    return seg;
+  }
+  if (fhdr.primaryRefFrame == FrameHeader::PRIMARY_REF_NONE) {
+    seg.updateMap = true;
+    seg.temporalUpdate = false;
+    seg.updateData = true;
+  } else {
+    seg.updateMap = readBool();
+    if (seg.updateMap) {
+      seg.temporalUpdate = readBool();
+    }
+    seg.updateData = readBool();
+  }
+  if (!seg.updateData) {
+    // load_previous(): the features of the primary reference frame.
+    FrameHeader::SegmentationParams const& prev = this->refFrames_[fhdr.refFrameIdx[fhdr.primaryRefFrame]].segmentationParams;
+    seg.featureEnabled = prev.featureEnabled;
+    seg.featureData = prev.featureData;
+    return seg;
+  }
+  for (size_t i = 0; i < FrameHeader::MAX_SEGMENTS; ++i) {
+    for (size_t j = 0; j < FrameHeader::SEG_LVL_MAX; ++j) {
+      seg.featureEnabled[i][j] = readBool();
+      if (!seg.featureEnabled[i][j]) {
+        continue;
+      }
+      int32_t const limit = Segmentation_Feature_Max[j];
+      if (Segmentation_Feature_Signed[j]) {
+        seg.featureData[i][j] = static_cast<int16_t>(std::clamp(readSU(1u + Segmentation_Feature_Bits[j]), -limit, limit));
+      } else {
+        seg.featureData[i][j] = static_cast<int16_t>(std::clamp(static_cast<int32_t>(readUint(Segmentation_Feature_Bits[j])), 0, limit));
+      }
+    }
+  }
+  return seg;
+}
+
+void Parser::parseLoopFilterParams(SequenceHeader const& shdr, FrameHeader const& fhdr) {
+  // 5.9.11. Loop filter params syntax
+  if (fhdr.codedLossless || fhdr.allowIntrabc) {
+    return;
+  }
+  uint8_t const level0 = readBits(6);
+  uint8_t const level1 = readBits(6);
+  if (!shdr.colorConfig.monochrome && (level0 != 0 || level1 != 0)) {
+    static_cast<void>(readBits(6));
+    static_cast<void>(readBits(6));
+  }
+  // loop_filter_sharpness
+  static_cast<void>(readBits(3));
+  bool const deltaEnabled = readBool();
+  if (deltaEnabled && readBool()) {
+    // loop_filter_ref_deltas, then loop_filter_mode_deltas
+    for (size_t i = 0; i < FrameHeader::NUM_REF_FRAMES + 2; ++i) {
+      if (readBool()) {
+        static_cast<void>(readSU(7));
+      }
+    }
+  }
+}
+
+void Parser::parseCDEFParams(SequenceHeader const& shdr, FrameHeader const& fhdr) {
+  // 5.9.19. CDEF params syntax
+  if (fhdr.codedLossless || fhdr.allowIntrabc || !shdr.enableCDEF) {
+    return;
+  }
+  // cdef_damping_minus_3
+  static_cast<void>(readBits(2));
+  uint8_t const cdefBits = readBits(2);
+  // cdef_y_pri_strength and cdef_y_sec_strength, then for uv.
+  size_t const bitsPerStrength = shdr.colorConfig.monochrome ? 6 : 12;
+  for (size_t i = 0; i < (1u << cdefBits); ++i) {
+    static_cast<void>(readUint(bitsPerStrength));
+  }
+}
+
+void Parser::parseLRParams(SequenceHeader const& shdr, FrameHeader const& fhdr) {
+  // 5.9.20. Loop restoration params syntax
+  if (fhdr.allLossless || fhdr.allowIntrabc || !shdr.enableRestoration) {
+    return;
+  }
+  bool usesLr = false;
+  bool usesChromaLr = false;
+  size_t const numPlanes = shdr.colorConfig.monochrome ? 1 : 3;
+  for (size_t i = 0; i < numPlanes; ++i) {
+    // lr_type; 0 is RESTORE_NONE in Remap_Lr_Type.
+    if (readBits(2) != 0) {
+      usesLr = true;
+      usesChromaLr = usesChromaLr || i > 0;
+    }
+  }
+  if (!usesLr) {
+    return;
+  }
+  // lr_unit_shift, and lr_unit_extra_shift for 64x64 superblocks.
+  if (shdr.use128x128Superblock) {
+    static_cast<void>(readBool());
+  } else if (readBool()) {
+    static_cast<void>(readBool());
+  }
+  if (shdr.colorConfig.subsamplingX != 0 && shdr.colorConfig.subsamplingY != 0 && usesChromaLr) {
+    // lr_uv_shift
+    static_cast<void>(readBool());
+  }
+}
+
+void Parser::parseSkipModeParams(SequenceHeader const& shdr, FrameHeader const& fhdr, bool const referenceSelect) {
+  // 5.9.22. Skip mode params syntax
+  if (fhdr.frameIsIntra || !referenceSelect || !shdr.enableOrderHint) {
+    return;
+  }
+  int32_t forwardIdx = -1;
+  int32_t backwardIdx = -1;
+  uint32_t forwardHint = 0;
+  uint32_t backwardHint = 0;
+  for (size_t i = 0; i < FrameHeader::REFS_PER_FRAME; ++i) {
+    uint32_t const refHint = this->refFrames_[fhdr.refFrameIdx[i]].orderHint;
+    if (this->relativeDist(shdr, refHint, fhdr.orderHint) < 0) {
+      if (forwardIdx < 0 || this->relativeDist(shdr, refHint, forwardHint) > 0) {
+        forwardIdx = static_cast<int32_t>(i);
+        forwardHint = refHint;
+      }
+    } else if (this->relativeDist(shdr, refHint, fhdr.orderHint) > 0) {
+      if (backwardIdx < 0 || this->relativeDist(shdr, refHint, backwardHint) < 0) {
+        backwardIdx = static_cast<int32_t>(i);
+        backwardHint = refHint;
+      }
+    }
+  }
+  bool skipModeAllowed = false;
+  if (forwardIdx < 0) {
+    skipModeAllowed = false;
+  } else if (backwardIdx >= 0) {
+    skipModeAllowed = true;
+  } else {
+    for (size_t i = 0; i < FrameHeader::REFS_PER_FRAME; ++i) {
+      uint32_t const refHint = this->refFrames_[fhdr.refFrameIdx[i]].orderHint;
+      if (this->relativeDist(shdr, refHint, forwardHint) < 0) {
+        skipModeAllowed = true;
+      }
+    }
+  }
+  if (skipModeAllowed) {
+    // skip_mode_present
+    static_cast<void>(readBool());
+  }
+}
+
+void Parser::parseGlobalMotionParams(FrameHeader const& fhdr, bool const allowHighPrecisionMV) {
+  // 5.9.24. Global motion params syntax
+  // The parameters are coded relative to those of the previous frame, but how many bits they take does not depend on them.
+  enum : uint8_t { IDENTITY = 0, TRANSLATION = 1, ROTZOOM = 2, AFFINE = 3 };
+  if (fhdr.frameIsIntra) {
+    return;
+  }
+  // 5.9.26. - 5.9.28. decode_signed_subexp_with_ref(-mx, mx + 1, r), without the value.
+  auto const skipGlobalParam = [this](uint8_t const type, size_t const idx, bool const allowHighPrecisionMV) {
+    uint32_t absBits = 12; // GM_ABS_ALPHA_BITS
+    if (idx < 2) {
+      if (type == TRANSLATION) {
+        absBits = 9u - (allowHighPrecisionMV ? 0u : 1u); // GM_ABS_TRANS_ONLY_BITS
+      } else {
+        absBits = 12; // GM_ABS_TRANS_BITS
+      }
+    }
+    uint32_t const numSyms = 2u * (1u << absBits) + 1u;
+    uint32_t i = 0;
+    uint32_t mk = 0;
+    uint32_t const k = 3;
+    while (true) {
+      uint32_t const b2 = i != 0 ? k + i - 1 : k;
+      uint32_t const a = 1u << b2;
+      if (numSyms <= mk + 3u * a) {
+        static_cast<void>(readNS(numSyms - mk));
+        return;
+      }
+      if (!readBool()) {
+        static_cast<void>(readUint(b2));
+        return;
+      }
+      i++;
+      mk += a;
+    }
+  };
+  for (size_t ref = 0; ref < FrameHeader::REFS_PER_FRAME; ++ref) {
+    uint8_t type = IDENTITY;
+    bool const isGlobal = readBool();
+    if (isGlobal) {
+      bool const isRotZoom = readBool();
+      if (isRotZoom) {
+        type = ROTZOOM;
+      } else {
+        bool const isTranslation = readBool();
+        type = isTranslation ? TRANSLATION : AFFINE;
+      }
+    }
+    if (type >= ROTZOOM) {
+      skipGlobalParam(type, 2, allowHighPrecisionMV);
+      skipGlobalParam(type, 3, allowHighPrecisionMV);
+      if (type == AFFINE) {
+        skipGlobalParam(type, 4, allowHighPrecisionMV);
+        skipGlobalParam(type, 5, allowHighPrecisionMV);
+      }
+    }
+    if (type >= TRANSLATION) {
+      skipGlobalParam(type, 0, allowHighPrecisionMV);
+      skipGlobalParam(type, 1, allowHighPrecisionMV);
+    }
+  }
+}
+
+void Parser::parseFilmGrainParams(SequenceHeader const& shdr, FrameHeader const& fhdr) {
+  // 5.9.30. Film grain params syntax
+  if (!shdr.filmGrainParamsPresent || (!fhdr.showFrame && !fhdr.showableFrame)) {
+    return;
+  }
+  bool const applyGrain = readBool();
+  if (!applyGrain) {
+    return;
+  }
+  // grain_seed
+  static_cast<void>(readU16());
+  bool const updateGrain = fhdr.frameType == FrameHeader::FrameType::InterFrame ? readBool() : true;
+  if (!updateGrain) {
+    // film_grain_params_ref_idx
+    static_cast<void>(readBits(3));
+    return;
+  }
+  SequenceHeader::ColorConfig const& cfg = shdr.colorConfig;
+  // point_*_value and point_*_scaling: up to 14 points for luma and 10 for each chroma, 16 bits each.
+  auto const skipPoints = [this](uint8_t const numPoints) {
+    for (size_t i = 0; i < numPoints; ++i) {
+      static_cast<void>(readU8());
+      static_cast<void>(readU8());
+    }
+  };
+  uint8_t const numYPoints = readBits(4);
+  skipPoints(numYPoints);
+  bool const chromaScalingFromLuma = cfg.monochrome ? false : readBool();
+  uint8_t numCbPoints = 0;
+  uint8_t numCrPoints = 0;
+  if (!cfg.monochrome && !chromaScalingFromLuma && !(cfg.subsamplingX == 1 && cfg.subsamplingY == 1 && numYPoints == 0)) {
+    numCbPoints = readBits(4);
+    skipPoints(numCbPoints);
+    numCrPoints = readBits(4);
+    skipPoints(numCrPoints);
+  }
+  // grain_scaling_minus_8
+  static_cast<void>(readBits(2));
+  uint8_t const arCoeffLag = readBits(2);
+  size_t const numPosLuma = 2u * arCoeffLag * (arCoeffLag + 1u);
+  size_t numPosChroma = numPosLuma;
+  if (numYPoints != 0) {
+    numPosChroma = numPosLuma + 1;
+    for (size_t i = 0; i < numPosLuma; ++i) {
+      static_cast<void>(readU8());
+    }
+  }
+  if (chromaScalingFromLuma || numCbPoints != 0) {
+    for (size_t i = 0; i < numPosChroma; ++i) {
+      static_cast<void>(readU8());
+    }
+  }
+  if (chromaScalingFromLuma || numCrPoints != 0) {
+    for (size_t i = 0; i < numPosChroma; ++i) {
+      static_cast<void>(readU8());
+    }
+  }
+  // ar_coeff_shift_minus_6 and grain_scale_shift
+  static_cast<void>(readBits(4));
+  if (numCbPoints != 0) {
+    // cb_mult, cb_luma_mult and cb_offset
+    static_cast<void>(readUint(25));
+  }
+  if (numCrPoints != 0) {
+    static_cast<void>(readUint(25));
+  }
+  // overlap_flag and clip_to_restricted_range
+  static_cast<void>(readBits(2));
+}
+
+void Parser::updateRefFrames(FrameHeader const& fhdr) {
+  // 7.20. Reference frame update process
+  RefFrame current{};
+  current.frameType = fhdr.frameType;
+  current.frameID = fhdr.currentFrameID;
+  current.upscaledWidth = fhdr.upscaledWidth;
+  current.frameWidth = fhdr.frameWidth;
+  current.frameHeight = fhdr.frameHeight;
+  current.renderWidth = fhdr.renderWidth;
+  current.renderHeight = fhdr.renderHeight;
+  current.miCols = fhdr.miCols;
+  current.miRows = fhdr.miRows;
+  current.orderHint = fhdr.orderHint;
+  current.segmentationParams = fhdr.segmentationParams;
+  for (size_t i = 0; i < FrameHeader::NUM_REF_FRAMES; ++i) {
+    if (((fhdr.refreshFrameFlags >> i) & 1u) == 1u) {
+      this->refFrames_[i] = current;
+    }
+  }
+}
+
+TileGroup Parser::parseTileGroup(FrameHeader const& fhdr, size_t const end) {
+  // 5.11.1. General tile group OBU syntax
+  FrameHeader::TileInfo const& info = fhdr.tileInfo;
+  uint32_t const numTiles = info.tileCols * info.tileRows;
+  TileGroup tg{};
+  bool tileStartAndEndPresentFlag = false;
+  if (numTiles > 1) {
+    tileStartAndEndPresentFlag = readBool();
+  }
+  if (numTiles == 1 || !tileStartAndEndPresentFlag) {
+    tg.tgStart = 0;
+    tg.tgEnd = numTiles - 1;
+  } else {
+    size_t const tileBits = info.tileColsLog2 + info.tileRowsLog2;
+    tg.tgStart = readUint(tileBits);
+    tg.tgEnd = readUint(tileBits);
+  }
+  if (tg.tgEnd < tg.tgStart || tg.tgEnd >= numTiles) {
+    throw Error("Invalid tile group: [{}, {}] of {} tiles.", tg.tgStart, tg.tgEnd, numTiles);
+  }
+  this->byteAlignment();
+  if (this->posInBytes() > end) {
+    throw Error("The headers of the tile group run past the end of its OBU.");
+  }
+  for (uint32_t tileNum = tg.tgStart; tileNum <= tg.tgEnd; ++tileNum) {
+    TileGroup::Tile tile{};
+    tile.row = tileNum / info.tileCols;
+    tile.col = tileNum % info.tileCols;
+    size_t const pos = this->posInBytes();
+    if (tileNum == tg.tgEnd) {
+      tile.offset = pos;
+      tile.size = end > pos ? end - pos : 0;
+    } else {
+      tile.size = this->readLE(info.tileSizeBytes) + 1u;
+      tile.offset = this->posInBytes();
+      if (tile.offset > end || tile.size > end - tile.offset) {
+        throw Error("Tile {} with {} bytes overruns the tile group.", tileNum, tile.size);
+      }
+      this->seekInBytes(tile.offset + tile.size);
+    }
+    tg.tiles.emplace_back(tile);
+  }
+  this->seekInBytes(end);
+  if (tg.tgEnd == numTiles - 1) {
+    this->frameHeader_.reset();
+  }
+  return tg;
+}
+
+Parser::Result::Packet::Content Parser::parseMetadata(size_t const startPosition, size_t const size, size_t const end) {
+  // 5.8.1. General metadata OBU syntax
+  if (size == 0) {
+    throw Error("Metadata OBU without metadata_type.");
+  }
+  Result::Packet::Content content;
+  switch (static_cast<MetadataType>(this->readLEB128())) {
+    case MetadataType::HDR_CLL:
+      content = this->parseMetadataHDRCLL();
+      break;
+    case MetadataType::HDR_MDCV:
+      content = this->parseMetadataHDRMDCV();
+      break;
+    case MetadataType::SCALABILITY:
+      content = this->parseMetadataScalability();
+      break;
+    case MetadataType::ITUT_T35:
+      content = this->parseMetadataITUTT35(end);
+      break;
+    case MetadataType::TIMECODE:
+      content = this->parseMetadataTimecode();
+      break;
+    default:
+      this->seekInBytes(end);
+      return content;
+  }
+  this->trailingBits(startPosition, size);
+  return content;
+}
+
+MetadataHDRCLL Parser::parseMetadataHDRCLL() {
+  // 5.8.3. Metadata high dynamic range content light level syntax
+  MetadataHDRCLL cll{};
+  cll.maxCLL = readU16();
+  cll.maxFALL = readU16();
+  return cll;
+}
+
+MetadataHDRMDCV Parser::parseMetadataHDRMDCV() {
+  // 5.8.4. Metadata high dynamic range mastering display color volume syntax
+  MetadataHDRMDCV mdcv{};
+  for (size_t i = 0; i < 3; ++i) {
+    mdcv.primaryChromaticityX[i] = readU16();
+    mdcv.primaryChromaticityY[i] = readU16();
+  }
+  mdcv.whitePointChromaticityX = readU16();
+  mdcv.whitePointChromaticityY = readU16();
+  mdcv.luminanceMax = readU32();
+  mdcv.luminanceMin = readU32();
+  return mdcv;
+}
+
+MetadataScalability Parser::parseMetadataScalability() {
+  // 5.8.5. Metadata scalability syntax
+  MetadataScalability scalability{};
+  scalability.scalabilityModeIdc = readU8();
+  if (scalability.scalabilityModeIdc != MetadataScalability::SCALABILITY_SS) {
+    return scalability;
+  }
+  // 5.8.6. Scalability structure syntax
+  MetadataScalability::ScalabilityStructure ss{};
+  ss.spatialLayersCntMinus1 = readBits(2);
+  ss.spatialLayerDimensionsPresentFlag = readBool();
+  ss.spatialLayerDescriptionPresentFlag = readBool();
+  ss.temporalGroupDescriptionPresentFlag = readBool();
+  // scalability_structure_reserved_3bits
+  static_cast<void>(readBits(3));
+  ss.spatialLayers.resize(ss.spatialLayersCntMinus1 + 1u);
+  if (ss.spatialLayerDimensionsPresentFlag) {
+    for (MetadataScalability::ScalabilityStructure::SpatialLayer& layer : ss.spatialLayers) {
+      layer.maxWidth = readU16();
+      layer.maxHeight = readU16();
+    }
+  }
+  if (ss.spatialLayerDescriptionPresentFlag) {
+    for (MetadataScalability::ScalabilityStructure::SpatialLayer& layer : ss.spatialLayers) {
+      layer.refID = readU8();
+    }
+  }
+  if (ss.temporalGroupDescriptionPresentFlag) {
+    uint8_t const temporalGroupSize = readU8();
+    ss.temporalGroups.resize(temporalGroupSize);
+    for (MetadataScalability::ScalabilityStructure::TemporalGroup& group : ss.temporalGroups) {
+      group.temporalID = readBits(3);
+      group.temporalSwitchingUpPointFlag = readBool();
+      group.spatialSwitchingUpPointFlag = readBool();
+      uint8_t const refCnt = readBits(3);
+      for (size_t i = 0; i < refCnt; ++i) {
+        group.refPicDiffs.emplace_back(readU8());
+      }
+    }
+  }
+  scalability.scalabilityStructure = std::move(ss);
+  return scalability;
+}
+
+MetadataITUTT35 Parser::parseMetadataITUTT35(size_t const end) {
+  // 5.8.2. Metadata ITUT T35 syntax
+  MetadataITUTT35 t35{};
+  t35.countryCode = readU8();
+  if (t35.countryCode == 0xff) {
+    t35.countryCodeExtensionByte = readU8();
+  }
+  // The payload runs up to the trailing bits, which start at the last byte that is not zero.
+  size_t const beg = this->posInBytes();
+  size_t last = end;
+  while (last > beg && this->buffer_.at(last - 1) == 0) {
+    last--;
+  }
+  if (last <= beg) {
+    throw Error("ITU-T T.35 metadata without trailing bits.");
+  }
+  last--;
+  t35.payloadBytes.assign(std::next(this->buffer_.cbegin(), static_cast<ptrdiff_t>(beg)), std::next(this->buffer_.cbegin(), static_cast<ptrdiff_t>(last)));
+  this->seekInBytes(last);
+  return t35;
+}
+
+MetadataTimecode Parser::parseMetadataTimecode() {
+  // 5.8.7. Metadata timecode syntax
+  MetadataTimecode tc{};
+  tc.countingType = readBits(5);
+  tc.fullTimestampFlag = readBool();
+  tc.discontinuityFlag = readBool();
+  tc.cntDroppedFlag = readBool();
+  tc.nFrames = static_cast<uint16_t>(readUint(9));
+  if (tc.fullTimestampFlag) {
+    tc.secondsFlag = true;
+    tc.secondsValue = readBits(6);
+    tc.minutesFlag = true;
+    tc.minutesValue = readBits(6);
+    tc.hoursFlag = true;
+    tc.hoursValue = readBits(5);
+  } else {
+    tc.secondsFlag = readBool();
+    if (tc.secondsFlag) {
+      tc.secondsValue = readBits(6);
+      tc.minutesFlag = readBool();
+      if (tc.minutesFlag) {
+        tc.minutesValue = readBits(6);
+        tc.hoursFlag = readBool();
+        if (tc.hoursFlag) {
+          tc.hoursValue = readBits(5);
+        }
+      }
+    }
+  }
+  tc.timeOffsetLength = readBits(5);
+  if (tc.timeOffsetLength > 0) {
+    tc.timeOffsetValue = static_cast<uint32_t>(readUint(tc.timeOffsetLength));
+  }
+  return tc;
+}
+
+}
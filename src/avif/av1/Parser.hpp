@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <vector>
 #include <variant>
@@ -11,8 +12,13 @@
 #include "../util/StreamReader.hpp"
 #include "SequenceHeader.hpp"
 #include "TemporalDelimiter.hpp"
+#include "FrameHeader.hpp"
+#include "TileGroup.hpp"
+#include "Frame.hpp"
+#include "Metadata.hpp"
 #include "Padding.hpp"
 #include "BitStreamReader.hpp"
+#include "OperatingPoint.hpp"
 
 namespace avif::av1 {
 
@@ -49,7 +55,10 @@ public:
   public:
     class Packet {
     public:
-      using Content = std::variant<std::monostate, SequenceHeader, TemporalDelimiter, Padding>;
+      // FrameHeader is for both frame header and redundant frame header OBUs.
+      using Content = std::variant<
+          std::monostate, SequenceHeader, TemporalDelimiter, FrameHeader, TileGroup, Frame, Padding,
+          MetadataHDRCLL, MetadataHDRMDCV, MetadataScalability, MetadataITUTT35, MetadataTimecode>;
     private:
       size_t beg_;
       size_t end_;
@@ -119,7 +128,30 @@ private: /* intermediate states */
 private:
   std::shared_ptr<Result> result_{};
 private:
+  // The index into SequenceHeader::operatingPoints to decode, and its operating_point_idc once a sequence header is read.
+  // OBUs of the other layers are dropped.
+  size_t operatingPoint_ = 0;
   uint16_t OperatingPointIdc = 0;
+private: /* decoding states, carried from packet to packet */
+  // What frame headers need to know about the frame in each reference slot (7.20. Reference frame update process).
+  struct RefFrame final {
+    FrameHeader::FrameType frameType{};
+    uint32_t frameID{};
+    uint32_t upscaledWidth{};
+    uint32_t frameWidth{};
+    uint32_t frameHeight{};
+    uint32_t renderWidth{};
+    uint32_t renderHeight{};
+    uint32_t miCols{};
+    uint32_t miRows{};
+    uint32_t orderHint{};
+    FrameHeader::SegmentationParams segmentationParams{};
+  };
+  // The last sequence header. Frame headers cannot be read without one, and are skipped.
+  std::optional<SequenceHeader> sequenceHeader_{};
+  // The header of the frame whose tile groups are yet to come (SeenFrameHeader in the spec).
+  std::optional<FrameHeader> frameHeader_{};
+  std::array<RefFrame, FrameHeader::NUM_REF_FRAMES> refFrames_{};
 public:
   Parser() = delete;
   Parser(Parser&&) = delete;
@@ -129,6 +161,9 @@ public:
 
 public: //entry point
   Parser(util::Logger& log, std::vector<uint8_t> buffer);
+  // Decodes the operating point of the index, e.g. a lower spatial layer of a layered stream.
+  // Parsing fails if the sequence header does not have it.
+  Parser(util::Logger& log, std::vector<uint8_t> buffer, size_t operatingPoint);
   std::shared_ptr<Result> parse();
 
 private:
@@ -143,6 +178,37 @@ private:
   SequenceHeader::DecoderModelInfo parseDecoderModelInfo();
   SequenceHeader::ColorConfig parseColorConfig(SequenceHeader const& shdr);
 
+  // Frame Header OBU
+  FrameHeader parseFrameHeader(Header const& hdr);
+  void parseFrameSize(SequenceHeader const& shdr, FrameHeader& fhdr);
+  void parseSuperresParams(SequenceHeader const& shdr, FrameHeader& fhdr);
+  void parseRenderSize(FrameHeader& fhdr);
+  void parseFrameSizeWithRefs(SequenceHeader const& shdr, FrameHeader& fhdr);
+  void setFrameRefs(SequenceHeader const& shdr, FrameHeader& fhdr, uint8_t lastFrameIdx, uint8_t goldFrameIdx);
+  FrameHeader::TileInfo parseTileInfo(SequenceHeader const& shdr, FrameHeader const& fhdr);
+  FrameHeader::QuantizationParams parseQuantizationParams(SequenceHeader const& shdr);
+  FrameHeader::SegmentationParams parseSegmentationParams(FrameHeader const& fhdr);
+  // Read to reach the end of the header, but not kept.
+  void parseLoopFilterParams(SequenceHeader const& shdr, FrameHeader const& fhdr);
+  void parseCDEFParams(SequenceHeader const& shdr, FrameHeader const& fhdr);
+  void parseLRParams(SequenceHeader const& shdr, FrameHeader const& fhdr);
+  void parseSkipModeParams(SequenceHeader const& shdr, FrameHeader const& fhdr, bool referenceSelect);
+  void parseGlobalMotionParams(FrameHeader const& fhdr, bool allowHighPrecisionMV);
+  void parseFilmGrainParams(SequenceHeader const& shdr, FrameHeader const& fhdr);
+  void updateRefFrames(FrameHeader const& fhdr);
+  [[nodiscard]] int32_t relativeDist(SequenceHeader const& shdr, uint32_t a, uint32_t b) const;
+
+  // Tile Group OBU
+  TileGroup parseTileGroup(FrameHeader const& fhdr, size_t end);
+
+  // Metadata OBU. Types not parsed here are std::monostate.
+  Result::Packet::Content parseMetadata(size_t startPosition, size_t size, size_t end);
+  MetadataHDRCLL parseMetadataHDRCLL();
+  MetadataHDRMDCV parseMetadataHDRMDCV();
+  MetadataScalability parseMetadataScalability();
+  MetadataITUTT35 parseMetadataITUTT35(size_t end);
+  MetadataTimecode parseMetadataTimecode();
+
 private:
   [[nodiscard]] size_t posInBits() { return this->reader_.posInBits(); }
   [[nodiscard]] size_t posInBytes() { return this->reader_.posInBytes(); }
@@ -157,6 +223,13 @@ private:
   [[nodiscard]] uint64_t readU64() { return this->reader_.readU64(); }
   [[nodiscard]] uint32_t readLEB128() { return this->reader_.readLEB128(); }
   [[nodiscard]] uint32_t readUVLC() { return this->reader_.readUVLC(); }
+  [[nodiscard]] int32_t readSU(size_t bits) { return this->reader_.readSU(bits); }
+  [[nodiscard]] uint32_t readNS(uint32_t n) { return this->reader_.readNS(n); }
+  [[nodiscard]] uint64_t readLE(size_t bytes) { return this->reader_.readLE(bytes); }
+  // 5.3.4. Trailing bits syntax, after the payload of "size" bytes from startPosition in bits.
+  void trailingBits(size_t startPosition, size_t size);
+  // 5.3.5. Byte alignment syntax
+  void byteAlignment();
 };
 
 }
@@ -79,7 +79,7 @@ struct SequenceHeader final {
 
   bool seqChooseIntegerMV{};
   constexpr static uint8_t SELECT_INTEGER_MV = 2;
-  bool seqForceIntegerMV{};
+  uint8_t seqForceIntegerMV{};
   uint8_t orderHintBits{};
   bool enableSuperres{};
   bool enableCDEF{};
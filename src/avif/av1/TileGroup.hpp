@@ -0,0 +1,27 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace avif::av1 {
+
+// 5.11.1. General tile group OBU syntax: which tiles of the frame the OBU carries, and where their data is.
+struct TileGroup final {
+  uint32_t tgStart{};
+  uint32_t tgEnd{};
+  struct Tile final {
+    uint32_t row{};
+    uint32_t col{};
+    // In bytes, from the beginning of the buffer given to the parser.
+    size_t offset{};
+    size_t size{};
+  };
+  std::vector<Tile> tiles{};
+};
+
+}
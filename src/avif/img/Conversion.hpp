@@ -7,10 +7,20 @@
 #include <cstdint>
 #include <cmath>
 #include <tuple>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <type_traits>
 #include <fmt/format.h>
 #include "./color/Matrix.hpp"
 #include "./color/Math.hpp"
+#include "./color/FixedPoint.hpp"
+#include "./color/LookupTable.hpp"
+#include "./simd/Kernels.hpp"
 #include "Image.hpp"
+#include "PlanarImage.hpp"
 
 namespace avif::img {
 
@@ -29,10 +39,71 @@ struct ChromaSampler {
   }
 };
 
+// How each sample is computed.
+enum class Arithmetic : uint8_t {
+  // std::round on floats. This is the reference, and runs the img/simd kernels when the CPU has them.
+  Float = 0,
+  // Integers only, so the output is the same on every platform. See color/FixedPoint.hpp for its accuracy.
+  // Converters without a LinearMatrix fall back to Float.
+  FixedPoint,
+  // YUV -> RGB from 8-bit YUV only: precomputed tables, without SIMD. See color/LookupTable.hpp.
+  // Gives the same results as Float. Other conversions fall back to Float.
+  LookupTable,
+};
+
+// How FromRGB::toI422/toI420 make subsampled chroma.
+enum class ChromaDownsampling : uint8_t {
+  // Each chroma sample takes the value of the last pixel it covers.
+  LastPixel = 0,
+  // Each chroma sample is computed once, from the average of the pixels around its position.
+  Box,
+};
+
+// How ToRGB::fromI422/fromI420 read subsampled chroma.
+enum class ChromaUpsampling : uint8_t {
+  // Each pixel takes the chroma sample covering it.
+  Nearest = 0,
+  // Each pixel interpolates the chroma samples around it, horizontally and vertically.
+  Bilinear,
+};
+
+// Where subsampled chroma samples are, relative to luma samples. The values of AV1 chroma_sample_position:
+// SequenceHeader::ColorConfig::chromaSamplePosition and AV1CodecConfigurationRecord::chromaSamplePosition.
+enum class ChromaSamplePosition : uint8_t {
+  // Treated as centered between the pixels it covers. The reserved value 3 is treated as this too.
+  Unknown = 0,
+  // Horizontally at the left pixel, vertically between the two rows.
+  Vertical = 1,
+  // At the top-left pixel.
+  Colocated = 2,
+};
+
+// Per-call options of FromRGB, FromAlpha, ToRGB and ToAlpha. The defaults keep the original behaviour.
+struct ConversionOptions final {
+  // Runs task(0), ..., task(count - 1), possibly in parallel, and returns when all of them have finished.
+  // The tasks do not throw.
+  using Executor = std::function<void(size_t count, std::function<void(size_t)> const& task)>;
+
+  Arithmetic arithmetic = Arithmetic::Float;
+  ChromaDownsampling chromaDownsampling = ChromaDownsampling::LastPixel;
+  ChromaUpsampling chromaUpsampling = ChromaUpsampling::Nearest;
+  ChromaSamplePosition chromaSamplePosition = ChromaSamplePosition::Unknown;
+  // Converts the image in this many bands of rows in parallel. 0 means std::thread::hardware_concurrency().
+  // The output is the same as with 1.
+  size_t threads = 1;
+  // Runs the bands. Empty means one std::thread per band.
+  Executor executor{};
+};
+
 namespace detail {
 
-template <typename Converter, size_t rgbBits, size_t yuvBits, bool isMonoYUV, bool isFullRange>
+template <typename Converter, size_t rgbBits, size_t yuvBits, bool isMonoYUV, bool isFullRange, Arithmetic arithmetic = Arithmetic::Float>
 constexpr void calcYUV(uint16_t const ir, uint16_t const ig, uint16_t const ib, typename avif::img::color::YUV<yuvBits>::Type* dstY, typename avif::img::color::YUV<yuvBits>::Type* dstU, typename avif::img::color::YUV<yuvBits>::Type* dstV) {
+  if constexpr (arithmetic == Arithmetic::FixedPoint && avif::img::color::LinearMatrix<Converter>::isSupported) {
+    using FixedPoint = typename avif::img::color::FixedPointQuantizer<Converter, rgbBits, yuvBits, isFullRange>;
+    FixedPoint::calcYUV(ir, ig, ib, dstY, isMonoYUV ? nullptr : dstU, isMonoYUV ? nullptr : dstV);
+    return;
+  }
   using Quantizer = typename avif::img::color::Quantizer<rgbBits, yuvBits, isFullRange>;
   using RGBSpec = typename avif::img::color::RGB<rgbBits>;
   float const r = static_cast<float>(ir) / RGBSpec::max;
@@ -54,8 +125,35 @@ constexpr void calcYUV(uint16_t const ir, uint16_t const ig, uint16_t const ib,
   }
 }
 
-template <typename Converter, size_t rgbBits, size_t yuvBits, bool isMonoYUV, bool isFullRange>
+// Chroma of the weighted sum of pixels, whose weights add up to (1 << log2Weight).
+template <typename Converter, size_t rgbBits, size_t yuvBits, bool isFullRange, Arithmetic arithmetic>
+void calcChroma(uint32_t const sumR, uint32_t const sumG, uint32_t const sumB, uint32_t const log2Weight, typename avif::img::color::YUV<yuvBits>::Type* dstU, typename avif::img::color::YUV<yuvBits>::Type* dstV) {
+  if constexpr (arithmetic == Arithmetic::FixedPoint && avif::img::color::LinearMatrix<Converter>::isSupported) {
+    using FixedPoint = typename avif::img::color::FixedPointQuantizer<Converter, rgbBits, yuvBits, isFullRange>;
+    FixedPoint::calcChroma(sumR, sumG, sumB, log2Weight, dstU, dstV);
+    return;
+  }
+  using Quantizer = typename avif::img::color::Quantizer<rgbBits, yuvBits, isFullRange>;
+  using RGBSpec = typename avif::img::color::RGB<rgbBits>;
+  float const scale = RGBSpec::max * static_cast<float>(1u << log2Weight);
+  float y = {};
+  float u = {};
+  float v = {};
+  Converter::calcYUV(static_cast<float>(sumR) / scale, static_cast<float>(sumG) / scale, static_cast<float>(sumB) / scale, &y, &u, &v);
+  *dstU = Quantizer::quantizeChroma(u);
+  *dstV = Quantizer::quantizeChroma(v);
+}
+
+template <typename Converter, size_t rgbBits, size_t yuvBits, bool isMonoYUV, bool isFullRange, Arithmetic arithmetic = Arithmetic::Float>
 constexpr std::tuple<typename avif::img::color::RGB<rgbBits>::Type, typename avif::img::color::RGB<rgbBits>::Type, typename avif::img::color::RGB<rgbBits>::Type> calcRGB(typename avif::img::color::YUV<yuvBits>::Type const* srcY, typename avif::img::color::YUV<yuvBits>::Type const* srcU, typename avif::img::color::YUV<yuvBits>::Type const* srcV) {
+  if constexpr (arithmetic == Arithmetic::FixedPoint && avif::img::color::LinearMatrix<Converter>::isSupported) {
+    using FixedPoint = typename avif::img::color::FixedPointQuantizer<Converter, rgbBits, yuvBits, isFullRange>;
+    return FixedPoint::calcRGB(srcY, isMonoYUV ? nullptr : srcU, isMonoYUV ? nullptr : srcV);
+  }
+  if constexpr (arithmetic == Arithmetic::LookupTable && yuvBits == 8 && avif::img::color::LookupTable<Converter, isFullRange>::isSupported) {
+    using LookupTable = typename avif::img::color::LookupTable<Converter, isFullRange>;
+    return LookupTable::instance().template calcRGB<rgbBits>(srcY, isMonoYUV ? nullptr : srcU, isMonoYUV ? nullptr : srcV);
+  }
   using avif::img::color::clamp;
   using Quantizer = typename avif::img::color::Quantizer<rgbBits, yuvBits, isFullRange>;
   using RGBSpec = typename avif::img::color::RGB<rgbBits>;
@@ -76,7 +174,7 @@ constexpr std::tuple<typename avif::img::color::RGB<rgbBits>::Type, typename avi
 }
 
 // MonochromeYUV version
-template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange>
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange, Arithmetic arithmetic = Arithmetic::Float>
 void constexpr convertFromRGB(size_t width, size_t height, uint8_t bytesPerPixel, uint8_t const* src, size_t const stride, uint8_t* const dstY, size_t const strideY) {
   using avif::img::color::clamp;
   using RGBSpec = typename avif::img::color::RGB<rgbBits>;
@@ -93,12 +191,12 @@ void constexpr convertFromRGB(size_t width, size_t height, uint8_t bytesPerPixel
     for (size_t x = 0; x < width; ++x) {
       if(fromMonoRGB) {
         uint16_t const mono = reinterpret_cast<RGBType const *>(ptr)[0];
-        calcYUV<Converter, rgbBits, yuvBits, true, isFullRange>(mono, mono, mono, &ptrY[x], nullptr, nullptr);
+        calcYUV<Converter, rgbBits, yuvBits, true, isFullRange, arithmetic>(mono, mono, mono, &ptrY[x], nullptr, nullptr);
       } else {
         uint16_t const r = reinterpret_cast<RGBType const *>(ptr)[0];
         uint16_t const g = reinterpret_cast<RGBType const *>(ptr)[1];
         uint16_t const b = reinterpret_cast<RGBType const *>(ptr)[2];
-        calcYUV<Converter, rgbBits, yuvBits, true, isFullRange>(r, g, b, &ptrY[x], nullptr, nullptr);
+        calcYUV<Converter, rgbBits, yuvBits, true, isFullRange, arithmetic>(r, g, b, &ptrY[x], nullptr, nullptr);
       }
       ptr += bytesPerPixel;
     }
@@ -107,7 +205,7 @@ void constexpr convertFromRGB(size_t width, size_t height, uint8_t bytesPerPixel
   }
 }
 
-template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange, bool subX, bool subY>
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange, bool subX, bool subY, Arithmetic arithmetic = Arithmetic::Float>
 void constexpr convertFromRGB(size_t width, size_t height, uint8_t bytesPerPixel, uint8_t const* src, size_t const stride, uint8_t* const dstY, size_t const strideY, uint8_t* const dstU, size_t const strideU, uint8_t* const dstV, size_t const strideV) {
   using avif::img::color::clamp;
   using RGBSpec = typename avif::img::color::RGB<rgbBits>;
@@ -131,12 +229,12 @@ void constexpr convertFromRGB(size_t width, size_t height, uint8_t bytesPerPixel
     for (size_t x = 0; x < width; ++x) {
       if(fromMonoRGB) {
         uint16_t const mono = reinterpret_cast<RGBType const *>(ptr)[0];
-        calcYUV<Converter, rgbBits, yuvBits, false, isFullRange>(mono, mono, mono, &ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
+        calcYUV<Converter, rgbBits, yuvBits, false, isFullRange, arithmetic>(mono, mono, mono, &ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
       } else {
         uint16_t const r = reinterpret_cast<RGBType const *>(ptr)[0];
         uint16_t const g = reinterpret_cast<RGBType const *>(ptr)[1];
         uint16_t const b = reinterpret_cast<RGBType const *>(ptr)[2];
-        calcYUV<Converter, rgbBits, yuvBits, false, isFullRange>(r, g, b, &ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
+        calcYUV<Converter, rgbBits, yuvBits, false, isFullRange, arithmetic>(r, g, b, &ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
       }
       ptr += bytesPerPixel;
     }
@@ -148,7 +246,7 @@ void constexpr convertFromRGB(size_t width, size_t height, uint8_t bytesPerPixel
 }
 
 // MonochromeYUV version
-template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange>
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange, Arithmetic arithmetic = Arithmetic::Float>
 void constexpr convertFromYUV(size_t width, size_t height, uint8_t bytesPerPixel, uint8_t* dst, size_t stride, uint8_t const* srcY, size_t strideY) {
   using RGBSpec = typename avif::img::color::RGB<rgbBits>;
   using YUVSpec = typename avif::img::color::YUV<yuvBits>;
@@ -164,12 +262,12 @@ void constexpr convertFromYUV(size_t width, size_t height, uint8_t bytesPerPixel
     for (size_t x = 0; x < width; ++x) {
       if(toMonoRGB) {
         RGBType& mono = reinterpret_cast<RGBType*>(ptr)[0];
-        std::tie(mono, mono, mono) = calcRGB<Converter, rgbBits, yuvBits, true, isFullRange>(&ptrY[x], nullptr, nullptr);
+        std::tie(mono, mono, mono) = calcRGB<Converter, rgbBits, yuvBits, true, isFullRange, arithmetic>(&ptrY[x], nullptr, nullptr);
       } else {
         RGBType& r = reinterpret_cast<RGBType*>(ptr)[0];
         RGBType& g = reinterpret_cast<RGBType*>(ptr)[1];
         RGBType& b = reinterpret_cast<RGBType*>(ptr)[2];
-        std::tie(r,g,b) = calcRGB<Converter, rgbBits, yuvBits, true, isFullRange>(&ptrY[x], nullptr, nullptr);
+        std::tie(r,g,b) = calcRGB<Converter, rgbBits, yuvBits, true, isFullRange, arithmetic>(&ptrY[x], nullptr, nullptr);
       }
       ptr += bytesPerPixel;
     }
@@ -178,7 +276,7 @@ void constexpr convertFromYUV(size_t width, size_t height, uint8_t bytesPerPixel
   }
 }
 
-template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange, bool subX, bool subY>
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange, bool subX, bool subY, Arithmetic arithmetic = Arithmetic::Float>
 void constexpr convertFromYUV(size_t width, size_t height, uint8_t bytesPerPixel, uint8_t* dst, size_t stride, uint8_t const* srcY, size_t strideY, uint8_t const* srcU, size_t strideU, uint8_t const* srcV, size_t strideV) {
   using RGBSpec = typename avif::img::color::RGB<rgbBits>;
   using YUVSpec = typename avif::img::color::YUV<yuvBits>;
@@ -200,12 +298,12 @@ void constexpr convertFromYUV(size_t width, size_t height, uint8_t bytesPerPixel
     for (size_t x = 0; x < width; ++x) {
       if(toMonoRGB) {
         RGBType& mono = reinterpret_cast<RGBType*>(ptr)[0];
-        std::tie(mono, mono, mono) = calcRGB<Converter, rgbBits, yuvBits, false, isFullRange>(&ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
+        std::tie(mono, mono, mono) = calcRGB<Converter, rgbBits, yuvBits, false, isFullRange, arithmetic>(&ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
       } else {
         RGBType& r = reinterpret_cast<RGBType*>(ptr)[0];
         RGBType& g = reinterpret_cast<RGBType*>(ptr)[1];
         RGBType& b = reinterpret_cast<RGBType*>(ptr)[2];
-        std::tie(r,g,b) = calcRGB<Converter, rgbBits, yuvBits, false, isFullRange>(&ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
+        std::tie(r,g,b) = calcRGB<Converter, rgbBits, yuvBits, false, isFullRange, arithmetic>(&ptrY[x], sampler.pixelInLine(ptrU, x), sampler.pixelInLine(ptrV, x));
       }
       ptr += bytesPerPixel;
     }
@@ -216,31 +314,383 @@ void constexpr convertFromYUV(size_t width, size_t height, uint8_t bytesPerPixel
   }
 }
 
+// The pixels a subsampled chroma sample averages along one axis, clamped to the image.
+struct ChromaTaps final {
+  size_t positions[3];
+  uint32_t weights[3];
+  size_t count;
+  uint32_t log2Weight; // The weights add up to (1 << log2Weight).
+};
+
+inline ChromaTaps chromaTaps(size_t const index, size_t const length, bool const subsampled, bool const cosited) {
+  if(!subsampled) {
+    return {{index, 0, 0}, {1, 0, 0}, 1, 0};
+  }
+  size_t const center = index * 2;
+  size_t const next = std::min(center + 1, length - 1);
+  if(cosited) {
+    return {{center == 0 ? 0 : center - 1, center, next}, {1, 2, 1}, 3, 2};
+  }
+  return {{center, next, 0}, {1, 1, 0}, 2, 1};
+}
+
+// Writes chroma rows [chromaRowBegin, chromaRowEnd) of the whole image, once per chroma sample.
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange, bool subX, bool subY, Arithmetic arithmetic = Arithmetic::Float>
+void downsampleChroma(ChromaSamplePosition const position, size_t const width, size_t const height, uint8_t const bytesPerPixel, uint8_t const* const src, size_t const stride, size_t const chromaRowBegin, size_t const chromaRowEnd, uint8_t* const dstU, size_t const strideU, uint8_t* const dstV, size_t const strideV) {
+  using RGBType = typename avif::img::color::RGB<rgbBits>::Type;
+  using YUVType = typename avif::img::color::YUV<yuvBits>::Type;
+  bool const cositedX = position == ChromaSamplePosition::Vertical || position == ChromaSamplePosition::Colocated;
+  bool const cositedY = position == ChromaSamplePosition::Colocated;
+  size_t const chromaWidth = subX ? (width + 1) / 2 : width;
+  // Vertically weighted sums of r, g and b for each pixel of the row.
+  std::vector<uint32_t> sums(width * 3);
+  for(size_t cy = chromaRowBegin; cy < chromaRowEnd; ++cy) {
+    ChromaTaps const vertical = chromaTaps(cy, height, subY, cositedY);
+    std::fill(sums.begin(), sums.end(), 0);
+    for(size_t i = 0; i < vertical.count; ++i) {
+      uint8_t const* ptr = src + vertical.positions[i] * stride;
+      uint32_t const weight = vertical.weights[i];
+      for(size_t x = 0; x < width; ++x) {
+        auto const* const pixel = reinterpret_cast<RGBType const*>(ptr);
+        sums[x * 3 + 0] += weight * pixel[0];
+        sums[x * 3 + 1] += weight * pixel[fromMonoRGB ? 0 : 1];
+        sums[x * 3 + 2] += weight * pixel[fromMonoRGB ? 0 : 2];
+        ptr += bytesPerPixel;
+      }
+    }
+    auto* const lineU = reinterpret_cast<YUVType*>(dstU + cy * strideU);
+    auto* const lineV = reinterpret_cast<YUVType*>(dstV + cy * strideV);
+    for(size_t cx = 0; cx < chromaWidth; ++cx) {
+      ChromaTaps const horizontal = chromaTaps(cx, width, subX, cositedX);
+      uint32_t r = 0;
+      uint32_t g = 0;
+      uint32_t b = 0;
+      for(size_t i = 0; i < horizontal.count; ++i) {
+        uint32_t const* const sum = &sums[horizontal.positions[i] * 3];
+        r += horizontal.weights[i] * sum[0];
+        g += horizontal.weights[i] * sum[1];
+        b += horizontal.weights[i] * sum[2];
+      }
+      calcChroma<Converter, rgbBits, yuvBits, isFullRange, arithmetic>(r, g, b, vertical.log2Weight + horizontal.log2Weight, &lineU[cx], &lineV[cx]);
+    }
+  }
+}
+
+// Bilinear chroma of row y of the whole image, at full width: the weights of both directions add up to 4.
+// "vertical" is scratch space of the chroma width.
+template <uint8_t yuvBits, bool subX, bool subY>
+void upsampleChroma(ChromaSamplePosition const position, size_t const width, size_t const height, uint8_t const* const src, size_t const stride, size_t const y, std::vector<uint32_t>& vertical, typename avif::img::color::YUV<yuvBits>::Type* const dst) {
+  using YUVType = typename avif::img::color::YUV<yuvBits>::Type;
+  bool const cositedX = position == ChromaSamplePosition::Vertical || position == ChromaSamplePosition::Colocated;
+  bool const cositedY = position == ChromaSamplePosition::Colocated;
+  size_t const chromaWidth = subX ? (width + 1) / 2 : width;
+  size_t const chromaHeight = subY ? (height + 1) / 2 : height;
+  size_t const cy = subY ? y / 2 : y;
+  size_t neighbour = cy;
+  uint32_t weight = 4;
+  if(subY) {
+    if(cositedY) {
+      neighbour = y % 2 == 0 ? cy : std::min(cy + 1, chromaHeight - 1);
+      weight = y % 2 == 0 ? 4 : 2;
+    } else {
+      neighbour = y % 2 == 0 ? (cy == 0 ? 0 : cy - 1) : std::min(cy + 1, chromaHeight - 1);
+      weight = 3;
+    }
+  }
+  auto const* const line = reinterpret_cast<YUVType const*>(src + cy * stride);
+  auto const* const neighbourLine = reinterpret_cast<YUVType const*>(src + neighbour * stride);
+  for(size_t cx = 0; cx < chromaWidth; ++cx) {
+    vertical[cx] = weight * line[cx] + (4 - weight) * neighbourLine[cx];
+  }
+  if(!subX) {
+    for(size_t x = 0; x < width; ++x) {
+      dst[x] = static_cast<YUVType>((vertical[x] + 2) >> 2u);
+    }
+    return;
+  }
+  for(size_t x = 0; x < width; ++x) {
+    size_t const cx = x / 2;
+    uint32_t sum;
+    if(cositedX) {
+      sum = x % 2 == 0 ? 4 * vertical[cx] : 2 * vertical[cx] + 2 * vertical[std::min(cx + 1, chromaWidth - 1)];
+    } else {
+      size_t const next = x % 2 == 0 ? (cx == 0 ? 0 : cx - 1) : std::min(cx + 1, chromaWidth - 1);
+      sum = 3 * vertical[cx] + vertical[next];
+    }
+    dst[x] = static_cast<YUVType>((sum + 8) >> 4u);
+  }
+}
+
+// Runs the SIMD kernels if the converter and the CPU allow. Returns false to fall back to the templates above.
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange>
+bool convertFromRGBWithSIMD(size_t width, size_t height, uint8_t bytesPerPixel, uint8_t const* src, size_t const stride, uint8_t* const dstY, size_t const strideY, uint8_t* const dstU, size_t const strideU, uint8_t* const dstV, size_t const strideV, bool const subX, bool const subY) {
+  if constexpr (std::is_base_of<avif::img::color::PrimariesConverter<Converter>, Converter>::value) {
+    avif::img::simd::RGBToYUV const spec {
+      Converter::Kr, Converter::Kg, Converter::Kb,
+      rgbBits, yuvBits, isFullRange, fromMonoRGB, bytesPerPixel,
+    };
+    return avif::img::simd::convertFromRGB(spec, width, height, src, stride, dstY, strideY, dstU, strideU, dstV, strideV, subX, subY);
+  } else {
+    return false;
+  }
+}
+
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange>
+bool convertFromYUVWithSIMD(size_t width, size_t height, uint8_t bytesPerPixel, uint8_t* const dst, size_t const stride, uint8_t const* const srcY, size_t const strideY, uint8_t const* const srcU, size_t const strideU, uint8_t const* const srcV, size_t const strideV, bool const subX, bool const subY) {
+  if constexpr (std::is_base_of<avif::img::color::PrimariesConverter<Converter>, Converter>::value) {
+    avif::img::simd::YUVToRGB const spec {
+      Converter::Cr_R, Converter::Cb_G, Converter::Cr_G, Converter::Cb_B,
+      rgbBits, yuvBits, isFullRange, toMonoRGB, bytesPerPixel,
+    };
+    return avif::img::simd::convertFromYUV(spec, width, height, dst, stride, srcY, strideY, srcU, strideU, srcV, strideV, subX, subY);
+  } else {
+    return false;
+  }
+}
+
+// Bands smaller than this are not worth a thread.
+constexpr size_t kMinRowsPerBand = 16;
+
+// Calls convertBand(firstRow, rows) for each band of rows, as options.threads and options.executor say.
+// With subY, bands start at even rows, so both rows sharing a chroma row stay in the same band.
+// Returns false without calling it if the image is converted in one band.
+template <typename F>
+bool forEachBand(ConversionOptions const& options, size_t const height, bool const subY, F&& convertBand) {
+  size_t threads = options.threads != 0 ? options.threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  threads = std::min(threads, (height + kMinRowsPerBand - 1) / kMinRowsPerBand);
+  if(threads <= 1) {
+    return false;
+  }
+  size_t rowsPerBand = (height + threads - 1) / threads;
+  if(subY) {
+    rowsPerBand += rowsPerBand % 2;
+  }
+  size_t const count = (height + rowsPerBand - 1) / rowsPerBand;
+  std::vector<std::exception_ptr> errors(count);
+  std::function<void(size_t)> const task = [&](size_t const band) {
+    try {
+      size_t const firstRow = band * rowsPerBand;
+      convertBand(firstRow, std::min(rowsPerBand, height - firstRow));
+    } catch(...) {
+      errors[band] = std::current_exception();
+    }
+  };
+  if(options.executor) {
+    options.executor(count, task);
+  } else {
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for(size_t band = 1; band < count; ++band) {
+      workers.emplace_back(task, band);
+    }
+    task(0);
+    for(std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+  for(std::exception_ptr const& error : errors) {
+    if(error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return true;
+}
+
+// Runs one conversion as the options say. U and V are unused for monochrome YUV.
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool fromMonoRGB, bool isFullRange, bool isMonoYUV, bool subX, bool subY>
+void dispatchFromRGB(ConversionOptions const& options, size_t width, size_t height, uint8_t bytesPerPixel, uint8_t const* src, size_t const stride, uint8_t* const dstY, size_t const strideY, uint8_t* const dstU, size_t const strideU, uint8_t* const dstV, size_t const strideV) {
+  if constexpr (!isMonoYUV && (subX || subY)) {
+    if(options.chromaDownsampling == ChromaDownsampling::Box) {
+      // Luma as monochrome YUV, then each chroma sample once.
+      dispatchFromRGB<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, true, false, false>(options, width, height, bytesPerPixel, src, stride, dstY, strideY, nullptr, 0, nullptr, 0);
+      auto const downsample = [&](size_t const firstRow, size_t const rows) {
+        if(options.arithmetic == Arithmetic::FixedPoint) {
+          downsampleChroma<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, subX, subY, Arithmetic::FixedPoint>(options.chromaSamplePosition, width, height, bytesPerPixel, src, stride, firstRow, firstRow + rows, dstU, strideU, dstV, strideV);
+        } else {
+          downsampleChroma<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, subX, subY, Arithmetic::Float>(options.chromaSamplePosition, width, height, bytesPerPixel, src, stride, firstRow, firstRow + rows, dstU, strideU, dstV, strideV);
+        }
+      };
+      size_t const chromaHeight = subY ? (height + 1) / 2 : height;
+      if(!forEachBand(options, chromaHeight, false, downsample)) {
+        downsample(0, chromaHeight);
+      }
+      return;
+    }
+  }
+  ConversionOptions band = options;
+  band.threads = 1;
+  bool const parallel = forEachBand(options, height, subY, [&](size_t const firstRow, size_t const rows) {
+    size_t const chromaRow = subY ? firstRow / 2 : firstRow;
+    dispatchFromRGB<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, isMonoYUV, subX, subY>(
+        band, width, rows, bytesPerPixel,
+        src + firstRow * stride, stride,
+        dstY + firstRow * strideY, strideY,
+        isMonoYUV ? nullptr : dstU + chromaRow * strideU, strideU,
+        isMonoYUV ? nullptr : dstV + chromaRow * strideV, strideV);
+  });
+  if(parallel) {
+    return;
+  }
+  auto const run = [&](auto arithmeticConstant) {
+    constexpr Arithmetic arithmetic = decltype(arithmeticConstant)::value;
+    if constexpr (isMonoYUV) {
+      convertFromRGB<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, arithmetic>(width, height, bytesPerPixel, src, stride, dstY, strideY);
+    } else {
+      convertFromRGB<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, subX, subY, arithmetic>(width, height, bytesPerPixel, src, stride, dstY, strideY, dstU, strideU, dstV, strideV);
+    }
+  };
+  switch(options.arithmetic) {
+    case Arithmetic::Float:
+    case Arithmetic::LookupTable: // Only for YUV -> RGB.
+      if(convertFromRGBWithSIMD<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange>(width, height, bytesPerPixel, src, stride, dstY, strideY, isMonoYUV ? nullptr : dstU, strideU, isMonoYUV ? nullptr : dstV, strideV, subX, subY)) {
+        return;
+      }
+      run(std::integral_constant<Arithmetic, Arithmetic::Float>{});
+      return;
+    case Arithmetic::FixedPoint:
+      run(std::integral_constant<Arithmetic, Arithmetic::FixedPoint>{});
+      return;
+  }
+  throw std::invalid_argument(fmt::format("Unknown arithmetic: {}", static_cast<int>(options.arithmetic)));
+}
+
+// Runs one conversion as the options say. U and V are unused for monochrome YUV.
+template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange, bool isMonoYUV, bool subX, bool subY>
+void dispatchFromYUV(ConversionOptions const& options, size_t width, size_t height, uint8_t bytesPerPixel, uint8_t* const dst, size_t const stride, uint8_t const* const srcY, size_t const strideY, uint8_t const* const srcU, size_t const strideU, uint8_t const* const srcV, size_t const strideV) {
+  if constexpr (!isMonoYUV && (subX || subY)) {
+    if(options.chromaUpsampling == ChromaUpsampling::Bilinear) {
+      // Upsamples one row of chroma at a time, and converts the row as 4:4:4.
+      using YUVType = typename avif::img::color::YUV<yuvBits>::Type;
+      ConversionOptions row = options;
+      row.threads = 1;
+      auto const convertRows = [&](size_t const firstRow, size_t const rows) {
+        size_t const chromaWidth = subX ? (width + 1) / 2 : width;
+        std::vector<uint32_t> vertical(chromaWidth);
+        std::vector<YUVType> u(width);
+        std::vector<YUVType> v(width);
+        for(size_t y = firstRow; y < firstRow + rows; ++y) {
+          upsampleChroma<yuvBits, subX, subY>(options.chromaSamplePosition, width, height, srcU, strideU, y, vertical, u.data());
+          upsampleChroma<yuvBits, subX, subY>(options.chromaSamplePosition, width, height, srcV, strideV, y, vertical, v.data());
+          dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, false, false>(
+              row, width, 1, bytesPerPixel,
+              dst + y * stride, stride,
+              srcY + y * strideY, strideY,
+              reinterpret_cast<uint8_t const*>(u.data()), 0,
+              reinterpret_cast<uint8_t const*>(v.data()), 0);
+        }
+      };
+      if(!forEachBand(options, height, false, convertRows)) {
+        convertRows(0, height);
+      }
+      return;
+    }
+  }
+  ConversionOptions band = options;
+  band.threads = 1;
+  bool const parallel = forEachBand(options, height, subY, [&](size_t const firstRow, size_t const rows) {
+    size_t const chromaRow = subY ? firstRow / 2 : firstRow;
+    dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, isMonoYUV, subX, subY>(
+        band, width, rows, bytesPerPixel,
+        dst + firstRow * stride, stride,
+        srcY + firstRow * strideY, strideY,
+        isMonoYUV ? nullptr : srcU + chromaRow * strideU, strideU,
+        isMonoYUV ? nullptr : srcV + chromaRow * strideV, strideV);
+  });
+  if(parallel) {
+    return;
+  }
+  auto const run = [&](auto arithmeticConstant) {
+    constexpr Arithmetic arithmetic = decltype(arithmeticConstant)::value;
+    if constexpr (isMonoYUV) {
+      convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, arithmetic>(width, height, bytesPerPixel, dst, stride, srcY, strideY);
+    } else {
+      convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, subX, subY, arithmetic>(width, height, bytesPerPixel, dst, stride, srcY, strideY, srcU, strideU, srcV, strideV);
+    }
+  };
+  switch(options.arithmetic) {
+    case Arithmetic::Float:
+      if(convertFromYUVWithSIMD<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange>(width, height, bytesPerPixel, dst, stride, srcY, strideY, isMonoYUV ? nullptr : srcU, strideU, isMonoYUV ? nullptr : srcV, strideV, subX, subY)) {
+        return;
+      }
+      run(std::integral_constant<Arithmetic, Arithmetic::Float>{});
+      return;
+    case Arithmetic::FixedPoint:
+      run(std::integral_constant<Arithmetic, Arithmetic::FixedPoint>{});
+      return;
+    case Arithmetic::LookupTable:
+      if constexpr (yuvBits == 8 && avif::img::color::LookupTable<Converter, isFullRange>::isSupported) {
+        run(std::integral_constant<Arithmetic, Arithmetic::LookupTable>{});
+        return;
+      } else {
+        ConversionOptions fallback = options;
+        fallback.arithmetic = Arithmetic::Float;
+        dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, isMonoYUV, subX, subY>(fallback, width, height, bytesPerPixel, dst, stride, srcY, strideY, srcU, strideU, srcV, strideV);
+        return;
+      }
+  }
+  throw std::invalid_argument(fmt::format("Unknown arithmetic: {}", static_cast<int>(options.arithmetic)));
+}
+
+template <size_t rgbBits, size_t yuvBits>
+void checkPlanar(Image<rgbBits> const& rgb, PlanarImage<yuvBits> const& yuv, bool const isFullRange) {
+  if(rgb.width() != yuv.width() || rgb.height() != yuv.height()) {
+    throw std::invalid_argument(fmt::format("Size mismatch: {}x{} (RGB) vs {}x{} (YUV)", rgb.width(), rgb.height(), yuv.width(), yuv.height()));
+  }
+  if(yuv.fullRange() != isFullRange) {
+    throw std::invalid_argument(fmt::format("The planar image is in {} range, but the conversion is for {} range.", yuv.fullRange() ? "full" : "limited", isFullRange ? "full" : "limited"));
+  }
+}
+
 }
 
 template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange>
 struct FromRGB final {
-  static void toI400(Image<rgbBits>& src, uint8_t* dstY, size_t strideY) {
-    detail::convertFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange>(src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY);
+  static void toI400(Image<rgbBits>& src, uint8_t* dstY, size_t strideY, ConversionOptions const& options = {}) {
+    detail::dispatchFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, false, false>(options, src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, nullptr, 0, nullptr, 0);
+  }
+  static void toI444(Image<rgbBits> const& src, uint8_t* dstY, size_t strideY, uint8_t* dstU, size_t strideU, uint8_t* dstV, size_t strideV, ConversionOptions const& options = {}) {
+    detail::dispatchFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, false, false>(options, src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, dstU, strideU, dstV, strideV);
   }
-  static void toI444(Image<rgbBits> const& src, uint8_t* dstY, size_t strideY, uint8_t* dstU, size_t strideU, uint8_t* dstV, size_t strideV) {
-    detail::convertFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, false>(src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, dstU, strideU, dstV, strideV);
+  static void toI422(Image<rgbBits> const& src, uint8_t* dstY, size_t strideY, uint8_t* dstU, size_t strideU, uint8_t* dstV, size_t strideV, ConversionOptions const& options = {}) {
+    detail::dispatchFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, true, false>(options, src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, dstU, strideU, dstV, strideV);
   }
-  static void toI422(Image<rgbBits> const& src, uint8_t* dstY, size_t strideY, uint8_t* dstU, size_t strideU, uint8_t* dstV, size_t strideV){
-    detail::convertFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, false>(src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, dstU, strideU, dstV, strideV);
+  static void toI420(Image<rgbBits> const& src, uint8_t* dstY, size_t strideY, uint8_t* dstU, size_t strideU, uint8_t* dstV, size_t strideV, ConversionOptions const& options = {}) {
+    detail::dispatchFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, true, true>(options, src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, dstU, strideU, dstV, strideV);
   }
-  static void toI420(Image<rgbBits> const& src, uint8_t* dstY, size_t strideY, uint8_t* dstU, size_t strideU, uint8_t* dstV, size_t strideV){
-    detail::convertFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, true>(src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, dstU, strideU, dstV, strideV);
+  // Into the planes of dst, in its chroma format. dst must have the size of src and the range of isFullRange.
+  // The alpha plane is left untouched: see FromAlpha::toPlanar.
+  static void toPlanar(Image<rgbBits> const& src, PlanarImage<yuvBits>& dst, ConversionOptions const& options = {}) {
+    detail::checkPlanar(src, dst, isFullRange);
+    uint8_t* const dstY = dst.data(Plane::Y);
+    uint8_t* const dstU = dst.data(Plane::U);
+    uint8_t* const dstV = dst.data(Plane::V);
+    size_t const strideY = dst.stride(Plane::Y);
+    size_t const strideU = dst.stride(Plane::U);
+    size_t const strideV = dst.stride(Plane::V);
+    switch(dst.chromaFormat()) {
+      case ChromaFormat::I400:
+        detail::dispatchFromRGB<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, false, false>(options, src.width(), src.height(), src.bytesPerPixel(), src.data(), src.stride(), dstY, strideY, nullptr, 0, nullptr, 0);
+        break;
+      case ChromaFormat::I444:
+        toI444(src, dstY, strideY, dstU, strideU, dstV, strideV, options);
+        break;
+      case ChromaFormat::I422:
+        toI422(src, dstY, strideY, dstU, strideU, dstV, strideV, options);
+        break;
+      case ChromaFormat::I420:
+        toI420(src, dstY, strideY, dstU, strideU, dstV, strideV, options);
+        break;
+    }
   }
 };
 
 template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool isFullRange>
 struct FromAlpha final {
-  static void toI400(Image<rgbBits>& src, uint8_t* dstY, size_t strideY) {
+  static void toI400(Image<rgbBits>& src, uint8_t* dstY, size_t strideY, ConversionOptions const& options = {}) {
     switch(src.pixelOrder()) {
       case avif::img::PixelOrder::MonoA:
       case avif::img::PixelOrder::RGBA:
-        detail::convertFromRGB<Converter, rgbBits, yuvBits, true, isFullRange>(src.width(), src.height(), src.bytesPerPixel(), src.data() + (src.numComponents() - 1) * src.bytesPerComponent(), src.stride(), dstY, strideY);
+        detail::dispatchFromRGB<Converter, rgbBits, yuvBits, true, isFullRange, true, false, false>(options, src.width(), src.height(), src.bytesPerPixel(), src.data() + (src.numComponents() - 1) * src.bytesPerComponent(), src.stride(), dstY, strideY, nullptr, 0, nullptr, 0);
         break;
       case avif::img::PixelOrder::Mono:
         throw std::domain_error("Cannot separate Alpha from Mono image.");
@@ -248,30 +698,80 @@ struct FromAlpha final {
         throw std::domain_error("Cannot separate Alpha from RGB image.");
     }
   }
+  // Into the alpha plane of dst.
+  static void toPlanar(Image<rgbBits>& src, PlanarImage<yuvBits>& dst, ConversionOptions const& options = {}) {
+    detail::checkPlanar(src, dst, isFullRange);
+    if(!dst.hasAlpha()) {
+      throw std::domain_error("The planar image does not have an alpha plane.");
+    }
+    toI400(src, dst.data(Plane::A), dst.stride(Plane::A), options);
+  }
 };
 
 template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool toMonoRGB, bool isFullRange>
 struct ToRGB final {
-  static void fromI400(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY) {
-    detail::convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange>(dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY);
+  static void fromI400(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, ConversionOptions const& options = {}) {
+    detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, false, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, nullptr, 0, nullptr, 0);
   }
-  static void fromI444(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, uint8_t* srcU, size_t strideU, uint8_t* srcV, size_t strideV) {
-    detail::convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, false>(dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+  static void fromI444(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, uint8_t* srcU, size_t strideU, uint8_t* srcV, size_t strideV, ConversionOptions const& options = {}) {
+    detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, false, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
   }
-  static void fromI422(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, uint8_t* srcU, size_t strideU, uint8_t* srcV, size_t strideV){
-    detail::convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, false>(dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+  static void fromI422(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, uint8_t* srcU, size_t strideU, uint8_t* srcV, size_t strideV, ConversionOptions const& options = {}) {
+    detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, true, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
   }
-  static void fromI420(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, uint8_t* srcU, size_t strideU, uint8_t* srcV, size_t strideV){
-    detail::convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, true>(dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+  static void fromI420(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, uint8_t* srcU, size_t strideU, uint8_t* srcV, size_t strideV, ConversionOptions const& options = {}) {
+    detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, true, true>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+  }
+  // From the planes of src, in its chroma format. src must have the size of dst and the range of isFullRange.
+  // The alpha plane is not read: see ToAlpha::fromPlanar.
+  static void fromPlanar(Image<rgbBits>& dst, PlanarImage<yuvBits> const& src, ConversionOptions const& options = {}) {
+    detail::checkPlanar(dst, src, isFullRange);
+    uint8_t const* const srcY = src.data(Plane::Y);
+    uint8_t const* const srcU = src.data(Plane::U);
+    uint8_t const* const srcV = src.data(Plane::V);
+    size_t const strideY = src.stride(Plane::Y);
+    size_t const strideU = src.stride(Plane::U);
+    size_t const strideV = src.stride(Plane::V);
+    switch(src.chromaFormat()) {
+      case ChromaFormat::I400:
+        detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, true, false, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, nullptr, 0, nullptr, 0);
+        break;
+      case ChromaFormat::I444:
+        detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, false, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+        break;
+      case ChromaFormat::I422:
+        detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, true, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+        break;
+      case ChromaFormat::I420:
+        detail::dispatchFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, false, true, true>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data(), dst.stride(), srcY, strideY, srcU, strideU, srcV, strideV);
+        break;
+    }
   }
 };
 template <typename Converter, uint8_t rgbBits, uint8_t yuvBits, bool isFullRange>
 struct ToAlpha final {
-  static void fromI400(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY) {
+  static void fromI400(Image<rgbBits>& dst, uint8_t* srcY, size_t strideY, ConversionOptions const& options = {}) {
+    switch(dst.pixelOrder()) {
+      case avif::img::PixelOrder::MonoA:
+      case avif::img::PixelOrder::RGBA:
+        detail::dispatchFromYUV<Converter, rgbBits, yuvBits, true, isFullRange, true, false, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data() + (dst.numComponents() - 1) * dst.bytesPerComponent(), dst.stride(), srcY, strideY, nullptr, 0, nullptr, 0);
+        break;
+      case avif::img::PixelOrder::Mono:
+        throw std::domain_error("Cannot store Alpha to Mono image.");
+      case avif::img::PixelOrder::RGB:
+        throw std::domain_error("Cannot store Alpha to RGB image.");
+    }
+  }
+  // From the alpha plane of src.
+  static void fromPlanar(Image<rgbBits>& dst, PlanarImage<yuvBits> const& src, ConversionOptions const& options = {}) {
+    detail::checkPlanar(dst, src, isFullRange);
+    if(!src.hasAlpha()) {
+      throw std::domain_error("The planar image does not have an alpha plane.");
+    }
     switch(dst.pixelOrder()) {
       case avif::img::PixelOrder::MonoA:
       case avif::img::PixelOrder::RGBA:
-        detail::convertFromYUV<Converter, rgbBits, yuvBits, true, isFullRange>(dst.width(), dst.height(), dst.bytesPerPixel(), dst.data() + (dst.numComponents() - 1) * dst.bytesPerComponent(), dst.stride(), srcY, strideY);
+        detail::dispatchFromYUV<Converter, rgbBits, yuvBits, true, isFullRange, true, false, false>(options, dst.width(), dst.height(), dst.bytesPerPixel(), dst.data() + (dst.numComponents() - 1) * dst.bytesPerComponent(), dst.stride(), src.data(Plane::A), src.stride(Plane::A), nullptr, 0, nullptr, 0);
         break;
       case avif::img::PixelOrder::Mono:
         throw std::domain_error("Cannot store Alpha to Mono image.");
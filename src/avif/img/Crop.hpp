@@ -6,32 +6,53 @@
 
 #include <cassert>
 #include <cmath>
+#include <algorithm>
+#include <stdexcept>
 #include "Image.hpp"
+#include "PlanarImage.hpp"
 #include "../CleanApertureBox.hpp"
 
 namespace avif::img {
 
-template <size_t BitsPerComponent>
-Image<BitsPerComponent> crop(Image<BitsPerComponent> const& src, CleanApertureBox const& clap) {
+namespace detail {
+
+struct CropRect final {
+  size_t x;
+  size_t y;
+  size_t width;
+  size_t height;
+};
+
+inline CropRect calcCropRect(size_t const srcWidth, size_t const srcHeight, CleanApertureBox const& clap) {
   // ISO/IEC 14496-12:2015(E)
   // p.157
 
   float const horizOff = static_cast<float>(clap.horizOffN)/static_cast<float>(clap.horizOffD);
   float const vertOff = static_cast<float>(clap.vertOffN)/static_cast<float>(clap.vertOffD);
 
-  float const pcX = horizOff + (static_cast<float>(src.width()) - 1)/2;
-  float const pcY = vertOff + (static_cast<float>(src.height()) - 1)/2;
+  float const pcX = horizOff + (static_cast<float>(srcWidth) - 1)/2;
+  float const pcY = vertOff + (static_cast<float>(srcHeight) - 1)/2;
 
   float const cleanApertureWidth = static_cast<float>(clap.cleanApertureWidthN)/static_cast<float>(clap.cleanApertureWidthD);
   float const cleanApertureHeight = static_cast<float>(clap.cleanApertureHeightN)/static_cast<float>(clap.cleanApertureHeightD);
 
-  size_t const offX = std::max(static_cast<size_t>(std::round(pcX - (cleanApertureWidth - 1) / 2)), static_cast<size_t>(0));
-  size_t const offY = std::max(static_cast<size_t>(std::round(pcY - (cleanApertureHeight - 1) / 2)), static_cast<size_t>(0));
+  // Clamped before the cast, as negative floats do not convert to size_t.
+  auto const offX = static_cast<size_t>(std::max(std::round(pcX - (cleanApertureWidth - 1) / 2), 0.0f));
+  auto const offY = static_cast<size_t>(std::max(std::round(pcY - (cleanApertureHeight - 1) / 2), 0.0f));
+
+  size_t const width = std::min(static_cast<size_t>(std::round(cleanApertureWidth)), srcWidth - offX);
+  size_t const height = std::min(static_cast<size_t>(std::round(cleanApertureHeight)), srcHeight - offY);
+  return CropRect{offX, offY, width, height};
+}
+
+}
 
-  size_t const width = std::min(static_cast<size_t>(std::round(cleanApertureWidth)), src.width() - offX);
-  size_t const height = std::min(static_cast<size_t>(std::round(cleanApertureHeight)), src.height() - offY);
+template <size_t BitsPerComponent>
+Image<BitsPerComponent> crop(Image<BitsPerComponent> const& src, CleanApertureBox const& clap) {
+  auto const [offX, offY, width, height] = detail::calcCropRect(src.width(), src.height(), clap);
 
-  Image<BitsPerComponent> dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), width, height);
+  Image<BitsPerComponent> dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), width, height, AllocationPolicy::packedUninitialized());
+  dst.colorProfile() = src.colorProfile();
 
   // src
   size_t const srcStride = src.stride();
@@ -56,4 +77,45 @@ Image<BitsPerComponent> crop(Image<BitsPerComponent> const& src, CleanApertureBo
   return dst;
 }
 
+// The same rectangle as crop(), as a view of src: no pixels are copied, and the view keeps the pixels of src alive.
+// Writing into the view writes into src.
+template <size_t BitsPerComponent>
+Image<BitsPerComponent> cropView(Image<BitsPerComponent>& src, CleanApertureBox const& clap) {
+  auto const [offX, offY, width, height] = detail::calcCropRect(src.width(), src.height(), clap);
+  return src.view(offX, offY, width, height);
+}
+
+// MIAF requires the offsets of subsampled images to be even, so that chroma stays aligned with luma.
+// Throws std::domain_error if they are not.
+template <size_t BitsPerComponent>
+PlanarImage<BitsPerComponent> crop(PlanarImage<BitsPerComponent> const& src, CleanApertureBox const& clap) {
+  auto const [offX, offY, width, height] = detail::calcCropRect(src.width(), src.height(), clap);
+  ChromaFormat const format = src.chromaFormat();
+  if((isSubsampledX(format) && offX % 2 != 0) || (isSubsampledY(format) && offY % 2 != 0)) {
+    throw std::domain_error(fmt::format("The clean aperture at ({}, {}) is not aligned to the chroma subsampling.", offX, offY));
+  }
+  using Planar = PlanarImage<BitsPerComponent>;
+  Planar dst = Planar::create(format, width, height, src.fullRange(), src.hasAlpha(), AllocationPolicy::uninitialized());
+  dst.colorProfile() = src.colorProfile();
+  for (Plane const plane : {Plane::Y, Plane::U, Plane::V, Plane::A}) {
+    uint8_t const* srcLine = src.data(plane);
+    if (srcLine == nullptr) {
+      continue;
+    }
+    size_t const srcStride = src.stride(plane);
+    srcLine += srcStride * Planar::calcPlaneHeight(format, offY, plane);
+    size_t const lineOffset = Planar::calcPlaneWidth(format, offX, plane) * sizeof(typename Planar::Type);
+    size_t const lineCopySize = dst.planeWidth(plane) * sizeof(typename Planar::Type);
+    uint8_t* dstLine = dst.data(plane);
+    size_t const dstStride = dst.stride(plane);
+    size_t const dstHeight = dst.planeHeight(plane);
+    for (size_t y = 0; y < dstHeight; ++y) {
+      std::copy(srcLine + lineOffset, srcLine + lineOffset + lineCopySize, dstLine);
+      srcLine += srcStride;
+      dstLine += dstStride;
+    }
+  }
+  return dst;
+}
+
 }
@@ -5,11 +5,16 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <cstdint>
 #include <cassert>
 #include <variant>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
 
 #include "./color/Math.hpp"
+#include "./PixelBuffer.hpp"
 #include "./color/Matrix.hpp"
 #include "../ColourInformationBox.hpp"
 
@@ -62,6 +67,12 @@ public:
   std::optional<ColourInformationBox::CICP> cicp;
 };
 
+// Pixels in rows of stride() bytes.
+//
+// An image either owns its pixels, or is a view of a rectangle of another image (view(), cropView()).
+// A view keeps the pixels of its parent alive and shares them: writing into one shows up in the other.
+// So views are only taken of images that may be written, as with PlanarImage::view().
+// Copying an image, a view included, copies its pixels into a buffer of its own.
 template <size_t BitsPerComponent>
 class Image final {
   static_assert(BitsPerComponent == 8 || BitsPerComponent == 16);
@@ -71,12 +82,43 @@ private:
   uint32_t width_{};
   uint32_t height_{};
   uint32_t stride_{};
-  std::vector<uint8_t> data_{};
+  // Shared by the image that allocated it and all of its views.
+  std::shared_ptr<PixelBuffer> storage_{};
+  // Where the first pixel is in storage_.
+  size_t offset_{};
+  bool isView_{};
 public:
   Image() = default;
-  Image(Image const&) = default;
+  Image(Image const& other)
+  :colorProfile_(other.colorProfile_)
+  ,pixelOrder_(other.pixelOrder_)
+  ,width_(other.width_)
+  ,height_(other.height_)
+  ,stride_(other.stride_)
+  {
+    if(!other.storage_) {
+      return;
+    }
+    if(!other.isView()) {
+      this->storage_ = std::make_shared<PixelBuffer>(*other.storage_);
+      return;
+    }
+    // Only the rectangle of the view, tightly packed.
+    size_t const rowBytes = static_cast<size_t>(other.width_) * other.bytesPerPixel();
+    this->stride_ = static_cast<uint32_t>(rowBytes);
+    this->storage_ = std::make_shared<PixelBuffer>(PixelBuffer::allocate(rowBytes * other.height_, AllocationPolicy::packedUninitialized()));
+    for(size_t y = 0; y < other.height_; ++y) {
+      uint8_t const* const line = other.data() + static_cast<size_t>(other.stride_) * y;
+      std::copy(line, line + rowBytes, this->data() + rowBytes * y);
+    }
+  }
   Image(Image&&) noexcept = default;
-  Image& operator=(Image const&) = default;
+  Image& operator=(Image const& other) {
+    if(this != &other) {
+      *this = Image(other);
+    }
+    return *this;
+  }
   Image& operator=(Image&&) noexcept = default;
   ~Image() noexcept = default;
 public:
@@ -86,14 +128,23 @@ public:
   ,width_(width)
   ,height_(height)
   ,stride_(stride)
-  ,data_(std::move(data))
+  ,storage_(std::make_shared<PixelBuffer>(std::move(data)))
+  {
+  }
+  explicit Image(ColorProfile colorProfile, PixelOrder pixelOrder, uint32_t width, uint32_t height, uint32_t stride, PixelBuffer data)
+  :colorProfile_(std::move(colorProfile))
+  ,pixelOrder_(pixelOrder)
+  ,width_(width)
+  ,height_(height)
+  ,stride_(stride)
+  ,storage_(std::make_shared<PixelBuffer>(std::move(data)))
   {
   }
-  static Image createEmptyImage(PixelOrder const pixelOrder, uint32_t const width, uint32_t const height) {
-    std::vector<uint8_t> dstBuff;
+  // The stride is padded to a multiple of policy.rowAlignment.
+  static Image createEmptyImage(PixelOrder const pixelOrder, uint32_t const width, uint32_t const height, AllocationPolicy const& policy = {}) {
     size_t const bytesPerPixel = calcNumComponents(pixelOrder) * color::RGB<BitsPerComponent>::bytesPerComponent;
-    size_t const stride = bytesPerPixel * width;
-    dstBuff.resize(stride * height);
+    size_t const stride = (bytesPerPixel * width + policy.rowAlignment - 1) & ~(policy.rowAlignment - 1);
+    PixelBuffer dstBuff = PixelBuffer::allocate(stride * height, policy);
     return Image(avif::img::ColorProfile{}, pixelOrder, width, height, stride, std::move(dstBuff));
   }
   [[ nodiscard ]] ColorProfile const& colorProfile() const {
@@ -127,10 +178,31 @@ public:
     return calcNumComponents(this->pixelOrder_);
   }
   [[ nodiscard ]] uint8_t const* data() const {
-    return this->data_.data();
+    return this->storage_ ? this->storage_->data() + this->offset_ : nullptr;
   }
   [[ nodiscard ]] uint8_t* data() {
-    return this->data_.data();
+    return this->storage_ ? this->storage_->data() + this->offset_ : nullptr;
+  }
+  // Whether this is a view of a rectangle of another image, with the stride of that image.
+  [[ nodiscard ]] bool isView() const {
+    return this->isView_;
+  }
+  // The width x height pixels at (x, y), sharing the pixels of this image without copying them.
+  // Views of views refer to the same pixels, which stay alive as long as any of them does.
+  [[ nodiscard ]] Image view(uint32_t const x, uint32_t const y, uint32_t const width, uint32_t const height) {
+    if(static_cast<uint64_t>(x) + width > this->width_ || static_cast<uint64_t>(y) + height > this->height_) {
+      throw std::out_of_range(fmt::format("{}x{} at ({}, {}) is out of the {}x{} image.", width, height, x, y, this->width_, this->height_));
+    }
+    Image dst;
+    dst.colorProfile_ = this->colorProfile_;
+    dst.pixelOrder_ = this->pixelOrder_;
+    dst.width_ = width;
+    dst.height_ = height;
+    dst.stride_ = this->stride_;
+    dst.storage_ = this->storage_;
+    dst.offset_ = this->offset_ + static_cast<size_t>(this->stride_) * y + static_cast<size_t>(x) * this->bytesPerPixel();
+    dst.isView_ = true;
+    return dst;
   }
   [[ nodiscard ]] bool isMonochrome() {
     switch(pixelOrder_){
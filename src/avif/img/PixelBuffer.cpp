@@ -0,0 +1,180 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <new>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "PixelBuffer.hpp"
+
+namespace avif::img {
+
+namespace {
+
+uint8_t* allocateAligned(size_t const size, size_t const alignment) {
+  return static_cast<uint8_t*>(::operator new(size, std::align_val_t{alignment}));
+}
+
+void freeAligned(uint8_t* const ptr, size_t const alignment) noexcept {
+  ::operator delete(ptr, std::align_val_t{alignment});
+}
+
+struct PooledBuffer final {
+  uint8_t* ptr;
+  size_t size;
+  size_t alignment;
+};
+
+// Set when the pool of this thread is destroyed, so buffers released later are just freed.
+// Trivially destructible, so it stays readable until the thread is gone.
+thread_local bool poolDestroyed = false;
+
+class Pool final {
+private:
+  // The oldest first.
+  std::vector<PooledBuffer> buffers_{};
+public:
+  Pool() = default;
+  Pool(Pool const&) = delete;
+  Pool(Pool&&) = delete;
+  Pool& operator=(Pool const&) = delete;
+  Pool& operator=(Pool&&) = delete;
+  ~Pool() noexcept {
+    this->clear();
+    poolDestroyed = true;
+  }
+public:
+  uint8_t* take(size_t const size, size_t const alignment) {
+    auto const it = std::find_if(this->buffers_.rbegin(), this->buffers_.rend(), [&](PooledBuffer const& buffer) {
+      return buffer.size == size && buffer.alignment == alignment;
+    });
+    if(it == this->buffers_.rend()) {
+      return nullptr;
+    }
+    uint8_t* const ptr = it->ptr;
+    this->buffers_.erase(std::next(it).base());
+    return ptr;
+  }
+  void put(uint8_t* const ptr, size_t const size, size_t const alignment) noexcept {
+    try {
+      this->buffers_.reserve(BufferPool::capacity);
+    } catch (...) {
+      freeAligned(ptr, alignment);
+      return;
+    }
+    if(this->buffers_.size() >= BufferPool::capacity) {
+      freeAligned(this->buffers_.front().ptr, this->buffers_.front().alignment);
+      this->buffers_.erase(this->buffers_.begin());
+    }
+    this->buffers_.push_back(PooledBuffer{ptr, size, alignment});
+  }
+  void clear() noexcept {
+    for(auto const& buffer : this->buffers_) {
+      freeAligned(buffer.ptr, buffer.alignment);
+    }
+    this->buffers_.clear();
+  }
+  [[ nodiscard ]] size_t size() const noexcept {
+    return this->buffers_.size();
+  }
+};
+
+Pool& localPool() {
+  thread_local Pool pool;
+  return pool;
+}
+
+}
+
+void PixelBuffer::Release::operator()(uint8_t* const ptr) const noexcept {
+  if(this->pooled && !poolDestroyed) {
+    localPool().put(ptr, this->size, this->alignment);
+  } else {
+    freeAligned(ptr, this->alignment);
+  }
+}
+
+PixelBuffer::PixelBuffer(std::vector<uint8_t> data)
+:vector_(std::move(data))
+{
+  this->size_ = this->vector_.size();
+}
+
+PixelBuffer::PixelBuffer(PixelBuffer const& other)
+:vector_(other.vector_)
+,size_(other.size_)
+{
+  if(other.allocated_) {
+    AllocationPolicy policy;
+    policy.zeroFill = false;
+    policy.rowAlignment = other.allocated_.get_deleter().alignment;
+    *this = PixelBuffer::allocate(other.size_, policy);
+    std::copy_n(other.data(), other.size_, this->data());
+  }
+}
+
+PixelBuffer& PixelBuffer::operator=(PixelBuffer const& other) {
+  if(this != &other) {
+    *this = PixelBuffer(other);
+  }
+  return *this;
+}
+
+// A moved-from buffer is empty, like a moved-from vector.
+PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept
+:vector_(std::move(other.vector_))
+,allocated_(std::move(other.allocated_))
+,size_(other.size_)
+{
+  other.vector_.clear();
+  other.size_ = 0;
+}
+
+PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept {
+  if(this != &other) {
+    this->vector_ = std::move(other.vector_);
+    this->allocated_ = std::move(other.allocated_);
+    this->size_ = other.size_;
+    other.vector_.clear();
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+PixelBuffer PixelBuffer::allocate(size_t const size, AllocationPolicy const& policy) {
+  if(policy.rowAlignment == 0 || (policy.rowAlignment & (policy.rowAlignment - 1)) != 0) {
+    throw std::invalid_argument(fmt::format("Alignment must be a power of two: {}", policy.rowAlignment));
+  }
+  PixelBuffer buffer;
+  if(size == 0) {
+    return buffer;
+  }
+  size_t const alignment = std::max(policy.rowAlignment, alignof(std::max_align_t));
+  uint8_t* ptr = nullptr;
+  bool const pooled = policy.pooled && !poolDestroyed;
+  if(pooled) {
+    ptr = localPool().take(size, alignment);
+  }
+  if(ptr == nullptr) {
+    ptr = allocateAligned(size, alignment);
+  }
+  buffer.allocated_ = std::unique_ptr<uint8_t, Release>(ptr, Release{size, alignment, pooled});
+  buffer.size_ = size;
+  if(policy.zeroFill) {
+    std::fill_n(ptr, size, static_cast<uint8_t>(0));
+  }
+  return buffer;
+}
+
+void BufferPool::clear() noexcept {
+  if(!poolDestroyed) {
+    localPool().clear();
+  }
+}
+
+size_t BufferPool::size() noexcept {
+  return poolDestroyed ? 0 : localPool().size();
+}
+
+}
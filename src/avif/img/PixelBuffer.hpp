@@ -0,0 +1,91 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+namespace avif::img {
+
+// How Image::createEmptyImage and PlanarImage::create get their pixels.
+// The defaults keep the original behaviour: tightly packed rows of zeros in a fresh allocation.
+struct AllocationPolicy final {
+  // Fill new pixels with zeros. Without it they are indeterminate, which saves a memset
+  // (and the page faults it causes) for images whose every pixel is written anyway.
+  bool zeroFill = true;
+  // Rows start at multiples of this many bytes, so the stride may have padding. A power of two.
+  size_t rowAlignment = 1;
+  // Take the buffer from the pool of this thread, and give it back when the image is gone.
+  // Worth it when images of the same size come and go, e.g. one frame after another.
+  bool pooled = false;
+
+  // Uninitialized, 64-byte aligned rows, no pool.
+  static constexpr AllocationPolicy uninitialized() {
+    return AllocationPolicy{false, 64, false};
+  }
+  // Uninitialized and tightly packed, for images whose every byte is written right away.
+  static constexpr AllocationPolicy packedUninitialized() {
+    return AllocationPolicy{false, 1, false};
+  }
+};
+
+// Owned pixels of an image. The memory comes either from a std::vector given by the caller,
+// or from an aligned allocation made with an AllocationPolicy.
+// Copying allocates a new buffer of the same alignment, outside of any pool.
+class PixelBuffer final {
+public:
+  // Where the memory goes back to.
+  struct Release final {
+    size_t size;
+    size_t alignment;
+    bool pooled;
+    void operator()(uint8_t* ptr) const noexcept;
+  };
+private:
+  std::vector<uint8_t> vector_{};
+  std::unique_ptr<uint8_t, Release> allocated_{};
+  size_t size_{};
+public:
+  PixelBuffer() = default;
+  PixelBuffer(PixelBuffer const& other);
+  PixelBuffer(PixelBuffer&& other) noexcept;
+  PixelBuffer& operator=(PixelBuffer const& other);
+  PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+  ~PixelBuffer() noexcept = default;
+public:
+  // Takes the ownership of the vector, without copying.
+  explicit PixelBuffer(std::vector<uint8_t> data);
+  // The address is a multiple of max(policy.rowAlignment, alignof(std::max_align_t)).
+  static PixelBuffer allocate(size_t size, AllocationPolicy const& policy);
+
+  [[ nodiscard ]] uint8_t const* data() const noexcept {
+    return this->allocated_ ? this->allocated_.get() : this->vector_.data();
+  }
+  [[ nodiscard ]] uint8_t* data() noexcept {
+    return this->allocated_ ? this->allocated_.get() : this->vector_.data();
+  }
+  [[ nodiscard ]] size_t size() const noexcept {
+    return this->size_;
+  }
+  [[ nodiscard ]] bool empty() const noexcept {
+    return this->size_ == 0;
+  }
+};
+
+// Buffers released by pooled PixelBuffers, kept per thread for the next allocation of the same size.
+// A buffer goes back to the pool of the thread that releases it.
+class BufferPool final {
+public:
+  // Buffers kept per thread. Releasing more frees the oldest one.
+  static constexpr size_t capacity = 8;
+  // Frees the buffers kept by this thread.
+  static void clear() noexcept;
+  // Number of buffers kept by this thread.
+  static size_t size() noexcept;
+};
+
+}
@@ -0,0 +1,219 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <fmt/format.h>
+
+#include "./color/Math.hpp"
+#include "Image.hpp"
+#include "PixelBuffer.hpp"
+
+namespace avif::img {
+
+// The layout of the chroma planes, as in AV1 mono_chrome, subsampling_x and subsampling_y.
+enum class ChromaFormat : uint8_t {
+  I400 = 0, /* Y only */
+  I420, /* U and V have half the width and half the height of Y */
+  I422, /* U and V have half the width of Y */
+  I444, /* U and V have the size of Y */
+};
+
+constexpr bool isSubsampledX(ChromaFormat const format) noexcept {
+  return format == ChromaFormat::I420 || format == ChromaFormat::I422;
+}
+
+constexpr bool isSubsampledY(ChromaFormat const format) noexcept {
+  return format == ChromaFormat::I420;
+}
+
+enum class Plane : uint8_t {
+  Y = 0,
+  U = 1,
+  V = 2,
+  A = 3,
+};
+
+// YUV samples in separate planes, with an optional alpha plane of the size of Y.
+// Each sample takes color::YUV<BitsPerComponent>::bytesPerComponent bytes, as the conversions in Conversion.hpp expect.
+//
+// The planes are either owned (create()) or point into memory of the caller (wrap(), view()).
+// Either way, moving a PlanarImage keeps the plane pointers valid. Copying is not allowed, so use crop() for a deep copy.
+template <size_t BitsPerComponent>
+class PlanarImage final {
+  static_assert(BitsPerComponent == 8 || BitsPerComponent == 10 || BitsPerComponent == 12);
+public:
+  using Type = typename color::YUV<BitsPerComponent>::Type;
+  // Rows of created images start at multiples of this by default, so SIMD kernels can load them aligned.
+  static constexpr size_t defaultAlignment = 64;
+  static constexpr AllocationPolicy defaultPolicy() {
+    return AllocationPolicy{true, defaultAlignment, false};
+  }
+private:
+  ColorProfile colorProfile_{};
+  ChromaFormat chromaFormat_{};
+  bool fullRange_{};
+  uint32_t width_{};
+  uint32_t height_{};
+  std::array<uint8_t*, 4> planes_{};
+  std::array<size_t, 4> strides_{};
+  // Empty unless the planes are owned.
+  PixelBuffer storage_{};
+public:
+  PlanarImage() = default;
+  PlanarImage(PlanarImage const&) = delete;
+  PlanarImage(PlanarImage&&) noexcept = default;
+  PlanarImage& operator=(PlanarImage const&) = delete;
+  PlanarImage& operator=(PlanarImage&&) noexcept = default;
+  ~PlanarImage() noexcept = default;
+private:
+  PlanarImage(ChromaFormat const chromaFormat, bool const fullRange, uint32_t const width, uint32_t const height, std::array<uint8_t*, 4> const& planes, std::array<size_t, 4> const& strides, PixelBuffer storage)
+  :chromaFormat_(chromaFormat)
+  ,fullRange_(fullRange)
+  ,width_(width)
+  ,height_(height)
+  ,planes_(planes)
+  ,strides_(strides)
+  ,storage_(std::move(storage))
+  {
+  }
+public:
+  // Allocates the planes in one buffer. Every plane and every row starts at a multiple of policy.rowAlignment.
+  static PlanarImage create(ChromaFormat const chromaFormat, uint32_t const width, uint32_t const height, bool const fullRange, bool const hasAlpha, AllocationPolicy const& policy = defaultPolicy()) {
+    size_t const alignment = policy.rowAlignment;
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0) {
+      throw std::invalid_argument(fmt::format("Alignment must be a power of two: {}", alignment));
+    }
+    std::array<size_t, 4> strides{};
+    std::array<size_t, 4> offsets{};
+    size_t size = 0;
+    for(size_t i = 0; i < 4; ++i) {
+      auto const plane = static_cast<Plane>(i);
+      if(!hasPlane(chromaFormat, hasAlpha, plane)) {
+        continue;
+      }
+      size_t const rowBytes = calcPlaneWidth(chromaFormat, width, plane) * sizeof(Type);
+      strides[i] = (rowBytes + alignment - 1) & ~(alignment - 1);
+      offsets[i] = size;
+      size += strides[i] * calcPlaneHeight(chromaFormat, height, plane);
+    }
+    PixelBuffer storage = PixelBuffer::allocate(size, policy);
+    uint8_t* const base = storage.data();
+    std::array<uint8_t*, 4> planes{};
+    for(size_t i = 0; i < 4; ++i) {
+      planes[i] = strides[i] == 0 ? nullptr : base + offsets[i];
+    }
+    return PlanarImage(chromaFormat, fullRange, width, height, planes, strides, std::move(storage));
+  }
+
+  // Refers to planes owned by the caller, which must outlive the returned image.
+  // planes and strides are in the order of Plane. Unused planes (U and V of I400, A without alpha) are nullptr.
+  static PlanarImage wrap(ChromaFormat const chromaFormat, uint32_t const width, uint32_t const height, bool const fullRange, std::array<uint8_t*, 4> const& planes, std::array<size_t, 4> const& strides) {
+    for(size_t i = 0; i < 3; ++i) {
+      if(hasPlane(chromaFormat, false, static_cast<Plane>(i)) && planes[i] == nullptr) {
+        throw std::invalid_argument(fmt::format("Plane {} is missing.", i));
+      }
+    }
+    return PlanarImage(chromaFormat, fullRange, width, height, planes, strides, PixelBuffer());
+  }
+
+  // Refers to the rectangle of this image, which must outlive the returned image.
+  // x and y must be multiples of the chroma subsampling, so that chroma stays aligned with luma.
+  [[ nodiscard ]] PlanarImage view(uint32_t const x, uint32_t const y, uint32_t const width, uint32_t const height) {
+    if(static_cast<uint64_t>(x) + width > this->width_ || static_cast<uint64_t>(y) + height > this->height_) {
+      throw std::out_of_range(fmt::format("{}x{} at ({}, {}) is out of the {}x{} image.", width, height, x, y, this->width_, this->height_));
+    }
+    if((isSubsampledX(this->chromaFormat_) && x % 2 != 0) || (isSubsampledY(this->chromaFormat_) && y % 2 != 0)) {
+      throw std::domain_error(fmt::format("({}, {}) is not aligned to the chroma subsampling.", x, y));
+    }
+    std::array<uint8_t*, 4> planes{};
+    for(size_t i = 0; i < 4; ++i) {
+      auto const plane = static_cast<Plane>(i);
+      if(this->planes_[i] != nullptr) {
+        planes[i] = this->planes_[i]
+            + this->strides_[i] * calcPlaneHeight(this->chromaFormat_, y, plane)
+            + calcPlaneWidth(this->chromaFormat_, x, plane) * sizeof(Type);
+      }
+    }
+    PlanarImage dst(this->chromaFormat_, this->fullRange_, width, height, planes, this->strides_, PixelBuffer());
+    dst.colorProfile_ = this->colorProfile_;
+    return dst;
+  }
+
+  static constexpr bool hasPlane(ChromaFormat const chromaFormat, bool const hasAlpha, Plane const plane) noexcept {
+    switch(plane) {
+      case Plane::Y:
+        return true;
+      case Plane::U:
+      case Plane::V:
+        return chromaFormat != ChromaFormat::I400;
+      case Plane::A:
+        return hasAlpha;
+    }
+    return false;
+  }
+  static constexpr uint32_t calcPlaneWidth(ChromaFormat const chromaFormat, uint32_t const width, Plane const plane) noexcept {
+    bool const chroma = plane == Plane::U || plane == Plane::V;
+    return chroma && isSubsampledX(chromaFormat) ? (width + 1) / 2 : width;
+  }
+  static constexpr uint32_t calcPlaneHeight(ChromaFormat const chromaFormat, uint32_t const height, Plane const plane) noexcept {
+    bool const chroma = plane == Plane::U || plane == Plane::V;
+    return chroma && isSubsampledY(chromaFormat) ? (height + 1) / 2 : height;
+  }
+
+  [[ nodiscard ]] ColorProfile const& colorProfile() const {
+    return this->colorProfile_;
+  }
+  [[ nodiscard ]] ColorProfile& colorProfile() {
+    return this->colorProfile_;
+  }
+  [[ nodiscard ]] ChromaFormat chromaFormat() const {
+    return this->chromaFormat_;
+  }
+  // The range of the samples. The conversions check it against their isFullRange.
+  [[ nodiscard ]] bool fullRange() const {
+    return this->fullRange_;
+  }
+  [[ nodiscard ]] uint32_t width() const {
+    return this->width_;
+  }
+  [[ nodiscard ]] uint32_t height() const {
+    return this->height_;
+  }
+  [[ nodiscard ]] constexpr uint8_t bitsPerComponent() const {
+    return BitsPerComponent;
+  }
+  [[ nodiscard ]] bool isMonochrome() const {
+    return this->chromaFormat_ == ChromaFormat::I400;
+  }
+  [[ nodiscard ]] bool hasAlpha() const {
+    return this->planes_[static_cast<size_t>(Plane::A)] != nullptr;
+  }
+  [[ nodiscard ]] bool ownsData() const {
+    return !this->storage_.empty();
+  }
+  [[ nodiscard ]] uint32_t planeWidth(Plane const plane) const {
+    return calcPlaneWidth(this->chromaFormat_, this->width_, plane);
+  }
+  [[ nodiscard ]] uint32_t planeHeight(Plane const plane) const {
+    return calcPlaneHeight(this->chromaFormat_, this->height_, plane);
+  }
+  // nullptr if the image does not have the plane.
+  [[ nodiscard ]] uint8_t const* data(Plane const plane) const {
+    return this->planes_[static_cast<size_t>(plane)];
+  }
+  [[ nodiscard ]] uint8_t* data(Plane const plane) {
+    return this->planes_[static_cast<size_t>(plane)];
+  }
+  [[ nodiscard ]] size_t stride(Plane const plane) const {
+    return this->strides_[static_cast<size_t>(plane)];
+  }
+};
+
+}
@@ -4,17 +4,24 @@
 
 #pragma once
 
+#include <vector>
 #include <cassert>
+#include <optional>
+#include <stdexcept>
+#include <fmt/format.h>
 #include "Image.hpp"
+#include "PlanarImage.hpp"
+#include "Crop.hpp"
 #include "../ImageMirrorBox.hpp"
 #include "../ImageRotationBox.hpp"
+#include "../ItemPropertyContainer.hpp"
 #include "TransformImpl.hpp"
 
 namespace avif::img {
 
 template <size_t BitsPerComponent>
 Image <BitsPerComponent> flip(Image <BitsPerComponent> const & src, ImageMirrorBox::Axis const axis) {
-  Image<BitsPerComponent> dst = Image <BitsPerComponent> ::createEmptyImage(src.pixelOrder(), src.width(), src.height());
+  Image<BitsPerComponent> dst = Image <BitsPerComponent> ::createEmptyImage(src.pixelOrder(), src.width(), src.height(), AllocationPolicy::packedUninitialized());
   switch (axis) {
     case ImageMirrorBox::Axis::Horizontal:
       transform::fill<BitsPerComponent, transform::FlipTrans<ImageMirrorBox::Axis::Horizontal>>(src, dst);
@@ -34,22 +41,22 @@ Image <BitsPerComponent> rotate(Image<BitsPerComponent> const & src, ImageRotati
   Image<BitsPerComponent> dst;
   switch (rotation) {
     case ImageRotationBox::Rotation::Rot0: {
-      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.width(), src.height());
+      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.width(), src.height(), AllocationPolicy::packedUninitialized());
       transform::fill<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot0>>(src, dst);
       break;
     }
     case ImageRotationBox::Rotation::Rot90: {
-      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.height(), src.width());
+      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.height(), src.width(), AllocationPolicy::packedUninitialized());
       transform::fill<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot90>>(src, dst);
       break;
     }
     case ImageRotationBox::Rotation::Rot180: {
-      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.width(), src.height());
+      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.width(), src.height(), AllocationPolicy::packedUninitialized());
       transform::fill<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot180>>(src, dst);
       break;
     }
     case ImageRotationBox::Rotation::Rot270: {
-      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.height(), src.width());
+      dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), src.height(), src.width(), AllocationPolicy::packedUninitialized());
       transform::fill<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot270>>(src, dst);
       break;
     }
@@ -60,4 +67,109 @@ Image <BitsPerComponent> rotate(Image<BitsPerComponent> const & src, ImageRotati
   return dst;
 }
 
+// Each plane is flipped on its own, so the chroma of odd-sized subsampled images moves by half a sample.
+template <size_t BitsPerComponent>
+PlanarImage<BitsPerComponent> flip(PlanarImage<BitsPerComponent> const& src, ImageMirrorBox::Axis const axis) {
+  PlanarImage<BitsPerComponent> dst = PlanarImage<BitsPerComponent>::create(src.chromaFormat(), src.width(), src.height(), src.fullRange(), src.hasAlpha(), AllocationPolicy::uninitialized());
+  dst.colorProfile() = src.colorProfile();
+  switch (axis) {
+    case ImageMirrorBox::Axis::Horizontal:
+      transform::fillPlanes<BitsPerComponent, transform::FlipTrans<ImageMirrorBox::Axis::Horizontal>>(src, dst);
+      break;
+    case ImageMirrorBox::Axis::Vertical:
+      transform::fillPlanes<BitsPerComponent, transform::FlipTrans<ImageMirrorBox::Axis::Vertical>>(src, dst);
+      break;
+    default:
+      assert("Do not come here" && (axis == ImageMirrorBox::Axis::Horizontal || axis == ImageMirrorBox::Axis::Vertical));
+      break;
+  }
+  return dst;
+}
+
+// 4:2:2 turned by 90 or 270 degrees would be 4:4:0, which AV1 does not have. Throws std::domain_error for them.
+template <size_t BitsPerComponent>
+PlanarImage<BitsPerComponent> rotate(PlanarImage<BitsPerComponent> const& src, ImageRotationBox::Rotation const rotation) {
+  using Planar = PlanarImage<BitsPerComponent>;
+  bool const turn = rotation == ImageRotationBox::Rotation::Rot90 || rotation == ImageRotationBox::Rotation::Rot270;
+  if (turn && src.chromaFormat() == ChromaFormat::I422) {
+    throw std::domain_error("Cannot rotate 4:2:2 image by 90 or 270 degrees.");
+  }
+  Planar dst = turn ?
+      Planar::create(src.chromaFormat(), src.height(), src.width(), src.fullRange(), src.hasAlpha(), AllocationPolicy::uninitialized()) :
+      Planar::create(src.chromaFormat(), src.width(), src.height(), src.fullRange(), src.hasAlpha(), AllocationPolicy::uninitialized());
+  dst.colorProfile() = src.colorProfile();
+  switch (rotation) {
+    case ImageRotationBox::Rotation::Rot0:
+      transform::fillPlanes<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot0>>(src, dst);
+      break;
+    case ImageRotationBox::Rotation::Rot90:
+      transform::fillPlanes<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot90>>(src, dst);
+      break;
+    case ImageRotationBox::Rotation::Rot180:
+      transform::fillPlanes<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot180>>(src, dst);
+      break;
+    case ImageRotationBox::Rotation::Rot270:
+      transform::fillPlanes<BitsPerComponent, transform::RotateTrans<ImageRotationBox::Rotation::Rot270>>(src, dst);
+      break;
+    default:
+      assert("Do not come here" && (rotation == ImageRotationBox::Rotation::Rot0 || rotation == ImageRotationBox::Rotation::Rot90 || rotation == ImageRotationBox::Rotation::Rot180 || rotation == ImageRotationBox::Rotation::Rot270));
+      break;
+  }
+  return dst;
+}
+
+namespace detail {
+
+inline void addCrop(transform::Mapping& mapping, CleanApertureBox const& clap) {
+  auto const [offX, offY, width, height] = calcCropRect(mapping.width, mapping.height, clap);
+  if (offX + width > mapping.width || offY + height > mapping.height) {
+    throw std::out_of_range(fmt::format("The clean aperture {}x{} at ({}, {}) is out of the {}x{} image.", width, height, offX, offY, mapping.width, mapping.height));
+  }
+  mapping.crop(offX, offY, width, height);
+}
+
+template <size_t BitsPerComponent>
+Image<BitsPerComponent> applyMapping(Image<BitsPerComponent> const& src, transform::Mapping const& mapping) {
+  Image<BitsPerComponent> dst = Image<BitsPerComponent>::createEmptyImage(src.pixelOrder(), mapping.width, mapping.height, AllocationPolicy::packedUninitialized());
+  dst.colorProfile() = src.colorProfile();
+  transform::copyMapped(mapping, src.bytesPerPixel(), src.data(), src.stride(), dst.data(), dst.stride());
+  return dst;
+}
+
+}
+
+// Crops, rotates and mirrors src as the clap, irot and imir among properties say, in the order they appear.
+// Give the properties in the order they are associated to the item. Other properties are ignored.
+// Unlike calling crop(), rotate() and flip() one by one, the pixels are copied once, into the only image allocated.
+template <size_t BitsPerComponent>
+Image<BitsPerComponent> applyTransforms(Image<BitsPerComponent> const& src, std::vector<ItemPropertyContainer::Property> const& properties) {
+  transform::Mapping mapping = transform::Mapping::identity(src.width(), src.height());
+  for (auto const& prop : properties) {
+    if (auto const* clap = std::get_if<CleanApertureBox>(&prop)) {
+      detail::addCrop(mapping, *clap);
+    } else if (auto const* irot = std::get_if<ImageRotationBox>(&prop)) {
+      mapping.rotate(irot->angle);
+    } else if (auto const* imir = std::get_if<ImageMirrorBox>(&prop)) {
+      mapping.flip(imir->axis);
+    }
+  }
+  return detail::applyMapping(src, mapping);
+}
+
+// The same, in the order MIAF requires: clap, then irot, then imir.
+template <size_t BitsPerComponent>
+Image<BitsPerComponent> applyTransforms(Image<BitsPerComponent> const& src, std::optional<CleanApertureBox> const& clap, std::optional<ImageRotationBox> const& irot, std::optional<ImageMirrorBox> const& imir) {
+  transform::Mapping mapping = transform::Mapping::identity(src.width(), src.height());
+  if (clap.has_value()) {
+    detail::addCrop(mapping, clap.value());
+  }
+  if (irot.has_value()) {
+    mapping.rotate(irot->angle);
+  }
+  if (imir.has_value()) {
+    mapping.flip(imir->axis);
+  }
+  return detail::applyMapping(src, mapping);
+}
+
 }
@@ -5,7 +5,12 @@
 #pragma once
 
 #include <tuple>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
 #include "Image.hpp"
+#include "PlanarImage.hpp"
+#include "./simd/Kernels.hpp"
 #include "../ImageMirrorBox.hpp"
 #include "../ImageRotationBox.hpp"
 
@@ -15,6 +20,9 @@ template <ImageMirrorBox::Axis>
  struct FlipTrans;
 template <>
 struct FlipTrans<ImageMirrorBox::Axis::Vertical> {
+  static constexpr bool swapsAxes = false;
+  static constexpr bool reverseX = false;
+  static constexpr bool reverseY = true;
   std::tuple <size_t, size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
     return std::make_tuple(x, srcHeight - y - 1);
   }
@@ -22,6 +30,9 @@ struct FlipTrans<ImageMirrorBox::Axis::Vertical> {
 
 template <>
 struct FlipTrans<ImageMirrorBox::Axis::Horizontal> {
+  static constexpr bool swapsAxes = false;
+  static constexpr bool reverseX = true;
+  static constexpr bool reverseY = false;
   std::tuple <size_t,size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
     return std::make_tuple(srcWidth - x - 1, y);
   }
@@ -31,6 +42,9 @@ template <ImageRotationBox::Rotation>
 struct RotateTrans;
 template <>
 struct RotateTrans<ImageRotationBox::Rotation::Rot0> {
+  static constexpr bool swapsAxes = false;
+  static constexpr bool reverseX = false;
+  static constexpr bool reverseY = false;
   std::tuple <size_t, size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
     return std::make_tuple(x, y);
   }
@@ -38,6 +52,9 @@ struct RotateTrans<ImageRotationBox::Rotation::Rot0> {
 
 template <>
 struct RotateTrans<ImageRotationBox::Rotation::Rot90> {
+  static constexpr bool swapsAxes = true;
+  static constexpr bool reverseX = true;
+  static constexpr bool reverseY = false;
   std::tuple <size_t, size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
     return std::make_tuple(srcWidth - y - 1, x);
   }
@@ -45,6 +62,9 @@ struct RotateTrans<ImageRotationBox::Rotation::Rot90> {
 
 template <>
 struct RotateTrans<ImageRotationBox::Rotation::Rot180> {
+  static constexpr bool swapsAxes = false;
+  static constexpr bool reverseX = true;
+  static constexpr bool reverseY = true;
   std::tuple <size_t, size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
     return std::make_tuple(srcWidth - x - 1, srcHeight - y - 1);
   }
@@ -52,45 +72,249 @@ struct RotateTrans<ImageRotationBox::Rotation::Rot180> {
 
 template <>
 struct RotateTrans<ImageRotationBox::Rotation::Rot270> {
+  static constexpr bool swapsAxes = true;
+  static constexpr bool reverseX = false;
+  static constexpr bool reverseY = true;
   std::tuple <size_t, size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
     return std::make_tuple(y, srcHeight - x - 1);
   }
 };
 
-template < size_t BitsPerComponent, typename Trans >
-void fill(Image<BitsPerComponent> const& src, Image<BitsPerComponent>& dst) {
-  Trans trans;
-
-  using PixelType = typename color::RGB <BitsPerComponent>::Type;
-
-  // src
-  uint8_t const* srcBase = src.data();
-  size_t const srcStride = src.stride();
-  size_t const srcBytesPerPixel = dst.bytesPerPixel();
-  size_t const srcWidth = src.width();
-  size_t const srcHeight = src.height();
-
-  // dst
-  uint8_t* dstLine = dst.data();
-  size_t const dstStride = dst.stride();
-  size_t const dstBytesPerPixel = dst.bytesPerPixel();
-  size_t const dstWidth = dst.width();
-  size_t const dstHeight = dst.height();
-
-  // common
-  size_t const components = src.numComponents();
-  for (size_t y = 0; y < dstHeight; ++y) {
-    auto * dstPtr = reinterpret_cast<PixelType*>(dstLine);
-    for (size_t x = 0; x < dstWidth; ++x) {
-      auto * dstPixel = reinterpret_cast<PixelType*>(dstPtr);
-      auto from = trans(srcWidth, x, srcHeight, y);
-      auto const * srcPixel = reinterpret_cast<PixelType const*>(srcBase + (srcStride * std::get<1>(from)) + (srcBytesPerPixel * std::get<0>(from)));
-      for (size_t c = 0; c < components; ++c) {
-        dstPixel[c] = srcPixel[c];
+// Any of the 8 turns and mirrors of a rectangle, including the two transposes that no single irot or imir gives.
+template <bool SwapsAxes, bool ReverseX, bool ReverseY>
+struct DihedralTrans {
+  static constexpr bool swapsAxes = SwapsAxes;
+  static constexpr bool reverseX = ReverseX;
+  static constexpr bool reverseY = ReverseY;
+  std::tuple <size_t, size_t> operator()(size_t srcWidth, size_t x, size_t srcHeight, size_t y) {
+    if constexpr (SwapsAxes) {
+      return std::make_tuple(ReverseX ? srcWidth - y - 1 : y, ReverseY ? srcHeight - x - 1 : x);
+    } else {
+      return std::make_tuple(ReverseX ? srcWidth - x - 1 : x, ReverseY ? srcHeight - y - 1 : y);
+    }
+  }
+};
+
+// Where the pixels of an image cropped, rotated and mirrored in any order come from.
+// The pixel (x, y) of the result is the pixel origin + x * dx + y * dy of the source, where dx and dy are
+// unit vectors along the axes of the source, so the result is always a turned or mirrored rectangle of the source.
+struct Mapping final {
+  ptrdiff_t originX;
+  ptrdiff_t originY;
+  ptrdiff_t dxX;
+  ptrdiff_t dxY;
+  ptrdiff_t dyX;
+  ptrdiff_t dyY;
+  size_t width;
+  size_t height;
+
+  static Mapping identity(size_t const width, size_t const height) {
+    return Mapping{0, 0, 1, 0, 0, 1, width, height};
+  }
+  void moveOrigin(ptrdiff_t const x, ptrdiff_t const y) {
+    this->originX += x * this->dxX + y * this->dyX;
+    this->originY += x * this->dxY + y * this->dyY;
+  }
+  // The rectangle is in the coordinates of the result so far.
+  void crop(size_t const x, size_t const y, size_t const width, size_t const height) {
+    this->moveOrigin(static_cast<ptrdiff_t>(x), static_cast<ptrdiff_t>(y));
+    this->width = width;
+    this->height = height;
+  }
+  // As RotateTrans.
+  void rotate(ImageRotationBox::Rotation const rotation) {
+    auto const lastX = static_cast<ptrdiff_t>(this->width) - 1;
+    auto const lastY = static_cast<ptrdiff_t>(this->height) - 1;
+    switch (rotation) {
+      case ImageRotationBox::Rotation::Rot0:
+        break;
+      case ImageRotationBox::Rotation::Rot90:
+        this->moveOrigin(lastX, 0);
+        *this = Mapping{this->originX, this->originY, this->dyX, this->dyY, -this->dxX, -this->dxY, this->height, this->width};
+        break;
+      case ImageRotationBox::Rotation::Rot180:
+        this->moveOrigin(lastX, lastY);
+        *this = Mapping{this->originX, this->originY, -this->dxX, -this->dxY, -this->dyX, -this->dyY, this->width, this->height};
+        break;
+      case ImageRotationBox::Rotation::Rot270:
+        this->moveOrigin(0, lastY);
+        *this = Mapping{this->originX, this->originY, -this->dyX, -this->dyY, this->dxX, this->dxY, this->height, this->width};
+        break;
+      default:
+        assert("Do not come here" && (rotation == ImageRotationBox::Rotation::Rot0 || rotation == ImageRotationBox::Rotation::Rot90 || rotation == ImageRotationBox::Rotation::Rot180 || rotation == ImageRotationBox::Rotation::Rot270));
+        break;
+    }
+  }
+  // As FlipTrans.
+  void flip(ImageMirrorBox::Axis const axis) {
+    switch (axis) {
+      case ImageMirrorBox::Axis::Horizontal:
+        this->moveOrigin(static_cast<ptrdiff_t>(this->width) - 1, 0);
+        this->dxX = -this->dxX;
+        this->dxY = -this->dxY;
+        break;
+      case ImageMirrorBox::Axis::Vertical:
+        this->moveOrigin(0, static_cast<ptrdiff_t>(this->height) - 1);
+        this->dyX = -this->dyX;
+        this->dyY = -this->dyY;
+        break;
+      default:
+        assert("Do not come here" && (axis == ImageMirrorBox::Axis::Horizontal || axis == ImageMirrorBox::Axis::Vertical));
+        break;
+    }
+  }
+};
+
+// A pixel of N bytes, copied as a whole.
+template <size_t N>
+struct Pixel final {
+  uint8_t bytes[N];
+};
+
+// Transposes are done in tiles of this many pixels square, so the rows of both images that one tile touches stay in cache.
+constexpr size_t tileSize = 64;
+
+inline uint8_t const* rowAt(uint8_t const* const base, ptrdiff_t const stride, size_t const y) {
+  return base + static_cast<ptrdiff_t>(y) * stride;
+}
+inline uint8_t* rowAt(uint8_t* const base, ptrdiff_t const stride, size_t const y) {
+  return base + static_cast<ptrdiff_t>(y) * stride;
+}
+
+// Row x of dst gets column x of src, for the columns [x0, x1) and the rows [y0, y1) of src.
+template <typename PixelType>
+void transposeScalar(uint8_t const* src, ptrdiff_t const srcStride, uint8_t* dst, ptrdiff_t const dstStride, size_t const x0, size_t const x1, size_t const y0, size_t const y1) {
+  for (size_t x = x0; x < x1; ++x) {
+    auto* const dstRow = reinterpret_cast<PixelType*>(rowAt(dst, dstStride, x));
+    for (size_t y = y0; y < y1; ++y) {
+      dstRow[y] = reinterpret_cast<PixelType const*>(rowAt(src, srcStride, y))[x];
+    }
+  }
+}
+
+// dst gets the transpose of the width x height pixels of src. The strides may be negative.
+template <typename PixelType>
+void transpose(uint8_t const* src, ptrdiff_t const srcStride, size_t const width, size_t const height, uint8_t* dst, ptrdiff_t const dstStride) {
+  simd::TransposeBlock const block = simd::transposeBlock8x8(sizeof(PixelType));
+  for (size_t ty = 0; ty < height; ty += tileSize) {
+    size_t const tileEndY = std::min(ty + tileSize, height);
+    for (size_t tx = 0; tx < width; tx += tileSize) {
+      size_t const tileEndX = std::min(tx + tileSize, width);
+      if (block == nullptr) {
+        transposeScalar<PixelType>(src, srcStride, dst, dstStride, tx, tileEndX, ty, tileEndY);
+        continue;
+      }
+      // Down each column of blocks, so that the rows of dst are written whole cache lines at a time.
+      size_t const blockEndY = ty + (tileEndY - ty) / 8 * 8;
+      size_t x = tx;
+      for (; x + 8 <= tileEndX; x += 8) {
+        for (size_t y = ty; y < blockEndY; y += 8) {
+          block(rowAt(src, srcStride, y) + x * sizeof(PixelType), srcStride, rowAt(dst, dstStride, x) + y * sizeof(PixelType), dstStride);
+        }
+      }
+      transposeScalar<PixelType>(src, srcStride, dst, dstStride, x, tileEndX, ty, blockEndY);
+      transposeScalar<PixelType>(src, srcStride, dst, dstStride, tx, tileEndX, blockEndY, tileEndY);
+    }
+  }
+}
+
+// Copies the pixels of src into dst, moved as Trans says.
+template <typename PixelType, typename Trans>
+void copyPixels(uint8_t const* src, size_t const srcStride, size_t const srcWidth, size_t const srcHeight, uint8_t* dst, size_t const dstStride) {
+  if (srcWidth == 0 || srcHeight == 0) {
+    return;
+  }
+  auto const srcStep = static_cast<ptrdiff_t>(srcStride);
+  auto const dstStep = static_cast<ptrdiff_t>(dstStride);
+  if constexpr (Trans::swapsAxes) {
+    // Reading src bottom-up, or writing dst bottom-up, turns the transpose into a rotation.
+    uint8_t const* const srcBegin = Trans::reverseY ? rowAt(src, srcStep, srcHeight - 1) : src;
+    uint8_t* const dstBegin = Trans::reverseX ? rowAt(dst, dstStep, srcWidth - 1) : dst;
+    transpose<PixelType>(srcBegin, Trans::reverseY ? -srcStep : srcStep, srcWidth, srcHeight, dstBegin, Trans::reverseX ? -dstStep : dstStep);
+  } else {
+    for (size_t y = 0; y < srcHeight; ++y) {
+      auto const* const srcRow = reinterpret_cast<PixelType const*>(rowAt(src, srcStep, Trans::reverseY ? srcHeight - y - 1 : y));
+      auto* const dstRow = reinterpret_cast<PixelType*>(rowAt(dst, dstStep, y));
+      if constexpr (Trans::reverseX) {
+        std::reverse_copy(srcRow, srcRow + srcWidth, dstRow);
+      } else {
+        std::copy(srcRow, srcRow + srcWidth, dstRow);
       }
-      dstPtr += dstBytesPerPixel;
     }
-    dstLine += dstStride;
+  }
+}
+
+template <typename Trans>
+void copyPixels(size_t const bytesPerPixel, uint8_t const* src, size_t const srcStride, size_t const srcWidth, size_t const srcHeight, uint8_t* dst, size_t const dstStride) {
+  switch (bytesPerPixel) {
+    case 1:
+      copyPixels<Pixel<1>, Trans>(src, srcStride, srcWidth, srcHeight, dst, dstStride);
+      break;
+    case 2:
+      copyPixels<Pixel<2>, Trans>(src, srcStride, srcWidth, srcHeight, dst, dstStride);
+      break;
+    case 3:
+      copyPixels<Pixel<3>, Trans>(src, srcStride, srcWidth, srcHeight, dst, dstStride);
+      break;
+    case 4:
+      copyPixels<Pixel<4>, Trans>(src, srcStride, srcWidth, srcHeight, dst, dstStride);
+      break;
+    case 6:
+      copyPixels<Pixel<6>, Trans>(src, srcStride, srcWidth, srcHeight, dst, dstStride);
+      break;
+    case 8:
+      copyPixels<Pixel<8>, Trans>(src, srcStride, srcWidth, srcHeight, dst, dstStride);
+      break;
+    default:
+      assert(false && "[BUG] Unknown pixel size!");
+      break;
+  }
+}
+
+// Copies the pixels of src that mapping picks into dst, which has the size of the mapping.
+inline void copyMapped(Mapping const& mapping, size_t const bytesPerPixel, uint8_t const* src, size_t const srcStride, uint8_t* dst, size_t const dstStride) {
+  if (mapping.width == 0 || mapping.height == 0) {
+    return;
+  }
+  // The corner of the rectangle of src nearest to its origin.
+  auto const lastX = static_cast<ptrdiff_t>(mapping.width) - 1;
+  auto const lastY = static_cast<ptrdiff_t>(mapping.height) - 1;
+  ptrdiff_t const left = mapping.originX + std::min<ptrdiff_t>(0, lastX * mapping.dxX) + std::min<ptrdiff_t>(0, lastY * mapping.dyX);
+  ptrdiff_t const top = mapping.originY + std::min<ptrdiff_t>(0, lastX * mapping.dxY) + std::min<ptrdiff_t>(0, lastY * mapping.dyY);
+  uint8_t const* const base = src + static_cast<ptrdiff_t>(srcStride) * top + left * static_cast<ptrdiff_t>(bytesPerPixel);
+
+  bool const swapsAxes = mapping.dxX == 0;
+  size_t const srcWidth = swapsAxes ? mapping.height : mapping.width;
+  size_t const srcHeight = swapsAxes ? mapping.width : mapping.height;
+  bool const reverseX = swapsAxes ? mapping.dyX < 0 : mapping.dxX < 0;
+  bool const reverseY = swapsAxes ? mapping.dxY < 0 : mapping.dyY < 0;
+  switch ((swapsAxes ? 4 : 0) | (reverseX ? 2 : 0) | (reverseY ? 1 : 0)) {
+    case 0: copyPixels<DihedralTrans<false, false, false>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 1: copyPixels<DihedralTrans<false, false, true>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 2: copyPixels<DihedralTrans<false, true, false>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 3: copyPixels<DihedralTrans<false, true, true>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 4: copyPixels<DihedralTrans<true, false, false>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 5: copyPixels<DihedralTrans<true, false, true>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 6: copyPixels<DihedralTrans<true, true, false>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    case 7: copyPixels<DihedralTrans<true, true, true>>(bytesPerPixel, base, srcStride, srcWidth, srcHeight, dst, dstStride); break;
+    default:
+      assert(false && "[BUG] Unknown orientation!");
+      break;
+  }
+}
+
+template <size_t BitsPerComponent, typename Trans>
+void fill(Image<BitsPerComponent> const& src, Image<BitsPerComponent>& dst) {
+  copyPixels<Trans>(src.bytesPerPixel(), src.data(), src.stride(), src.width(), src.height(), dst.data(), dst.stride());
+}
+
+template <size_t BitsPerComponent, typename Trans>
+void fillPlanes(PlanarImage<BitsPerComponent> const& src, PlanarImage<BitsPerComponent>& dst) {
+  for (Plane const plane : {Plane::Y, Plane::U, Plane::V, Plane::A}) {
+    if (src.data(plane) == nullptr) {
+      continue;
+    }
+    copyPixels<Trans>(sizeof(typename PlanarImage<BitsPerComponent>::Type), src.data(plane), src.stride(plane), src.planeWidth(plane), src.planeHeight(plane), dst.data(plane), dst.stride(plane));
   }
 }
 
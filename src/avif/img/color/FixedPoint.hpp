@@ -0,0 +1,186 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include "./Math.hpp"
+#include "./Matrix.hpp"
+
+//
+// Integer fixed-point versions of Quantizer + ColorConverter::calcYUV/calcRGB.
+//
+// The matrix, the (de)quantization scale and the offsets are folded into one set of coefficients per
+// conversion at compile time, so each sample costs three integer multiply-adds, a shift and a clamp.
+// Results do not depend on the platform or the compiler's floating point settings.
+//
+// Accuracy: each output sample is within ±1 of the float reference (detail::calcYUV/calcRGB),
+// and equal to it for the vast majority of samples. The coefficients keep at least 16 fractional bits
+// (32 for 16-bit RGB), so their rounding error stays far below 1/2 LSB and differences only come from
+// values that fall almost exactly on a rounding boundary. test/ColorTest.cpp checks it for every
+// MatrixCoefficients that has a converter.
+//
+
+namespace avif::img::color {
+
+// The linear maps of a converter: rows y, u, v from columns r, g, b, and rows r, g, b from columns y, u, v.
+template <typename Converter>
+struct LinearMatrix final {
+  static constexpr bool isPrimaries = std::is_base_of<PrimariesConverter<Converter>, Converter>::value;
+  static constexpr bool isIdentity = std::is_base_of<IdentityConverter, Converter>::value;
+  static constexpr bool isSupported = isPrimaries || isIdentity;
+
+  // Same as calcYUV.
+  static constexpr std::array<double, 9> forward() {
+    if constexpr (isPrimaries) {
+      using C = PrimariesConverter<Converter>;
+      double const kr = C::Kr;
+      double const kg = C::Kg;
+      double const kb = C::Kb;
+      return {
+          kr, kg, kb,
+          -0.5 * kr / (1.0 - kb), -0.5 * kg / (1.0 - kb), 0.5,
+          0.5, -0.5 * kg / (1.0 - kr), -0.5 * kb / (1.0 - kr),
+      };
+    } else {
+      return {
+          0.0, 1.0, 0.0,
+          0.0, 0.0, 1.0,
+          1.0, 0.0, 0.0,
+      };
+    }
+  }
+
+  // Same as calcRGB.
+  static constexpr std::array<double, 9> inverse() {
+    if constexpr (isPrimaries) {
+      using C = PrimariesConverter<Converter>;
+      return {
+          1.0, 0.0, C::Cr_R,
+          1.0, C::Cb_G, C::Cr_G,
+          1.0, C::Cb_B, 0.0,
+      };
+    } else {
+      return {
+          0.0, 0.0, 1.0,
+          1.0, 0.0, 0.0,
+          0.0, 1.0, 0.0,
+      };
+    }
+  }
+};
+
+template <typename Converter, size_t rgbBits, size_t yuvBits, bool isFullRange>
+struct FixedPointQuantizer final {
+  static_assert(LinearMatrix<Converter>::isSupported);
+  using RGBSpec = typename color::RGB<rgbBits>;
+  using YUVSpec = typename color::YUV<yuvBits>;
+  using RGBType = typename RGBSpec::Type;
+  using YUVType = typename YUVSpec::Type;
+
+  // 8-bit RGB fits in int32_t with 16 (RGB -> YUV) or 20 (YUV -> RGB) fractional bits.
+  // 16-bit RGB needs more headroom than int32_t has.
+  using Int = typename std::conditional<rgbBits == 8, int32_t, int64_t>::type;
+  static constexpr int forwardBits = rgbBits == 8 ? 16 : 32;
+  static constexpr int inverseBits = rgbBits == 8 ? 20 : 32;
+
+  static constexpr int maxYUV = (1 << yuvBits) - 1;
+  static constexpr int shift = 1 << (yuvBits - 8u);
+  static constexpr int bias = YUVSpec::bias;
+  static constexpr int maxRGB = static_cast<int>(RGBSpec::max);
+
+  static constexpr Int toFixed(double const v, int const bits) {
+    double const scaled = v * static_cast<double>(static_cast<uint64_t>(1u) << static_cast<uint64_t>(bits));
+    return static_cast<Int>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+  }
+
+  // [y, u, v] x [r, g, b], then the offsets of y, u and v including 1/2 for rounding.
+  static constexpr std::array<Int, 12> makeForward() {
+    std::array<double, 9> const m = LinearMatrix<Converter>::forward();
+    double const lumaScale = isFullRange ? maxYUV / RGBSpec::max : 219.0 * shift / RGBSpec::max;
+    double const chromaScale = isFullRange ? maxYUV / RGBSpec::max : 224.0 * shift / RGBSpec::max;
+    double const lumaOffset = isFullRange ? 0.0 : 16.0 * shift;
+    double const chromaOffset = isFullRange ? bias : 128.0 * shift;
+    std::array<Int, 12> c{};
+    for(size_t i = 0; i < 9; ++i) {
+      c[i] = toFixed(m[i] * (i < 3 ? lumaScale : chromaScale), forwardBits);
+    }
+    c[9] = toFixed(lumaOffset + 0.5, forwardBits);
+    c[10] = toFixed(chromaOffset + 0.5, forwardBits);
+    c[11] = c[10];
+    return c;
+  }
+
+  // [r, g, b] x [y, u, v] for the integer inputs of dequantizeLuma/dequantizeChroma below.
+  static constexpr std::array<Int, 9> makeInverse() {
+    std::array<double, 9> const m = LinearMatrix<Converter>::inverse();
+    double const lumaScale = isFullRange ? 1.0 / maxYUV : 1.0 / (219.0 * shift);
+    double const chromaScale = isFullRange ? 1.0 / (2.0 * maxYUV) : 1.0 / (224.0 * shift);
+    std::array<Int, 9> c{};
+    for(size_t i = 0; i < 9; ++i) {
+      c[i] = toFixed(m[i] * RGBSpec::max * (i % 3 == 0 ? lumaScale : chromaScale), inverseBits);
+    }
+    return c;
+  }
+
+  static constexpr std::array<Int, 12> forward = makeForward();
+  static constexpr std::array<Int, 9> inverse = makeInverse();
+  static constexpr Int half = static_cast<Int>(1) << static_cast<Int>(inverseBits - 1);
+
+  static constexpr YUVType quantize(Int const v) {
+    return static_cast<YUVType>(clamp<Int>(v >> forwardBits, 0, maxYUV));
+  }
+  static constexpr Int dequantizeLuma(YUVType const luma) {
+    return isFullRange ? static_cast<Int>(luma) : static_cast<Int>(luma) - 16 * shift;
+  }
+  // Twice the distance from the bias in full range, which keeps the ±0.5 clamp of Quantizer exact.
+  static constexpr Int dequantizeChroma(YUVType const chroma) {
+    return isFullRange ?
+           clamp<Int>(2 * (static_cast<Int>(chroma) - bias), -maxYUV, maxYUV) :
+           static_cast<Int>(chroma) - 128 * shift;
+  }
+
+  static constexpr void calcYUV(uint16_t const r, uint16_t const g, uint16_t const b, YUVType* y, YUVType* u, YUVType* v) {
+    auto const ir = static_cast<Int>(r);
+    auto const ig = static_cast<Int>(g);
+    auto const ib = static_cast<Int>(b);
+    *y = quantize(forward[0] * ir + forward[1] * ig + forward[2] * ib + forward[9]);
+    if(u) {
+      *u = quantize(forward[3] * ir + forward[4] * ig + forward[5] * ib + forward[10]);
+    }
+    if(v) {
+      *v = quantize(forward[6] * ir + forward[7] * ig + forward[8] * ib + forward[11]);
+    }
+  }
+
+  // Chroma of the weighted sum of pixels, whose weights add up to (1 << log2Weight).
+  static constexpr void calcChroma(uint32_t const sumR, uint32_t const sumG, uint32_t const sumB, uint32_t const log2Weight, YUVType* u, YUVType* v) {
+    auto const r = static_cast<int64_t>(sumR);
+    auto const g = static_cast<int64_t>(sumG);
+    auto const b = static_cast<int64_t>(sumB);
+    int64_t const offset = static_cast<int64_t>(forward[10]) * (static_cast<int64_t>(1) << log2Weight);
+    int64_t const accU = forward[3] * r + forward[4] * g + forward[5] * b + offset;
+    int64_t const accV = forward[6] * r + forward[7] * g + forward[8] * b + offset;
+    *u = static_cast<YUVType>(clamp<int64_t>(accU >> (forwardBits + log2Weight), 0, maxYUV));
+    *v = static_cast<YUVType>(clamp<int64_t>(accV >> (forwardBits + log2Weight), 0, maxYUV));
+  }
+
+  // srcU and srcV are nullptr for monochrome YUV.
+  static constexpr std::tuple<RGBType, RGBType, RGBType> calcRGB(YUVType const* srcY, YUVType const* srcU, YUVType const* srcV) {
+    Int const y = dequantizeLuma(*srcY);
+    Int const u = srcU ? dequantizeChroma(*srcU) : 0;
+    Int const v = srcV ? dequantizeChroma(*srcV) : 0;
+    auto const calc = [&](size_t const row) {
+      Int const acc = inverse[row * 3] * y + inverse[row * 3 + 1] * u + inverse[row * 3 + 2] * v + half;
+      return static_cast<RGBType>(clamp<Int>(acc >> inverseBits, 0, maxRGB));
+    };
+    return std::make_tuple(calc(0), calc(1), calc(2));
+  }
+};
+
+}
@@ -0,0 +1,90 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+#include <type_traits>
+#include "./Math.hpp"
+#include "./Matrix.hpp"
+
+//
+// Table-driven YUV -> RGB for 8-bit YUV.
+//
+// Every dequantized sample and every product of a chroma sample with a matrix coefficient is
+// precomputed, per converter and range, into five tables of 256 floats. So each pixel costs a few
+// loads and additions instead of divisions and multiplications, and no libm call for rounding.
+// The additions and the rounding are the same as in detail::calcRGB, so the results are identical
+// unless the compiler contracts the float path into FMA (e.g. on AArch64), where they may differ by 1.
+//
+
+namespace avif::img::color {
+
+template <typename Converter, bool isFullRange>
+class LookupTable final {
+public:
+  static constexpr bool isSupported = std::is_base_of<PrimariesConverter<Converter>, Converter>::value;
+
+private:
+  std::array<float, 256> y_{};
+  std::array<float, 256> cbG_{};
+  std::array<float, 256> cbB_{};
+  std::array<float, 256> crR_{};
+  std::array<float, 256> crG_{};
+
+  LookupTable() {
+    using Quantizer = typename color::Quantizer<8, 8, isFullRange>;
+    for(size_t i = 0; i < 256; ++i) {
+      auto const sample = static_cast<uint8_t>(i);
+      float const chroma = Quantizer::dequantizeChroma(sample);
+      this->y_[i] = Quantizer::dequantizeLuma(sample);
+      this->cbG_[i] = Converter::Cb_G * chroma;
+      this->cbB_[i] = Converter::Cb_B * chroma;
+      this->crR_[i] = Converter::Cr_R * chroma;
+      this->crG_[i] = Converter::Cr_G * chroma;
+    }
+  }
+
+  // Same as std::round, which is a libm call on baseline x86-64. Exact, because v - trunc(v) is exact.
+  template <size_t rgbBits>
+  static typename color::RGB<rgbBits>::Type quantize(float const v) {
+    using RGBSpec = typename color::RGB<rgbBits>;
+    float const scaled = v * RGBSpec::max;
+    int rounded = static_cast<int>(scaled);
+    float const frac = scaled - static_cast<float>(rounded);
+    rounded += static_cast<int>(frac >= 0.5f) - static_cast<int>(frac <= -0.5f);
+    return static_cast<typename RGBSpec::Type>(clamp<int>(rounded, 0, static_cast<int>(RGBSpec::max)));
+  }
+
+public:
+  LookupTable(LookupTable const&) = delete;
+  LookupTable(LookupTable&&) = delete;
+  LookupTable& operator=(LookupTable const&) = delete;
+  LookupTable& operator=(LookupTable&&) = delete;
+  ~LookupTable() noexcept = default;
+
+  // Built on first use, then shared.
+  static LookupTable const& instance() {
+    static LookupTable const table;
+    return table;
+  }
+
+  // srcU and srcV are nullptr for monochrome YUV.
+  template <size_t rgbBits>
+  [[nodiscard]] std::tuple<typename color::RGB<rgbBits>::Type, typename color::RGB<rgbBits>::Type, typename color::RGB<rgbBits>::Type> calcRGB(uint8_t const* srcY, uint8_t const* srcU, uint8_t const* srcV) const {
+    float const y = this->y_[*srcY];
+    if(srcU == nullptr || srcV == nullptr) {
+      auto const mono = quantize<rgbBits>(y);
+      return std::make_tuple(mono, mono, mono);
+    }
+    float const r = y + this->crR_[*srcV];
+    float const g = y + this->cbG_[*srcU] + this->crG_[*srcV];
+    float const b = y + this->cbB_[*srcU];
+    return std::make_tuple(quantize<rgbBits>(r), quantize<rgbBits>(g), quantize<rgbBits>(b));
+  }
+};
+
+}
@@ -0,0 +1,157 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <atomic>
+#include <algorithm>
+#include "Kernels.hpp"
+#include "KernelsImpl.hpp"
+
+namespace avif::img::simd {
+
+namespace {
+
+std::atomic<InstructionSet>& currentInstructionSet() {
+  static std::atomic<InstructionSet> current(detectInstructionSet());
+  return current;
+}
+
+bool supports(InstructionSet const detected, InstructionSet const set) {
+  switch(set) {
+    case InstructionSet::None:
+      return true;
+    case InstructionSet::SSE41:
+      return detected == InstructionSet::SSE41 || detected == InstructionSet::AVX2;
+    case InstructionSet::AVX2:
+    case InstructionSet::NEON:
+      return detected == set;
+  }
+  return false;
+}
+
+RowKernels const* rowKernelsFor(InstructionSet const set) {
+  switch(set) {
+    case InstructionSet::None:
+      return nullptr;
+    case InstructionSet::SSE41:
+      return rowKernelsSSE41();
+    case InstructionSet::AVX2:
+      return rowKernelsAVX2();
+    case InstructionSet::NEON:
+      return rowKernelsNEON();
+  }
+  return nullptr;
+}
+
+TransformKernels const* transformKernelsFor(InstructionSet const set) {
+  switch(set) {
+    case InstructionSet::None:
+      return nullptr;
+    case InstructionSet::SSE41:
+      return transformKernelsSSE41();
+    case InstructionSet::AVX2:
+      return transformKernelsAVX2();
+    case InstructionSet::NEON:
+      return transformKernelsNEON();
+  }
+  return nullptr;
+}
+
+}
+
+InstructionSet detectInstructionSet() noexcept {
+#if defined(__aarch64__) || defined(_M_ARM64)
+  return rowKernelsNEON() != nullptr ? InstructionSet::NEON : InstructionSet::None;
+#elif (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+  // The kernels are null when the build did not compile them with their flags.
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2") && rowKernelsAVX2() != nullptr) {
+    return InstructionSet::AVX2;
+  }
+  if(__builtin_cpu_supports("sse4.1") && rowKernelsSSE41() != nullptr) {
+    return InstructionSet::SSE41;
+  }
+  return InstructionSet::None;
+#else
+  return InstructionSet::None;
+#endif
+}
+
+InstructionSet instructionSet() noexcept {
+  return currentInstructionSet().load(std::memory_order_relaxed);
+}
+
+InstructionSet useInstructionSet(InstructionSet set) noexcept {
+  if(!supports(detectInstructionSet(), set)) {
+    set = InstructionSet::None;
+  }
+  return currentInstructionSet().exchange(set);
+}
+
+bool convertFromRGB(RGBToYUV const& spec, size_t const width, size_t const height,
+                    uint8_t const* const src, size_t const stride,
+                    uint8_t* const dstY, size_t const strideY,
+                    uint8_t* const dstU, size_t const strideU,
+                    uint8_t* const dstV, size_t const strideV,
+                    bool const subX, bool const subY) {
+  RowKernels const* const kernels = rowKernelsFor(instructionSet());
+  if(kernels == nullptr) {
+    return false;
+  }
+  if(width == 0 || height == 0) {
+    return true;
+  }
+  for(size_t y = 0; y < height; ++y) {
+    kernels->lumaRow(spec, src + y * stride, width, dstY + y * strideY);
+  }
+  if(dstU == nullptr || dstV == nullptr) {
+    return true;
+  }
+  // The scalar templates overwrite each chroma sample with every pixel it covers, so the last one wins.
+  size_t const chromaWidth = subX ? (width + 1) / 2 : width;
+  size_t const chromaHeight = subY ? (height + 1) / 2 : height;
+  for(size_t cy = 0; cy < chromaHeight; ++cy) {
+    size_t const y = subY ? std::min(cy * 2 + 1, height - 1) : cy;
+    kernels->chromaRow(spec, src + y * stride, width, subX ? 1 : 0, subX ? 2 : 1, chromaWidth, dstU + cy * strideU, dstV + cy * strideV);
+  }
+  return true;
+}
+
+bool convertFromYUV(YUVToRGB const& spec, size_t const width, size_t const height,
+                    uint8_t* const dst, size_t const stride,
+                    uint8_t const* const srcY, size_t const strideY,
+                    uint8_t const* const srcU, size_t const strideU,
+                    uint8_t const* const srcV, size_t const strideV,
+                    bool const subX, bool const subY) {
+  RowKernels const* const kernels = rowKernelsFor(instructionSet());
+  if(kernels == nullptr) {
+    return false;
+  }
+  bool const mono = srcU == nullptr || srcV == nullptr;
+  for(size_t y = 0; y < height; ++y) {
+    size_t const cy = subY ? y / 2 : y;
+    kernels->rgbRow(spec,
+                    srcY + y * strideY,
+                    mono ? nullptr : srcU + cy * strideU,
+                    mono ? nullptr : srcV + cy * strideV,
+                    width, subX, dst + y * stride);
+  }
+  return true;
+}
+
+TransposeBlock transposeBlock8x8(size_t const bytesPerPixel) noexcept {
+  TransformKernels const* const kernels = transformKernelsFor(instructionSet());
+  if(kernels == nullptr) {
+    return nullptr;
+  }
+  switch(bytesPerPixel) {
+    case 1:
+      return kernels->transpose8x8[0];
+    case 2:
+      return kernels->transpose8x8[1];
+    default:
+      return nullptr;
+  }
+}
+
+}
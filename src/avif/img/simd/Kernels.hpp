@@ -0,0 +1,91 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Vectorized color conversion kernels, chosen at runtime by the CPU.
+// Both directions are covered: RGB -> YUV for FromRGB/FromAlpha, and YUV -> RGB for ToRGB/ToAlpha.
+// img/Conversion.hpp uses them for PrimariesConverter-based matrices and falls back to the scalar templates otherwise.
+// img/TransformImpl.hpp uses the 8x8 transposes at the bottom for rotations.
+//
+// The kernels perform the same float operations in the same order as detail::calcYUV and detail::calcRGB,
+// and emulate std::round (half away from zero) exactly.
+// So on x86-64 the results are bit-identical to the scalar templates.
+// On targets where the compiler may contract the scalar code into FMA (e.g. AArch64),
+// a component may differ by 1. test/ColorTest.cpp checks this ±1 tolerance.
+
+namespace avif::img::simd {
+
+enum class InstructionSet : uint8_t {
+  None = 0, // Use the scalar templates.
+  SSE41,
+  AVX2,
+  NEON,
+};
+
+// The best instruction set this CPU supports.
+InstructionSet detectInstructionSet() noexcept;
+// The instruction set in use. It is detectInstructionSet() unless overridden.
+InstructionSet instructionSet() noexcept;
+// Overrides the instruction set, for testing and benchmarking. Returns the previous one.
+// Unsupported ones fall back to None.
+InstructionSet useInstructionSet(InstructionSet set) noexcept;
+
+// Parameters of an RGB -> YUV conversion, which the scalar templates take as template arguments.
+struct RGBToYUV final {
+  // The matrix: PrimariesConverter::Kr, Kg and Kb.
+  float kr;
+  float kg;
+  float kb;
+  uint8_t rgbBits; // 8 or 16
+  uint8_t yuvBits; // 8, 10 or 12
+  bool fullRange;
+  bool fromMonoRGB;
+  size_t bytesPerPixel;
+};
+
+// Converts an RGB(A) or Mono(A) image. Returns false when no kernel is available; then nothing is written.
+// dstU and dstV are nullptr for monochrome YUV (I400).
+// For subsampled chroma, each chroma sample takes the value of the last pixel it covers, as the scalar templates do.
+bool convertFromRGB(RGBToYUV const& spec, size_t width, size_t height,
+                    uint8_t const* src, size_t stride,
+                    uint8_t* dstY, size_t strideY,
+                    uint8_t* dstU, size_t strideU,
+                    uint8_t* dstV, size_t strideV,
+                    bool subX, bool subY);
+
+// Parameters of a YUV -> RGB conversion.
+struct YUVToRGB final {
+  // The matrix: PrimariesConverter::Cr_R, Cb_G, Cr_G and Cb_B.
+  float crR;
+  float cbG;
+  float crG;
+  float cbB;
+  uint8_t rgbBits; // 8 or 16
+  uint8_t yuvBits; // 8, 10 or 12
+  bool fullRange;
+  bool toMonoRGB; // Writes only one component per pixel, which gets the blue value as the scalar templates do.
+  size_t bytesPerPixel;
+};
+
+// Converts into an RGB(A) or Mono(A) image. Returns false when no kernel is available; then nothing is written.
+// srcU and srcV are nullptr for monochrome YUV (I400).
+bool convertFromYUV(YUVToRGB const& spec, size_t width, size_t height,
+                    uint8_t* dst, size_t stride,
+                    uint8_t const* srcY, size_t strideY,
+                    uint8_t const* srcU, size_t strideU,
+                    uint8_t const* srcV, size_t strideV,
+                    bool subX, bool subY);
+
+// Transposes 8x8 pixels: row i of dst gets column i of src. The strides are in bytes and may be negative.
+using TransposeBlock = void (*)(uint8_t const* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride);
+
+// The transpose of the instruction set in use for pixels of bytesPerPixel bytes: 1 or 2.
+// nullptr for other sizes, or without a kernel; then the caller transposes with scalar code.
+TransposeBlock transposeBlock8x8(size_t bytesPerPixel) noexcept;
+
+}
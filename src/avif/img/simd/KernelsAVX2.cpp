@@ -0,0 +1,76 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+// Compiled with -mavx2. Called only when the CPU supports it.
+
+#include "KernelsImpl.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#include "TransposeSSE2.hpp"
+
+namespace avif::img::simd {
+
+namespace {
+
+struct AVX2 final {
+  using Type = __m256;
+  using Mask = __m256;
+  static constexpr size_t N = 8;
+  static Type set1(float const v) { return _mm256_set1_ps(v); }
+  static Type loadInts(int32_t const* const p) { return _mm256_cvtepi32_ps(_mm256_load_si256(reinterpret_cast<__m256i const*>(p))); }
+  static Type loadU8(uint8_t const* const p) { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p)))); }
+  static Type loadU16(uint16_t const* const p) { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)))); }
+  static void storeInts(Type const v, int32_t* const p) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), _mm256_cvttps_epi32(v)); }
+  static Type add(Type const a, Type const b) { return _mm256_add_ps(a, b); }
+  static Type sub(Type const a, Type const b) { return _mm256_sub_ps(a, b); }
+  static Type mul(Type const a, Type const b) { return _mm256_mul_ps(a, b); }
+  static Type div(Type const a, Type const b) { return _mm256_div_ps(a, b); }
+  static Type min(Type const a, Type const b) { return _mm256_min_ps(a, b); }
+  static Type max(Type const a, Type const b) { return _mm256_max_ps(a, b); }
+  static Type trunc(Type const v) { return _mm256_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+  static Mask ge(Type const a, Type const b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+  static Mask le(Type const a, Type const b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+  static Type select(Mask const mask, Type const ifTrue, Type const ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, mask); }
+  static constexpr bool hasGather = true;
+  template <typename Component>
+  static Type gather(uint8_t const* const base, size_t const strideBytes) {
+    auto const stride = static_cast<int32_t>(strideBytes);
+    __m256i const idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    __m256i const v = _mm256_i32gather_epi32(reinterpret_cast<int const*>(base), idx, 1);
+    __m256i const mask = _mm256_set1_epi32(sizeof(Component) == 1 ? 0xff : 0xffff);
+    return _mm256_cvtepi32_ps(_mm256_and_si256(v, mask));
+  }
+};
+
+}
+
+RowKernels const* rowKernelsAVX2() noexcept {
+  return impl::rowKernels<AVX2>();
+}
+
+TransformKernels const* transformKernelsAVX2() noexcept {
+  static TransformKernels const kernels {
+    {&sse2::transpose8x8U8, &sse2::transpose8x8U16},
+  };
+  return &kernels;
+}
+
+}
+
+#else
+
+namespace avif::img::simd {
+
+RowKernels const* rowKernelsAVX2() noexcept {
+  return nullptr;
+}
+
+TransformKernels const* transformKernelsAVX2() noexcept {
+  return nullptr;
+}
+
+}
+
+#endif
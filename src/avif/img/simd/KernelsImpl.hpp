@@ -0,0 +1,407 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+// Internal: the kernels written once against a small vector interface "V",
+// and instantiated by KernelsSSE41.cpp, KernelsAVX2.cpp and KernelsNEON.cpp with their own flags.
+// Do not include this file from the other headers.
+// Everything below has internal linkage and does not call std:: functions: each TU is compiled with different
+// instruction sets, and a shared inline function could be linked from the wrong one.
+//
+// V provides:
+//   Type, Mask, N
+//   set1(float), loadInts(int32_t const*), storeInts(Type, int32_t*) (truncating)
+//   add, sub, mul, div, min, max, trunc, ge, le, select(mask, ifTrue, ifFalse)
+//   loadU8(uint8_t const*), loadU16(uint16_t const*): N contiguous samples as floats
+//   hasGather, and gather<RGBType>(base, strideBytes) if hasGather:
+//     loads N components at base + k * strideBytes, reading 4 bytes at each.
+
+#include <cstdint>
+#include <cstddef>
+#include "Kernels.hpp"
+
+namespace avif::img::simd {
+
+// Row kernels. The chroma kernel converts pixel(i) = min(first + i * step, width - 1) for i in [0, count).
+struct RowKernels final {
+  void (*lumaRow)(RGBToYUV const& spec, uint8_t const* src, size_t width, uint8_t* dstY);
+  void (*chromaRow)(RGBToYUV const& spec, uint8_t const* src, size_t width, size_t first, size_t step, size_t count, uint8_t* dstU, uint8_t* dstV);
+  // srcU and srcV are nullptr for monochrome YUV. With subX, pixel x takes chroma sample x / 2.
+  void (*rgbRow)(YUVToRGB const& spec, uint8_t const* srcY, uint8_t const* srcU, uint8_t const* srcV, size_t width, bool subX, uint8_t* dst);
+};
+
+RowKernels const* rowKernelsSSE41() noexcept;
+RowKernels const* rowKernelsAVX2() noexcept;
+RowKernels const* rowKernelsNEON() noexcept;
+
+// 8x8 transposes for pixels of 1 and 2 bytes. Written per instruction set, without "V".
+// Wider pixels are moved by scalar code as fast: one load and one store each, and the copy is bound by memory.
+struct TransformKernels final {
+  TransposeBlock transpose8x8[2];
+};
+
+TransformKernels const* transformKernelsSSE41() noexcept;
+TransformKernels const* transformKernelsAVX2() noexcept;
+TransformKernels const* transformKernelsNEON() noexcept;
+
+namespace impl {
+namespace {
+
+template <typename V>
+size_t minOf(size_t const a, size_t const b) {
+  return a < b ? a : b;
+}
+
+// std::round: half away from zero. x - trunc(x) is exact, so this matches it for every float.
+template <typename V>
+typename V::Type round(typename V::Type const x) {
+  using T = typename V::Type;
+  T const t = V::trunc(x);
+  T const d = V::sub(x, t);
+  T const up = V::select(V::ge(d, V::set1(0.5f)), V::add(t, V::set1(1.0f)), t);
+  return V::select(V::le(d, V::set1(-0.5f)), V::sub(t, V::set1(1.0f)), up);
+}
+
+template <typename V>
+struct Constants final {
+  using T = typename V::Type;
+  T rgbMax;
+  T kr;
+  T kg;
+  T kb;
+  T oneMinusKr;
+  T oneMinusKb;
+  T half;
+  T yuvMax;
+  T zero;
+  T bias;
+  T shift;
+  T c16;
+  T c128;
+  T c219;
+  T c224;
+  bool fullRange;
+  explicit Constants(RGBToYUV const& spec)
+  :rgbMax(V::set1(spec.rgbBits == 8 ? 255.0f : 65535.0f))
+  ,kr(V::set1(spec.kr))
+  ,kg(V::set1(spec.kg))
+  ,kb(V::set1(spec.kb))
+  ,oneMinusKr(V::set1(1.0f - spec.kr))
+  ,oneMinusKb(V::set1(1.0f - spec.kb))
+  ,half(V::set1(0.5f))
+  ,yuvMax(V::set1(static_cast<float>((1u << spec.yuvBits) - 1u)))
+  ,zero(V::set1(0.0f))
+  ,bias(V::set1(static_cast<float>(1u << (spec.yuvBits - 1u))))
+  ,shift(V::set1(static_cast<float>(1u << (spec.yuvBits - 8u))))
+  ,c16(V::set1(16.0f))
+  ,c128(V::set1(128.0f))
+  ,c219(V::set1(219.0f))
+  ,c224(V::set1(224.0f))
+  ,fullRange(spec.fullRange)
+  {
+  }
+  // Same as Quantizer::quantizeLuma.
+  [[nodiscard]] T quantizeLuma(T const y) const {
+    T const v = this->fullRange ? V::mul(y, this->yuvMax) : V::mul(V::add(V::mul(y, this->c219), this->c16), this->shift);
+    return V::min(V::max(impl::round<V>(v), this->zero), this->yuvMax);
+  }
+  // Same as Quantizer::quantizeChroma.
+  [[nodiscard]] T quantizeChroma(T const c) const {
+    T const v = this->fullRange ?
+        V::add(impl::round<V>(V::mul(c, this->yuvMax)), this->bias) :
+        impl::round<V>(V::mul(V::add(V::mul(c, this->c224), this->c128), this->shift));
+    return V::min(V::max(v, this->zero), this->yuvMax);
+  }
+  // Same as PrimariesConverter::calcYUV.
+  [[nodiscard]] T luma(T const r, T const g, T const b) const {
+    return V::add(V::add(V::mul(this->kr, r), V::mul(this->kg, g)), V::mul(this->kb, b));
+  }
+  [[nodiscard]] T cb(T const y, T const b) const {
+    return V::div(V::mul(this->half, V::sub(b, y)), this->oneMinusKb);
+  }
+  [[nodiscard]] T cr(T const y, T const r) const {
+    return V::div(V::mul(this->half, V::sub(r, y)), this->oneMinusKr);
+  }
+};
+
+// Loads up to N pixels into int lanes. The rest lanes are zero.
+template <typename V, typename RGBType>
+void gatherRGB(RGBToYUV const& spec, uint8_t const* const src, size_t const width, size_t const first, size_t const step, size_t const begin, size_t const n, int32_t* const r, int32_t* const g, int32_t* const b) {
+  size_t const offG = spec.fromMonoRGB ? 0 : 1;
+  size_t const offB = spec.fromMonoRGB ? 0 : 2;
+  for(size_t k = 0; k < V::N; ++k) {
+    if(k < n) {
+      size_t const px = minOf<V>(first + (begin + k) * step, width - 1);
+      auto const* const p = reinterpret_cast<RGBType const*>(src + px * spec.bytesPerPixel);
+      r[k] = p[0];
+      g[k] = p[offG];
+      b[k] = p[offB];
+    } else {
+      r[k] = g[k] = b[k] = 0;
+    }
+  }
+}
+
+// Loads and normalizes the components of up to N pixels, like detail::calcYUV does.
+template <typename V, typename RGBType>
+void loadRGB(RGBToYUV const& spec, Constants<V> const& c, uint8_t const* const src, size_t const width, size_t const first, size_t const step, size_t const begin, size_t const n,
+             int32_t* const ir, int32_t* const ig, int32_t* const ib, typename V::Type& r, typename V::Type& g, typename V::Type& b) {
+  if constexpr (V::hasGather) {
+    size_t const bpp = spec.bytesPerPixel;
+    size_t const firstPx = first + begin * step;
+    size_t const lastPx = firstPx + (V::N - 1) * step;
+    size_t const offB = spec.fromMonoRGB ? 0 : 2 * sizeof(RGBType);
+    // The hardware gather reads 4 bytes for each component. Only the components up to the last one
+    // of the last pixel are sure to be there: src may point at a component past the first one of a pixel
+    // (FromAlpha passes the alpha channel), so the row can end right after them.
+    if(n == V::N && lastPx * bpp + offB + 4 <= (width - 1) * bpp + offB + sizeof(RGBType)) {
+      uint8_t const* const base = src + firstPx * bpp;
+      size_t const offG = spec.fromMonoRGB ? 0 : sizeof(RGBType);
+      r = V::div(V::template gather<RGBType>(base, step * bpp), c.rgbMax);
+      g = V::div(V::template gather<RGBType>(base + offG, step * bpp), c.rgbMax);
+      b = V::div(V::template gather<RGBType>(base + offB, step * bpp), c.rgbMax);
+      return;
+    }
+  }
+  gatherRGB<V, RGBType>(spec, src, width, first, step, begin, n, ir, ig, ib);
+  r = V::div(V::loadInts(ir), c.rgbMax);
+  g = V::div(V::loadInts(ig), c.rgbMax);
+  b = V::div(V::loadInts(ib), c.rgbMax);
+}
+
+template <typename V, typename YUVType>
+void scatter(int32_t const* const src, size_t const n, YUVType* const dst) {
+  for(size_t k = 0; k < n; ++k) {
+    dst[k] = static_cast<YUVType>(src[k]);
+  }
+}
+
+template <typename V, typename RGBType, typename YUVType>
+void lumaRow(RGBToYUV const& spec, uint8_t const* const src, size_t const width, uint8_t* const dstY) {
+  using T = typename V::Type;
+  Constants<V> const c(spec);
+  alignas(64) int32_t ir[V::N];
+  alignas(64) int32_t ig[V::N];
+  alignas(64) int32_t ib[V::N];
+  auto* const dst = reinterpret_cast<YUVType*>(dstY);
+  for(size_t i = 0; i < width; i += V::N) {
+    size_t const n = minOf<V>(V::N, width - i);
+    T r, g, b;
+    loadRGB<V, RGBType>(spec, c, src, width, 0, 1, i, n, ir, ig, ib, r, g, b);
+    V::storeInts(c.quantizeLuma(c.luma(r, g, b)), ir);
+    scatter<V>(ir, n, dst + i);
+  }
+}
+
+template <typename V, typename RGBType, typename YUVType>
+void chromaRow(RGBToYUV const& spec, uint8_t const* const src, size_t const width, size_t const first, size_t const step, size_t const count, uint8_t* const dstU, uint8_t* const dstV) {
+  using T = typename V::Type;
+  Constants<V> const c(spec);
+  alignas(64) int32_t ir[V::N];
+  alignas(64) int32_t ig[V::N];
+  alignas(64) int32_t ib[V::N];
+  auto* const u = reinterpret_cast<YUVType*>(dstU);
+  auto* const v = reinterpret_cast<YUVType*>(dstV);
+  for(size_t i = 0; i < count; i += V::N) {
+    size_t const n = minOf<V>(V::N, count - i);
+    T r, g, b;
+    loadRGB<V, RGBType>(spec, c, src, width, first, step, i, n, ir, ig, ib, r, g, b);
+    T const y = c.luma(r, g, b);
+    V::storeInts(c.quantizeChroma(c.cb(y, b)), ir);
+    V::storeInts(c.quantizeChroma(c.cr(y, r)), ig);
+    scatter<V>(ir, n, u + i);
+    scatter<V>(ig, n, v + i);
+  }
+}
+
+template <typename V>
+void lumaRowDispatch(RGBToYUV const& spec, uint8_t const* const src, size_t const width, uint8_t* const dstY) {
+  if(spec.rgbBits == 8) {
+    if(spec.yuvBits == 8) {
+      lumaRow<V, uint8_t, uint8_t>(spec, src, width, dstY);
+    } else {
+      lumaRow<V, uint8_t, uint16_t>(spec, src, width, dstY);
+    }
+  } else {
+    if(spec.yuvBits == 8) {
+      lumaRow<V, uint16_t, uint8_t>(spec, src, width, dstY);
+    } else {
+      lumaRow<V, uint16_t, uint16_t>(spec, src, width, dstY);
+    }
+  }
+}
+
+template <typename V>
+void chromaRowDispatch(RGBToYUV const& spec, uint8_t const* const src, size_t const width, size_t const first, size_t const step, size_t const count, uint8_t* const dstU, uint8_t* const dstV) {
+  if(spec.rgbBits == 8) {
+    if(spec.yuvBits == 8) {
+      chromaRow<V, uint8_t, uint8_t>(spec, src, width, first, step, count, dstU, dstV);
+    } else {
+      chromaRow<V, uint8_t, uint16_t>(spec, src, width, first, step, count, dstU, dstV);
+    }
+  } else {
+    if(spec.yuvBits == 8) {
+      chromaRow<V, uint16_t, uint8_t>(spec, src, width, first, step, count, dstU, dstV);
+    } else {
+      chromaRow<V, uint16_t, uint16_t>(spec, src, width, first, step, count, dstU, dstV);
+    }
+  }
+}
+
+template <typename V>
+struct DequantizeConstants final {
+  using T = typename V::Type;
+  T crR;
+  T cbG;
+  T crG;
+  T cbB;
+  T rgbMax;
+  T yuvMax;
+  T zero;
+  T bias;
+  T shift;
+  T c16;
+  T c128;
+  T c219;
+  T c224;
+  T minusHalf;
+  T half;
+  bool fullRange;
+  explicit DequantizeConstants(YUVToRGB const& spec)
+  :crR(V::set1(spec.crR))
+  ,cbG(V::set1(spec.cbG))
+  ,crG(V::set1(spec.crG))
+  ,cbB(V::set1(spec.cbB))
+  ,rgbMax(V::set1(spec.rgbBits == 8 ? 255.0f : 65535.0f))
+  ,yuvMax(V::set1(static_cast<float>((1u << spec.yuvBits) - 1u)))
+  ,zero(V::set1(0.0f))
+  ,bias(V::set1(static_cast<float>(1u << (spec.yuvBits - 1u))))
+  ,shift(V::set1(static_cast<float>(1u << (spec.yuvBits - 8u))))
+  ,c16(V::set1(16.0f))
+  ,c128(V::set1(128.0f))
+  ,c219(V::set1(219.0f))
+  ,c224(V::set1(224.0f))
+  ,minusHalf(V::set1(-0.5f))
+  ,half(V::set1(0.5f))
+  ,fullRange(spec.fullRange)
+  {
+  }
+  // Same as Quantizer::dequantizeLuma.
+  [[nodiscard]] T dequantizeLuma(T const y) const {
+    return this->fullRange ? V::div(y, this->yuvMax) : V::div(V::sub(V::div(y, this->shift), this->c16), this->c219);
+  }
+  // Same as Quantizer::dequantizeChroma.
+  [[nodiscard]] T dequantizeChroma(T const c) const {
+    if(this->fullRange) {
+      return V::min(V::max(V::div(V::sub(c, this->bias), this->yuvMax), this->minusHalf), this->half);
+    }
+    return V::div(V::sub(V::div(c, this->shift), this->c128), this->c224);
+  }
+  // Same as the rounding in detail::calcRGB.
+  [[nodiscard]] T quantizeRGB(T const v) const {
+    return V::min(V::max(impl::round<V>(V::mul(v, this->rgbMax)), this->zero), this->rgbMax);
+  }
+};
+
+template <typename V, typename YUVType>
+typename V::Type loadSamples(YUVType const* const src, size_t const n, int32_t* const scratch) {
+  if(n == V::N) {
+    if constexpr (sizeof(YUVType) == 1) {
+      return V::loadU8(src);
+    } else {
+      return V::loadU16(src);
+    }
+  }
+  for(size_t k = 0; k < V::N; ++k) {
+    scratch[k] = k < n ? src[k] : 0;
+  }
+  return V::loadInts(scratch);
+}
+
+// Chroma for pixels [begin, begin + n) of a horizontally subsampled row: sample x / 2 for pixel x.
+template <typename V, typename YUVType>
+typename V::Type loadSubsampled(YUVType const* const src, size_t const begin, size_t const n, int32_t* const scratch) {
+  for(size_t k = 0; k < V::N; ++k) {
+    scratch[k] = k < n ? src[(begin + k) / 2] : 0;
+  }
+  return V::loadInts(scratch);
+}
+
+template <typename V, typename RGBType, typename YUVType>
+void rgbRow(YUVToRGB const& spec, uint8_t const* const srcY, uint8_t const* const srcU, uint8_t const* const srcV, size_t const width, bool const subX, uint8_t* const dst) {
+  using T = typename V::Type;
+  DequantizeConstants<V> const c(spec);
+  alignas(64) int32_t scratch[V::N];
+  alignas(64) int32_t ir[V::N];
+  alignas(64) int32_t ig[V::N];
+  alignas(64) int32_t ib[V::N];
+  auto const* const py = reinterpret_cast<YUVType const*>(srcY);
+  auto const* const pu = reinterpret_cast<YUVType const*>(srcU);
+  auto const* const pv = reinterpret_cast<YUVType const*>(srcV);
+  bool const mono = pu == nullptr || pv == nullptr;
+  size_t const bpp = spec.bytesPerPixel;
+  for(size_t i = 0; i < width; i += V::N) {
+    size_t const n = minOf<V>(V::N, width - i);
+    T const y = c.dequantizeLuma(loadSamples<V>(py + i, n, scratch));
+    T u = c.zero;
+    T v = c.zero;
+    if(!mono) {
+      u = c.dequantizeChroma(subX ? loadSubsampled<V>(pu, i, n, scratch) : loadSamples<V>(pu + i, n, scratch));
+      v = c.dequantizeChroma(subX ? loadSubsampled<V>(pv, i, n, scratch) : loadSamples<V>(pv + i, n, scratch));
+    }
+    // Same as PrimariesConverter::calcRGB.
+    T const b = V::add(y, V::mul(c.cbB, u));
+    V::storeInts(c.quantizeRGB(b), ib);
+    uint8_t* out = dst + i * bpp;
+    if(spec.toMonoRGB) {
+      for(size_t k = 0; k < n; ++k, out += bpp) {
+        reinterpret_cast<RGBType*>(out)[0] = static_cast<RGBType>(ib[k]);
+      }
+      continue;
+    }
+    T const r = V::add(y, V::mul(c.crR, v));
+    T const g = V::add(V::add(y, V::mul(c.cbG, u)), V::mul(c.crG, v));
+    V::storeInts(c.quantizeRGB(r), ir);
+    V::storeInts(c.quantizeRGB(g), ig);
+    for(size_t k = 0; k < n; ++k, out += bpp) {
+      auto* const p = reinterpret_cast<RGBType*>(out);
+      p[0] = static_cast<RGBType>(ir[k]);
+      p[1] = static_cast<RGBType>(ig[k]);
+      p[2] = static_cast<RGBType>(ib[k]);
+    }
+  }
+}
+
+template <typename V>
+void rgbRowDispatch(YUVToRGB const& spec, uint8_t const* const srcY, uint8_t const* const srcU, uint8_t const* const srcV, size_t const width, bool const subX, uint8_t* const dst) {
+  if(spec.rgbBits == 8) {
+    if(spec.yuvBits == 8) {
+      rgbRow<V, uint8_t, uint8_t>(spec, srcY, srcU, srcV, width, subX, dst);
+    } else {
+      rgbRow<V, uint8_t, uint16_t>(spec, srcY, srcU, srcV, width, subX, dst);
+    }
+  } else {
+    if(spec.yuvBits == 8) {
+      rgbRow<V, uint16_t, uint8_t>(spec, srcY, srcU, srcV, width, subX, dst);
+    } else {
+      rgbRow<V, uint16_t, uint16_t>(spec, srcY, srcU, srcV, width, subX, dst);
+    }
+  }
+}
+
+template <typename V>
+RowKernels const* rowKernels() noexcept {
+  static RowKernels const kernels {
+    &lumaRowDispatch<V>,
+    &chromaRowDispatch<V>,
+    &rgbRowDispatch<V>,
+  };
+  return &kernels;
+}
+
+}
+}
+
+}
@@ -0,0 +1,123 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+// AArch64 only: it needs vrndq_f32 and vdivq_f32, which 32-bit ARM NEON lacks.
+
+#include "KernelsImpl.hpp"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+
+namespace avif::img::simd {
+
+namespace {
+
+struct NEON final {
+  using Type = float32x4_t;
+  using Mask = uint32x4_t;
+  static constexpr size_t N = 4;
+  static Type set1(float const v) { return vdupq_n_f32(v); }
+  static Type loadInts(int32_t const* const p) { return vcvtq_f32_s32(vld1q_s32(p)); }
+  static Type loadU8(uint8_t const* const p) {
+    uint8_t lanes[8] = {p[0], p[1], p[2], p[3], 0, 0, 0, 0};
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vld1_u8(lanes)))));
+  }
+  static Type loadU16(uint16_t const* const p) { return vcvtq_f32_u32(vmovl_u16(vld1_u16(p))); }
+  static void storeInts(Type const v, int32_t* const p) { vst1q_s32(p, vcvtq_s32_f32(v)); }
+  static Type add(Type const a, Type const b) { return vaddq_f32(a, b); }
+  static Type sub(Type const a, Type const b) { return vsubq_f32(a, b); }
+  static Type mul(Type const a, Type const b) { return vmulq_f32(a, b); }
+  static Type div(Type const a, Type const b) { return vdivq_f32(a, b); }
+  static Type min(Type const a, Type const b) { return vminq_f32(a, b); }
+  static Type max(Type const a, Type const b) { return vmaxq_f32(a, b); }
+  static Type trunc(Type const v) { return vrndq_f32(v); }
+  static Mask ge(Type const a, Type const b) { return vcgeq_f32(a, b); }
+  static Mask le(Type const a, Type const b) { return vcleq_f32(a, b); }
+  static Type select(Mask const mask, Type const ifTrue, Type const ifFalse) { return vbslq_f32(mask, ifTrue, ifFalse); }
+  static constexpr bool hasGather = false;
+};
+
+void transpose8x8U8(uint8_t const* const src, ptrdiff_t const srcStride, uint8_t* const dst, ptrdiff_t const dstStride) {
+  uint8x8x2_t const t01 = vtrn_u8(vld1_u8(src + 0 * srcStride), vld1_u8(src + 1 * srcStride));
+  uint8x8x2_t const t23 = vtrn_u8(vld1_u8(src + 2 * srcStride), vld1_u8(src + 3 * srcStride));
+  uint8x8x2_t const t45 = vtrn_u8(vld1_u8(src + 4 * srcStride), vld1_u8(src + 5 * srcStride));
+  uint8x8x2_t const t67 = vtrn_u8(vld1_u8(src + 6 * srcStride), vld1_u8(src + 7 * srcStride));
+  uint16x4x2_t const u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]), vreinterpret_u16_u8(t23.val[0]));
+  uint16x4x2_t const u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]), vreinterpret_u16_u8(t23.val[1]));
+  uint16x4x2_t const u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]), vreinterpret_u16_u8(t67.val[0]));
+  uint16x4x2_t const u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]), vreinterpret_u16_u8(t67.val[1]));
+  // Columns (0, 4), (1, 5), (2, 6) and (3, 7).
+  uint32x2x2_t const v04 = vtrn_u32(vreinterpret_u32_u16(u02.val[0]), vreinterpret_u32_u16(u46.val[0]));
+  uint32x2x2_t const v15 = vtrn_u32(vreinterpret_u32_u16(u13.val[0]), vreinterpret_u32_u16(u57.val[0]));
+  uint32x2x2_t const v26 = vtrn_u32(vreinterpret_u32_u16(u02.val[1]), vreinterpret_u32_u16(u46.val[1]));
+  uint32x2x2_t const v37 = vtrn_u32(vreinterpret_u32_u16(u13.val[1]), vreinterpret_u32_u16(u57.val[1]));
+  vst1_u8(dst + 0 * dstStride, vreinterpret_u8_u32(v04.val[0]));
+  vst1_u8(dst + 1 * dstStride, vreinterpret_u8_u32(v15.val[0]));
+  vst1_u8(dst + 2 * dstStride, vreinterpret_u8_u32(v26.val[0]));
+  vst1_u8(dst + 3 * dstStride, vreinterpret_u8_u32(v37.val[0]));
+  vst1_u8(dst + 4 * dstStride, vreinterpret_u8_u32(v04.val[1]));
+  vst1_u8(dst + 5 * dstStride, vreinterpret_u8_u32(v15.val[1]));
+  vst1_u8(dst + 6 * dstStride, vreinterpret_u8_u32(v26.val[1]));
+  vst1_u8(dst + 7 * dstStride, vreinterpret_u8_u32(v37.val[1]));
+}
+
+uint16x8_t loadU16Row(uint8_t const* const p) {
+  return vld1q_u16(reinterpret_cast<uint16_t const*>(p));
+}
+
+void transpose8x8U16(uint8_t const* const src, ptrdiff_t const srcStride, uint8_t* const dst, ptrdiff_t const dstStride) {
+  uint16x8x2_t const t01 = vtrnq_u16(loadU16Row(src + 0 * srcStride), loadU16Row(src + 1 * srcStride));
+  uint16x8x2_t const t23 = vtrnq_u16(loadU16Row(src + 2 * srcStride), loadU16Row(src + 3 * srcStride));
+  uint16x8x2_t const t45 = vtrnq_u16(loadU16Row(src + 4 * srcStride), loadU16Row(src + 5 * srcStride));
+  uint16x8x2_t const t67 = vtrnq_u16(loadU16Row(src + 6 * srcStride), loadU16Row(src + 7 * srcStride));
+  // Columns (0, 4) and (2, 6) of four rows, then (1, 5) and (3, 7).
+  uint32x4x2_t const u02 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]), vreinterpretq_u32_u16(t23.val[0]));
+  uint32x4x2_t const u13 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]), vreinterpretq_u32_u16(t23.val[1]));
+  uint32x4x2_t const u46 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]), vreinterpretq_u32_u16(t67.val[0]));
+  uint32x4x2_t const u57 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]), vreinterpretq_u32_u16(t67.val[1]));
+  auto const store = [&](size_t const row, uint32x4_t const top, uint32x4_t const bottom, bool const high) {
+    uint32x2_t const a = high ? vget_high_u32(top) : vget_low_u32(top);
+    uint32x2_t const b = high ? vget_high_u32(bottom) : vget_low_u32(bottom);
+    vst1q_u16(reinterpret_cast<uint16_t*>(dst + static_cast<ptrdiff_t>(row) * dstStride), vreinterpretq_u16_u32(vcombine_u32(a, b)));
+  };
+  store(0, u02.val[0], u46.val[0], false);
+  store(1, u13.val[0], u57.val[0], false);
+  store(2, u02.val[1], u46.val[1], false);
+  store(3, u13.val[1], u57.val[1], false);
+  store(4, u02.val[0], u46.val[0], true);
+  store(5, u13.val[0], u57.val[0], true);
+  store(6, u02.val[1], u46.val[1], true);
+  store(7, u13.val[1], u57.val[1], true);
+}
+
+}
+
+RowKernels const* rowKernelsNEON() noexcept {
+  return impl::rowKernels<NEON>();
+}
+
+TransformKernels const* transformKernelsNEON() noexcept {
+  static TransformKernels const kernels {
+    {&transpose8x8U8, &transpose8x8U16},
+  };
+  return &kernels;
+}
+
+}
+
+#else
+
+namespace avif::img::simd {
+
+RowKernels const* rowKernelsNEON() noexcept {
+  return nullptr;
+}
+
+TransformKernels const* transformKernelsNEON() noexcept {
+  return nullptr;
+}
+
+}
+
+#endif
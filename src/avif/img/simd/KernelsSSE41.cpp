@@ -0,0 +1,72 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+// Compiled with -msse4.1. Called only when the CPU supports it.
+
+#include "KernelsImpl.hpp"
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#include "TransposeSSE2.hpp"
+
+namespace avif::img::simd {
+
+namespace {
+
+struct SSE41 final {
+  using Type = __m128;
+  using Mask = __m128;
+  static constexpr size_t N = 4;
+  static Type set1(float const v) { return _mm_set1_ps(v); }
+  static Type loadInts(int32_t const* const p) { return _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<__m128i const*>(p))); }
+  static Type loadU8(uint8_t const* const p) {
+    int32_t v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+  }
+  static Type loadU16(uint16_t const* const p) { return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p)))); }
+  static void storeInts(Type const v, int32_t* const p) { _mm_store_si128(reinterpret_cast<__m128i*>(p), _mm_cvttps_epi32(v)); }
+  static Type add(Type const a, Type const b) { return _mm_add_ps(a, b); }
+  static Type sub(Type const a, Type const b) { return _mm_sub_ps(a, b); }
+  static Type mul(Type const a, Type const b) { return _mm_mul_ps(a, b); }
+  static Type div(Type const a, Type const b) { return _mm_div_ps(a, b); }
+  static Type min(Type const a, Type const b) { return _mm_min_ps(a, b); }
+  static Type max(Type const a, Type const b) { return _mm_max_ps(a, b); }
+  static Type trunc(Type const v) { return _mm_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+  static Mask ge(Type const a, Type const b) { return _mm_cmpge_ps(a, b); }
+  static Mask le(Type const a, Type const b) { return _mm_cmple_ps(a, b); }
+  static Type select(Mask const mask, Type const ifTrue, Type const ifFalse) { return _mm_blendv_ps(ifFalse, ifTrue, mask); }
+  static constexpr bool hasGather = false;
+};
+
+}
+
+RowKernels const* rowKernelsSSE41() noexcept {
+  return impl::rowKernels<SSE41>();
+}
+
+TransformKernels const* transformKernelsSSE41() noexcept {
+  static TransformKernels const kernels {
+    {&sse2::transpose8x8U8, &sse2::transpose8x8U16},
+  };
+  return &kernels;
+}
+
+}
+
+#else
+
+namespace avif::img::simd {
+
+RowKernels const* rowKernelsSSE41() noexcept {
+  return nullptr;
+}
+
+TransformKernels const* transformKernelsSSE41() noexcept {
+  return nullptr;
+}
+
+}
+
+#endif
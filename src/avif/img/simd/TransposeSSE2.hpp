@@ -0,0 +1,89 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+// Internal: 8x8 transposes with SSE2, included by KernelsSSE41.cpp and KernelsAVX2.cpp.
+// Like KernelsImpl.hpp, everything has internal linkage so each TU keeps its own copy.
+
+#include <cstdint>
+#include <cstddef>
+#include <emmintrin.h>
+
+namespace avif::img::simd::sse2 {
+namespace {
+
+inline __m128i load64(uint8_t const* const p) {
+  return _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p));
+}
+inline __m128i load128(uint8_t const* const p) {
+  return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+}
+inline void store64(uint8_t* const p, __m128i const v) {
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(p), v);
+}
+inline void store128(uint8_t* const p, __m128i const v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+void transpose8x8U8(uint8_t const* const src, ptrdiff_t const srcStride, uint8_t* const dst, ptrdiff_t const dstStride) {
+  __m128i const a0 = _mm_unpacklo_epi8(load64(src + 0 * srcStride), load64(src + 1 * srcStride));
+  __m128i const a1 = _mm_unpacklo_epi8(load64(src + 2 * srcStride), load64(src + 3 * srcStride));
+  __m128i const a2 = _mm_unpacklo_epi8(load64(src + 4 * srcStride), load64(src + 5 * srcStride));
+  __m128i const a3 = _mm_unpacklo_epi8(load64(src + 6 * srcStride), load64(src + 7 * srcStride));
+  // Columns 0-3 and 4-7 of rows 0-3, then of rows 4-7.
+  __m128i const b0 = _mm_unpacklo_epi16(a0, a1);
+  __m128i const b1 = _mm_unpackhi_epi16(a0, a1);
+  __m128i const b2 = _mm_unpacklo_epi16(a2, a3);
+  __m128i const b3 = _mm_unpackhi_epi16(a2, a3);
+  // Two columns each.
+  __m128i const c0 = _mm_unpacklo_epi32(b0, b2);
+  __m128i const c1 = _mm_unpackhi_epi32(b0, b2);
+  __m128i const c2 = _mm_unpacklo_epi32(b1, b3);
+  __m128i const c3 = _mm_unpackhi_epi32(b1, b3);
+  store64(dst + 0 * dstStride, c0);
+  store64(dst + 1 * dstStride, _mm_srli_si128(c0, 8));
+  store64(dst + 2 * dstStride, c1);
+  store64(dst + 3 * dstStride, _mm_srli_si128(c1, 8));
+  store64(dst + 4 * dstStride, c2);
+  store64(dst + 5 * dstStride, _mm_srli_si128(c2, 8));
+  store64(dst + 6 * dstStride, c3);
+  store64(dst + 7 * dstStride, _mm_srli_si128(c3, 8));
+}
+
+void transpose8x8U16(uint8_t const* const src, ptrdiff_t const srcStride, uint8_t* const dst, ptrdiff_t const dstStride) {
+  __m128i r[8];
+  for(int i = 0; i < 8; ++i) {
+    r[i] = load128(src + i * srcStride);
+  }
+  // Pairs of rows, interleaved: columns 0-3, then 4-7.
+  __m128i const a0 = _mm_unpacklo_epi16(r[0], r[1]);
+  __m128i const a1 = _mm_unpackhi_epi16(r[0], r[1]);
+  __m128i const a2 = _mm_unpacklo_epi16(r[2], r[3]);
+  __m128i const a3 = _mm_unpackhi_epi16(r[2], r[3]);
+  __m128i const a4 = _mm_unpacklo_epi16(r[4], r[5]);
+  __m128i const a5 = _mm_unpackhi_epi16(r[4], r[5]);
+  __m128i const a6 = _mm_unpacklo_epi16(r[6], r[7]);
+  __m128i const a7 = _mm_unpackhi_epi16(r[6], r[7]);
+  // Two columns of four rows each.
+  __m128i const b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i const b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i const b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i const b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i const b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i const b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i const b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i const b7 = _mm_unpackhi_epi32(a5, a7);
+  store128(dst + 0 * dstStride, _mm_unpacklo_epi64(b0, b4));
+  store128(dst + 1 * dstStride, _mm_unpackhi_epi64(b0, b4));
+  store128(dst + 2 * dstStride, _mm_unpacklo_epi64(b1, b5));
+  store128(dst + 3 * dstStride, _mm_unpackhi_epi64(b1, b5));
+  store128(dst + 4 * dstStride, _mm_unpacklo_epi64(b2, b6));
+  store128(dst + 5 * dstStride, _mm_unpackhi_epi64(b2, b6));
+  store128(dst + 6 * dstStride, _mm_unpacklo_epi64(b3, b7));
+  store128(dst + 7 * dstStride, _mm_unpackhi_epi64(b3, b7));
+}
+
+}
+}
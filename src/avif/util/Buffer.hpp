@@ -0,0 +1,82 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <fmt/format.h>
+
+namespace avif::util {
+
+// Read-only, contiguous bytes.
+// It may own a heap vector, hold a memory-mapped file, or just refer to memory owned by someone else.
+// Copying a Buffer never copies the bytes; copies share the same storage.
+class Buffer final {
+private:
+  std::shared_ptr<void const> owner_{};
+  uint8_t const* data_{};
+  size_t size_{};
+public:
+  Buffer() = default;
+  Buffer(Buffer const&) = default;
+  Buffer(Buffer&&) noexcept = default;
+  Buffer& operator=(Buffer const&) = default;
+  Buffer& operator=(Buffer&&) noexcept = default;
+  ~Buffer() noexcept = default;
+
+public:
+  // Takes the ownership of the vector.
+  Buffer(std::vector<uint8_t> data) { // NOLINT(google-explicit-constructor): boxes accept vectors as before.
+    auto owner = std::make_shared<std::vector<uint8_t> const>(std::move(data));
+    this->data_ = owner->data();
+    this->size_ = owner->size();
+    this->owner_ = std::move(owner);
+  }
+  // Does not take the ownership. The caller must keep the memory alive while using this buffer.
+  explicit Buffer(uint8_t const* const data, size_t const size)
+  :owner_()
+  ,data_(data)
+  ,size_(size)
+  {
+  }
+  // Shares the ownership of "owner", which keeps [data, data+size) alive.
+  explicit Buffer(std::shared_ptr<void const> owner, uint8_t const* const data, size_t const size)
+  :owner_(std::move(owner))
+  ,data_(data)
+  ,size_(size)
+  {
+  }
+
+public:
+  [[ nodiscard ]] uint8_t const* data() const noexcept { return this->data_; }
+  [[ nodiscard ]] size_t size() const noexcept { return this->size_; }
+  [[ nodiscard ]] bool empty() const noexcept { return this->size_ == 0; }
+  [[ nodiscard ]] bool owned() const noexcept { return static_cast<bool>(this->owner_); }
+  [[ nodiscard ]] uint8_t const* begin() const noexcept { return this->data_; }
+  [[ nodiscard ]] uint8_t const* end() const noexcept { return this->data_ + this->size_; }
+  [[ nodiscard ]] uint8_t operator[](size_t const idx) const noexcept { return this->data_[idx]; }
+  [[ nodiscard ]] uint8_t at(size_t const idx) const {
+    if(idx >= this->size_) {
+      throw std::out_of_range(fmt::format("Buffer::at: {} >= {}", idx, this->size_));
+    }
+    return this->data_[idx];
+  }
+  // [offset, offset + size) of this buffer. It shares the storage, so no bytes are copied.
+  [[ nodiscard ]] Buffer slice(size_t const offset, size_t const size) const {
+    if(offset > this->size_ || size > this->size_ - offset) {
+      throw std::out_of_range(fmt::format("Buffer::slice: [{}, {}) is out of [0, {})", offset, offset + size, this->size_));
+    }
+    return Buffer(this->owner_, this->data_ + offset, size);
+  }
+  // Copies the bytes, when you need them independent of the original storage.
+  [[ nodiscard ]] std::vector<uint8_t> toVector() const {
+    return std::vector<uint8_t>(this->begin(), this->end());
+  }
+};
+
+}
@@ -0,0 +1,73 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <cstdlib>
+#endif
+
+namespace avif::util {
+
+// Unaligned big-endian loads. Callers must check the bounds beforehand.
+
+constexpr bool kLittleEndianHost =
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    false;
+#else
+    true;
+#endif
+
+inline uint16_t byteSwap16(uint16_t const v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap16(v);
+#elif defined(_MSC_VER)
+  return _byteswap_ushort(v);
+#else
+  return static_cast<uint16_t>(static_cast<uint16_t>(v << 8u) | static_cast<uint16_t>(v >> 8u));
+#endif
+}
+
+inline uint32_t byteSwap32(uint32_t const v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap32(v);
+#elif defined(_MSC_VER)
+  return _byteswap_ulong(v);
+#else
+  return (v << 24u) | ((v << 8u) & 0x00ff0000u) | ((v >> 8u) & 0x0000ff00u) | (v >> 24u);
+#endif
+}
+
+inline uint64_t byteSwap64(uint64_t const v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap64(v);
+#elif defined(_MSC_VER)
+  return _byteswap_uint64(v);
+#else
+  return static_cast<uint64_t>(byteSwap32(static_cast<uint32_t>(v))) << 32u | byteSwap32(static_cast<uint32_t>(v >> 32u));
+#endif
+}
+
+inline uint16_t loadU16BE(uint8_t const* const ptr) {
+  uint16_t v;
+  std::memcpy(&v, ptr, sizeof(v));
+  return kLittleEndianHost ? byteSwap16(v) : v;
+}
+
+inline uint32_t loadU32BE(uint8_t const* const ptr) {
+  uint32_t v;
+  std::memcpy(&v, ptr, sizeof(v));
+  return kLittleEndianHost ? byteSwap32(v) : v;
+}
+
+inline uint64_t loadU64BE(uint8_t const* const ptr) {
+  uint64_t v;
+  std::memcpy(&v, ptr, sizeof(v));
+  return kLittleEndianHost ? byteSwap64(v) : v;
+}
+
+}
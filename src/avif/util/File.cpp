@@ -7,6 +7,13 @@
 
 #include "File.hpp"
 
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace avif::util {
 
 std::variant<std::vector<uint8_t>, std::string> readFile(std::string const& fname) {
@@ -28,6 +35,45 @@ std::variant<std::vector<uint8_t>, std::string> readFile(std::string const& fnam
   return std::variant<std::vector<uint8_t>, std::string>(std::move(data));
 }
 
+std::variant<Buffer, std::string> mapFile(std::string const& fname) {
+#if defined(_WIN32)
+  auto data = readFile(fname);
+  if(std::holds_alternative<std::string>(data)) {
+    return std::variant<Buffer, std::string>(std::get<std::string>(data));
+  }
+  return std::variant<Buffer, std::string>(Buffer(std::move(std::get<std::vector<uint8_t>>(data))));
+#else
+  int const fd = open(fname.c_str(), O_RDONLY);
+  if(fd < 0) {
+    if(!std::filesystem::exists(fname)) {
+      return std::variant<Buffer, std::string>(fmt::format("File not found: {}", fname));
+    }
+    return std::variant<Buffer, std::string>(fmt::format("Could not open file: {}", fname));
+  }
+  struct stat st = {};
+  if(fstat(fd, &st) != 0) {
+    close(fd);
+    return std::variant<Buffer, std::string>(fmt::format("Could not stat file: {}", fname));
+  }
+  auto const fsize = static_cast<size_t>(st.st_size);
+  if(fsize == 0) {
+    // mmap(2) does not accept zero length.
+    close(fd);
+    return std::variant<Buffer, std::string>(Buffer(std::vector<uint8_t>()));
+  }
+  void* const addr = mmap(nullptr, fsize, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after closing the descriptor.
+  close(fd);
+  if(addr == MAP_FAILED) {
+    return std::variant<Buffer, std::string>(fmt::format("Could not map file: {}", fname));
+  }
+  std::shared_ptr<void const> owner(addr, [fsize](void const* ptr) {
+    munmap(const_cast<void*>(ptr), fsize);
+  });
+  return std::variant<Buffer, std::string>(Buffer(std::move(owner), static_cast<uint8_t const*>(addr), fsize));
+#endif
+}
+
 std::optional<std::string> writeFile(std::string const& fname, std::vector<uint8_t> const& data){
   FILE* const file = fopen(fname.c_str(), "wb");
   if(!file) {
@@ -8,10 +8,14 @@
 #include <optional>
 #include <vector>
 #include <string>
+#include "Buffer.hpp"
 
 namespace avif::util {
 
 std::variant<std::vector<uint8_t>, std::string> readFile(std::string const& fname);
+// Maps the whole file read-only. Pages are loaded only when touched.
+// Falls back to readFile() on platforms without mmap(2).
+std::variant<Buffer, std::string> mapFile(std::string const& fname);
 std::optional<std::string> writeFile(std::string const& fname, std::vector<uint8_t> const& data);
 
 }
@@ -9,13 +9,16 @@
 #include <optional>
 #include <string>
 #include "Logger.hpp"
+#include "Endian.hpp"
 
 namespace avif::util {
 
 class StreamReader {
 private:
   Logger& log_;
-  std::vector<uint8_t> const& buffer_;
+  uint8_t const* const data_;
+  size_t const size_;
+  size_t const origin_; // data_[0] is at this position in the stream.
   size_t pos_;
 public:
   StreamReader() = delete;
@@ -25,27 +28,72 @@ public:
   StreamReader& operator=(StreamReader&&) = delete;
   explicit StreamReader(util::Logger& log, std::vector<uint8_t> const& buffer)
   :log_(log)
-  ,buffer_(buffer)
+  ,data_(buffer.data())
+  ,size_(buffer.size())
+  ,origin_(0)
   ,pos_(0)
   {
   }
+  explicit StreamReader(util::Logger& log, uint8_t const* const data, size_t const size)
+  :StreamReader(log, data, size, 0)
+  {
+  }
+  // Reads a window of a larger stream. "data" holds the bytes at [origin, origin + size).
+  explicit StreamReader(util::Logger& log, uint8_t const* const data, size_t const size, size_t const origin)
+  :log_(log)
+  ,data_(data)
+  ,size_(size)
+  ,origin_(origin)
+  ,pos_(origin)
+  {
+  }
   ~StreamReader() noexcept = default;
 
 public:
   [[nodiscard]] util::Logger& log() { return this->log_; }
   [[nodiscard]] size_t pos() const { return this->pos_; }
+  [[nodiscard]] size_t origin() const { return this->origin_; }
+  [[nodiscard]] size_t end() const { return this->origin_ + this->size_; }
   void seek(size_t pos) {
     this->pos_ = pos;
   }
 
 public:
-  [[nodiscard]] uint8_t  readU8();
-  [[nodiscard]] uint16_t readU16();
-  [[nodiscard]] uint32_t readU32();
-  [[nodiscard]] uint64_t readU64();
+  // Each read checks the bounds just once, not byte by byte.
+  [[nodiscard]] uint8_t  readU8() { require(1); return readU8Unchecked(); }
+  [[nodiscard]] uint16_t readU16() { require(2); return readU16Unchecked(); }
+  [[nodiscard]] uint32_t readU32() { require(4); return readU32Unchecked(); }
+  [[nodiscard]] uint64_t readU64() { require(8); return readU64Unchecked(); }
   [[nodiscard]] std::optional<uint64_t> readUint(size_t octets);
   [[nodiscard]] std::string readString();
-  [[nodiscard]] bool consumed() const { return this->pos_ >= this->buffer_.size(); }
+  [[nodiscard]] bool consumed() const { return this->pos_ >= this->end(); }
+
+public:
+  // Throws std::out_of_range unless [pos, pos + octets) is in the buffer.
+  void require(size_t const octets) const {
+    if(this->pos_ < this->origin_ || this->pos_ > this->end() || octets > this->end() - this->pos_) {
+      this->throwOutOfRange(octets);
+    }
+  }
+  // Call require() beforehand to read a fixed-size structure at once.
+  [[nodiscard]] uint8_t  readU8Unchecked() { return this->data_[this->pos_++ - this->origin_]; }
+  [[nodiscard]] uint16_t readU16Unchecked() { uint16_t const v = loadU16BE(this->current()); this->pos_ += 2; return v; }
+  [[nodiscard]] uint32_t readU32Unchecked() { uint32_t const v = loadU32BE(this->current()); this->pos_ += 4; return v; }
+  [[nodiscard]] uint64_t readU64Unchecked() { uint64_t const v = loadU64BE(this->current()); this->pos_ += 8; return v; }
+  // octets must be one of 0, 1, 2, 4 and 8.
+  [[nodiscard]] uint64_t readUintUnchecked(size_t const octets) {
+    switch(octets) {
+      case 1: return readU8Unchecked();
+      case 2: return readU16Unchecked();
+      case 4: return readU32Unchecked();
+      case 8: return readU64Unchecked();
+      default: return 0;
+    }
+  }
+
+private:
+  [[nodiscard]] uint8_t const* current() const { return this->data_ + (this->pos_ - this->origin_); }
+  [[noreturn]] void throwOutOfRange(size_t octets) const;
 };
 
 }
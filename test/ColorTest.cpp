@@ -4,8 +4,16 @@
 
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <type_traits>
 #include <gtest/gtest.h>
 #include "../src/avif/img/Conversion.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 TEST(ColorTest, LimitedRange) {
   using namespace avif::img;
@@ -90,3 +98,521 @@ TEST(ColorTest, DefaultOfCICP) {
   ASSERT_TRUE(5 == cicp.matrixCoefficients || 6 == cicp.matrixCoefficients);
   ASSERT_EQ(true, cicp.fullRangeFlag);
 }
+
+namespace {
+
+template <uint8_t rgbBits>
+avif::img::Image<rgbBits> makeNoiseImage(avif::img::PixelOrder const order, uint32_t const width, uint32_t const height) {
+  auto img = avif::img::Image<rgbBits>::createEmptyImage(order, width, height);
+  uint32_t state = 12345;
+  for(size_t i = 0; i < img.stride() * img.height(); ++i) {
+    state = state * 1103515245u + 12345u;
+    img.data()[i] = static_cast<uint8_t>(state >> 16u);
+  }
+  return img;
+}
+
+template <uint8_t yuvBits>
+std::vector<uint8_t> makeNoisePlane(size_t const count, uint32_t state) {
+  using YUVType = typename avif::img::color::YUV<yuvBits>::Type;
+  std::vector<uint8_t> plane(count * sizeof(YUVType));
+  auto* const samples = reinterpret_cast<YUVType*>(plane.data());
+  for(size_t i = 0; i < count; ++i) {
+    state = state * 1103515245u + 12345u;
+    samples[i] = static_cast<YUVType>((state >> 8u) & ((1u << yuvBits) - 1u));
+  }
+  return plane;
+}
+
+// The SIMD kernels may differ from the scalar templates by this much. See img/simd/Kernels.hpp.
+constexpr int kSIMDTolerance = 1;
+
+template <typename T>
+void expectSamplesNear(uint8_t const* const expected, uint8_t const* const actual, size_t const size, char const* name) {
+  auto const* e = reinterpret_cast<T const*>(expected);
+  auto const* a = reinterpret_cast<T const*>(actual);
+  for(size_t i = 0; i < size / sizeof(T); ++i) {
+    ASSERT_LE(std::abs(static_cast<int>(e[i]) - static_cast<int>(a[i])), kSIMDTolerance) << name << "[" << i << "]";
+  }
+}
+
+template <uint8_t rgbBits, uint8_t yuvBits, bool isFullRange, bool subX, bool subY>
+void checkFromRGBMatchesScalar(avif::img::PixelOrder const order) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  using YUVType = typename color::YUV<yuvBits>::Type;
+  uint32_t const width = 37;
+  uint32_t const height = 11;
+  bool const mono = order == PixelOrder::Mono || order == PixelOrder::MonoA;
+  auto const src = makeNoiseImage<rgbBits>(order, width, height);
+  size_t const strideY = width * sizeof(YUVType);
+  size_t const chromaWidth = subX ? (width + 1) / 2 : width;
+  size_t const chromaHeight = subY ? (height + 1) / 2 : height;
+  size_t const strideC = chromaWidth * sizeof(YUVType);
+  std::vector<uint8_t> y0(strideY * height), u0(strideC * chromaHeight), v0(strideC * chromaHeight);
+  auto run = [&](auto fromMono) {
+    constexpr bool fromMonoRGB = decltype(fromMono)::value;
+    detail::convertFromRGB<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange, subX, subY>(
+        width, height, src.bytesPerPixel(), src.data(), src.stride(), y0.data(), strideY, u0.data(), strideC, v0.data(), strideC);
+    for(auto const set : {simd::InstructionSet::SSE41, simd::InstructionSet::AVX2, simd::InstructionSet::NEON}) {
+      simd::useInstructionSet(set);
+      if(simd::instructionSet() != set) {
+        continue;
+      }
+      std::vector<uint8_t> y1(y0.size()), u1(u0.size()), v1(v0.size());
+      ASSERT_TRUE((detail::convertFromRGBWithSIMD<Converter, rgbBits, yuvBits, fromMonoRGB, isFullRange>(
+          width, height, src.bytesPerPixel(), src.data(), src.stride(), y1.data(), strideY, u1.data(), strideC, v1.data(), strideC, subX, subY)));
+      expectSamplesNear<YUVType>(y0.data(), y1.data(), y0.size(), "Y");
+      expectSamplesNear<YUVType>(u0.data(), u1.data(), u0.size(), "U");
+      expectSamplesNear<YUVType>(v0.data(), v1.data(), v0.size(), "V");
+    }
+  };
+  if(mono) {
+    run(std::true_type{});
+  } else {
+    run(std::false_type{});
+  }
+  simd::useInstructionSet(simd::detectInstructionSet());
+}
+
+// Compares the whole RGB(A) buffer, so padding and untouched components must stay equal too.
+template <uint8_t rgbBits, uint8_t yuvBits, bool isFullRange, bool isMonoYUV, bool subX, bool subY>
+void checkToRGBMatchesScalar(avif::img::PixelOrder const order) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  using YUVType = typename color::YUV<yuvBits>::Type;
+  using RGBType = typename color::RGB<rgbBits>::Type;
+  uint32_t const width = 37;
+  uint32_t const height = 11;
+  bool const mono = order == PixelOrder::Mono || order == PixelOrder::MonoA;
+  size_t const strideY = width * sizeof(YUVType);
+  size_t const chromaWidth = subX ? (width + 1) / 2 : width;
+  size_t const chromaHeight = subY ? (height + 1) / 2 : height;
+  size_t const strideC = chromaWidth * sizeof(YUVType);
+  auto const y = makeNoisePlane<yuvBits>(width * height, 1);
+  auto const u = makeNoisePlane<yuvBits>(chromaWidth * chromaHeight, 2);
+  auto const v = makeNoisePlane<yuvBits>(chromaWidth * chromaHeight, 3);
+  auto run = [&](auto toMono) {
+    constexpr bool toMonoRGB = decltype(toMono)::value;
+    auto dst0 = Image<rgbBits>::createEmptyImage(order, width, height);
+    if constexpr (isMonoYUV) {
+      detail::convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange>(
+          width, height, dst0.bytesPerPixel(), dst0.data(), dst0.stride(), y.data(), strideY);
+    } else {
+      detail::convertFromYUV<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange, subX, subY>(
+          width, height, dst0.bytesPerPixel(), dst0.data(), dst0.stride(), y.data(), strideY, u.data(), strideC, v.data(), strideC);
+    }
+    for(auto const set : {simd::InstructionSet::SSE41, simd::InstructionSet::AVX2, simd::InstructionSet::NEON}) {
+      simd::useInstructionSet(set);
+      if(simd::instructionSet() != set) {
+        continue;
+      }
+      auto dst1 = Image<rgbBits>::createEmptyImage(order, width, height);
+      ASSERT_TRUE((detail::convertFromYUVWithSIMD<Converter, rgbBits, yuvBits, toMonoRGB, isFullRange>(
+          width, height, dst1.bytesPerPixel(), dst1.data(), dst1.stride(),
+          y.data(), strideY, isMonoYUV ? nullptr : u.data(), strideC, isMonoYUV ? nullptr : v.data(), strideC, subX, subY)));
+      expectSamplesNear<RGBType>(dst0.data(), dst1.data(), dst0.stride() * height, "RGB");
+    }
+  };
+  if(mono) {
+    run(std::true_type{});
+  } else {
+    run(std::false_type{});
+  }
+  simd::useInstructionSet(simd::detectInstructionSet());
+}
+
+// Memory whose last byte is the last one readable: where the OS allows, an inaccessible page follows,
+// so reading past the end crashes instead of going unnoticed.
+class GuardedBuffer final {
+private:
+  uint8_t* base_{};
+  size_t mapped_{};
+  std::vector<uint8_t> fallback_{};
+  uint8_t* data_{};
+public:
+  explicit GuardedBuffer(size_t const size) {
+#if defined(__unix__) || defined(__APPLE__)
+    size_t const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t const pages = (size + page - 1) / page;
+    this->mapped_ = (pages + 1) * page;
+    void* const mem = mmap(nullptr, this->mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem != MAP_FAILED) {
+      this->base_ = static_cast<uint8_t*>(mem);
+      mprotect(this->base_ + pages * page, page, PROT_NONE);
+      this->data_ = this->base_ + pages * page - size;
+      return;
+    }
+    this->mapped_ = 0;
+#endif
+    this->fallback_.resize(size);
+    this->data_ = this->fallback_.data();
+  }
+  GuardedBuffer(GuardedBuffer const&) = delete;
+  GuardedBuffer(GuardedBuffer&&) = delete;
+  GuardedBuffer& operator=(GuardedBuffer const&) = delete;
+  GuardedBuffer& operator=(GuardedBuffer&&) = delete;
+  ~GuardedBuffer() noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    if(this->base_ != nullptr) {
+      munmap(this->base_, this->mapped_);
+    }
+#endif
+  }
+  [[ nodiscard ]] uint8_t* data() { return this->data_; }
+};
+
+// FromAlpha and ToAlpha hand the kernels a pointer to the alpha channel, which is the last component of each pixel.
+// The packed image ends right at the end of the memory, so nothing past the alpha of the last pixel may be touched.
+template <uint8_t rgbBits, uint8_t yuvBits>
+void checkAlphaStaysInBuffer(avif::img::PixelOrder const order) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  using YUVType = typename color::YUV<yuvBits>::Type;
+  using RGBType = typename color::RGB<rgbBits>::Type;
+  // A multiple of every vector width, so that the last pixel is loaded with a full vector.
+  uint32_t const width = 40;
+  uint32_t const height = 11;
+  auto const noise = makeNoiseImage<rgbBits>(order, width, height);
+  size_t const bytesPerPixel = noise.bytesPerPixel();
+  size_t const stride = width * bytesPerPixel;
+  size_t const alphaOffset = (noise.numComponents() - 1) * noise.bytesPerComponent();
+  GuardedBuffer rgb(stride * height);
+  for(size_t y = 0; y < height; ++y) {
+    std::copy_n(noise.data() + noise.stride() * y, stride, rgb.data() + stride * y);
+  }
+  size_t const strideA = width * sizeof(YUVType);
+  std::vector<uint8_t> a0(strideA * height);
+  detail::convertFromRGB<Converter, rgbBits, yuvBits, true, true>(width, height, bytesPerPixel, rgb.data() + alphaOffset, stride, a0.data(), strideA);
+  std::vector<uint8_t> rgb0(rgb.data(), rgb.data() + stride * height);
+  detail::convertFromYUV<Converter, rgbBits, yuvBits, true, true>(width, height, bytesPerPixel, rgb0.data() + alphaOffset, stride, a0.data(), strideA);
+  for(auto const set : {simd::InstructionSet::SSE41, simd::InstructionSet::AVX2, simd::InstructionSet::NEON}) {
+    simd::useInstructionSet(set);
+    if(simd::instructionSet() != set) {
+      continue;
+    }
+    std::vector<uint8_t> a1(a0.size());
+    ASSERT_TRUE((detail::convertFromRGBWithSIMD<Converter, rgbBits, yuvBits, true, true>(
+        width, height, bytesPerPixel, rgb.data() + alphaOffset, stride, a1.data(), strideA, nullptr, 0, nullptr, 0, false, false)));
+    expectSamplesNear<YUVType>(a0.data(), a1.data(), a0.size(), "A");
+    ASSERT_TRUE((detail::convertFromYUVWithSIMD<Converter, rgbBits, yuvBits, true, true>(
+        width, height, bytesPerPixel, rgb.data() + alphaOffset, stride, a0.data(), strideA, nullptr, 0, nullptr, 0, false, false)));
+    expectSamplesNear<RGBType>(rgb0.data(), rgb.data(), stride * height, "RGBA");
+  }
+  simd::useInstructionSet(simd::detectInstructionSet());
+}
+
+// color/FixedPoint.hpp promises ±1 against the float reference.
+constexpr int kFixedPointTolerance = 1;
+
+template <typename T>
+void expectFixedPointNearFloat(std::vector<uint8_t> const& expected, std::vector<uint8_t> const& actual, char const* name) {
+  ASSERT_EQ(expected.size(), actual.size());
+  auto const* e = reinterpret_cast<T const*>(expected.data());
+  auto const* a = reinterpret_cast<T const*>(actual.data());
+  size_t const count = expected.size() / sizeof(T);
+  size_t differs = 0;
+  for(size_t i = 0; i < count; ++i) {
+    int const diff = std::abs(static_cast<int>(e[i]) - static_cast<int>(a[i]));
+    ASSERT_LE(diff, kFixedPointTolerance) << name << "[" << i << "]";
+    differs += diff != 0 ? 1 : 0;
+  }
+  // Differences only come from values on a rounding boundary.
+  ASSERT_LE(differs * 100, count) << name;
+}
+
+template <avif::img::color::MatrixCoefficients matrix, uint8_t rgbBits, uint8_t yuvBits, bool isFullRange>
+void checkFixedPointIsNearFloat() {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<matrix>;
+  using YUVType = typename color::YUV<yuvBits>::Type;
+  using RGBType = typename color::RGB<rgbBits>::Type;
+  uint32_t const width = 97;
+  uint32_t const height = 61;
+  size_t const stride = width * sizeof(YUVType);
+  auto const src = makeNoiseImage<rgbBits>(PixelOrder::RGB, width, height);
+  std::vector<std::vector<uint8_t>> yuv0(3, std::vector<uint8_t>(stride * height));
+  std::vector<std::vector<uint8_t>> yuv1(3, std::vector<uint8_t>(stride * height));
+  detail::convertFromRGB<Converter, rgbBits, yuvBits, false, isFullRange, false, false, Arithmetic::Float>(
+      width, height, src.bytesPerPixel(), src.data(), src.stride(), yuv0[0].data(), stride, yuv0[1].data(), stride, yuv0[2].data(), stride);
+  detail::convertFromRGB<Converter, rgbBits, yuvBits, false, isFullRange, false, false, Arithmetic::FixedPoint>(
+      width, height, src.bytesPerPixel(), src.data(), src.stride(), yuv1[0].data(), stride, yuv1[1].data(), stride, yuv1[2].data(), stride);
+  for(size_t i = 0; i < 3; ++i) {
+    expectFixedPointNearFloat<YUVType>(yuv0[i], yuv1[i], "YUV");
+  }
+
+  auto const y = makeNoisePlane<yuvBits>(width * height, 1);
+  auto const u = makeNoisePlane<yuvBits>(width * height, 2);
+  auto const v = makeNoisePlane<yuvBits>(width * height, 3);
+  auto rgb0 = Image<rgbBits>::createEmptyImage(PixelOrder::RGB, width, height);
+  auto rgb1 = Image<rgbBits>::createEmptyImage(PixelOrder::RGB, width, height);
+  detail::convertFromYUV<Converter, rgbBits, yuvBits, false, isFullRange, false, false, Arithmetic::Float>(
+      width, height, rgb0.bytesPerPixel(), rgb0.data(), rgb0.stride(), y.data(), stride, u.data(), stride, v.data(), stride);
+  detail::convertFromYUV<Converter, rgbBits, yuvBits, false, isFullRange, false, false, Arithmetic::FixedPoint>(
+      width, height, rgb1.bytesPerPixel(), rgb1.data(), rgb1.stride(), y.data(), stride, u.data(), stride, v.data(), stride);
+  std::vector<uint8_t> const rgbBytes0(rgb0.data(), rgb0.data() + rgb0.stride() * height);
+  std::vector<uint8_t> const rgbBytes1(rgb1.data(), rgb1.data() + rgb1.stride() * height);
+  expectFixedPointNearFloat<RGBType>(rgbBytes0, rgbBytes1, "RGB");
+}
+
+template <avif::img::color::MatrixCoefficients matrix>
+void checkFixedPointIsNearFloat() {
+  checkFixedPointIsNearFloat<matrix, 8, 8, true>();
+  checkFixedPointIsNearFloat<matrix, 8, 8, false>();
+  checkFixedPointIsNearFloat<matrix, 8, 10, true>();
+  checkFixedPointIsNearFloat<matrix, 8, 12, false>();
+  checkFixedPointIsNearFloat<matrix, 16, 8, false>();
+  checkFixedPointIsNearFloat<matrix, 16, 10, true>();
+  checkFixedPointIsNearFloat<matrix, 16, 12, true>();
+  checkFixedPointIsNearFloat<matrix, 16, 12, false>();
+}
+
+}
+
+TEST(ColorTest, SIMDFromRGBMatchesScalar) {
+  using avif::img::PixelOrder;
+  checkFromRGBMatchesScalar<8, 8, true, false, false>(PixelOrder::RGB);
+  checkFromRGBMatchesScalar<8, 8, false, true, false>(PixelOrder::RGBA);
+  checkFromRGBMatchesScalar<8, 8, true, true, true>(PixelOrder::RGB);
+  checkFromRGBMatchesScalar<8, 10, false, true, true>(PixelOrder::RGBA);
+  checkFromRGBMatchesScalar<16, 12, true, false, false>(PixelOrder::RGB);
+  checkFromRGBMatchesScalar<16, 10, false, true, true>(PixelOrder::RGBA);
+  checkFromRGBMatchesScalar<16, 8, true, true, false>(PixelOrder::Mono);
+  checkFromRGBMatchesScalar<8, 12, true, true, true>(PixelOrder::MonoA);
+}
+
+TEST(ColorTest, SIMDToRGBMatchesScalar) {
+  using avif::img::PixelOrder;
+  checkToRGBMatchesScalar<8, 8, true, false, false, false>(PixelOrder::RGB);
+  checkToRGBMatchesScalar<8, 8, false, false, true, false>(PixelOrder::RGBA);
+  checkToRGBMatchesScalar<8, 8, true, false, true, true>(PixelOrder::RGB);
+  checkToRGBMatchesScalar<8, 10, false, false, true, true>(PixelOrder::RGBA);
+  checkToRGBMatchesScalar<16, 12, true, false, false, false>(PixelOrder::RGB);
+  checkToRGBMatchesScalar<16, 10, false, false, true, true>(PixelOrder::RGBA);
+  checkToRGBMatchesScalar<16, 8, true, true, false, false>(PixelOrder::Mono);
+  checkToRGBMatchesScalar<8, 12, false, true, false, false>(PixelOrder::RGB);
+  checkToRGBMatchesScalar<8, 10, true, false, true, true>(PixelOrder::MonoA);
+}
+
+TEST(ColorTest, SIMDAlphaStaysInBuffer) {
+  using avif::img::PixelOrder;
+  checkAlphaStaysInBuffer<8, 8>(PixelOrder::RGBA);
+  checkAlphaStaysInBuffer<8, 10>(PixelOrder::MonoA);
+  checkAlphaStaysInBuffer<16, 12>(PixelOrder::RGBA);
+  checkAlphaStaysInBuffer<16, 8>(PixelOrder::MonoA);
+}
+
+TEST(ColorTest, FixedPointIsNearFloatForEveryMatrix) {
+  using avif::img::color::MatrixCoefficients;
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_IDENTITY>();
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_BT_709>();
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_FCC>();
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_BT_470_B_G>();
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_NSTC>();
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_SMPTE_240>();
+  checkFixedPointIsNearFloat<MatrixCoefficients::MC_BT_2020_NCL>();
+}
+
+TEST(ColorTest, FixedPointIsSelectedPerCall) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  auto src = makeNoiseImage<8>(PixelOrder::RGB, 16, 4);
+  std::vector<uint8_t> y0(16 * 4), y1(16 * 4), y2(16 * 4);
+  FromRGB<Converter, 8, 8, false, true>::toI400(src, y0.data(), 16);
+  FromRGB<Converter, 8, 8, false, true>::toI400(src, y1.data(), 16, ConversionOptions{Arithmetic::FixedPoint});
+  detail::convertFromRGB<Converter, 8, 8, false, true, Arithmetic::FixedPoint>(16, 4, src.bytesPerPixel(), src.data(), src.stride(), y2.data(), 16);
+  ASSERT_EQ(y1, y2);
+  expectFixedPointNearFloat<uint8_t>(y0, y1, "Y");
+}
+
+TEST(ColorTest, LookupTableMatchesFloat) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_2020_NCL>;
+  uint32_t const width = 256;
+  uint32_t const height = 256;
+  // Every (Y, U) and (Y, V) pair appears.
+  std::vector<uint8_t> y(width * height), u(width * height), v(width * height);
+  for(size_t i = 0; i < y.size(); ++i) {
+    y[i] = static_cast<uint8_t>(i / width);
+    u[i] = static_cast<uint8_t>(i % width);
+    v[i] = static_cast<uint8_t>(255 - i % width);
+  }
+  auto check = [&](auto rgbBitsConstant, auto fullRangeConstant, auto monoConstant) {
+    constexpr uint8_t rgbBits = decltype(rgbBitsConstant)::value;
+    constexpr bool isFullRange = decltype(fullRangeConstant)::value;
+    constexpr bool isMonoYUV = decltype(monoConstant)::value;
+    using RGBType = typename color::RGB<rgbBits>::Type;
+    auto dst0 = Image<rgbBits>::createEmptyImage(PixelOrder::RGBA, width, height);
+    auto dst1 = Image<rgbBits>::createEmptyImage(PixelOrder::RGBA, width, height);
+    detail::dispatchFromYUV<Converter, rgbBits, 8, false, isFullRange, isMonoYUV, false, false>(
+        ConversionOptions{Arithmetic::Float}, width, height, dst0.bytesPerPixel(), dst0.data(), dst0.stride(), y.data(), width, u.data(), width, v.data(), width);
+    detail::dispatchFromYUV<Converter, rgbBits, 8, false, isFullRange, isMonoYUV, false, false>(
+        ConversionOptions{Arithmetic::LookupTable}, width, height, dst1.bytesPerPixel(), dst1.data(), dst1.stride(), y.data(), width, u.data(), width, v.data(), width);
+    // The table holds the same floats, added in the same order, so the results are identical.
+    auto const* e = reinterpret_cast<RGBType const*>(dst0.data());
+    auto const* a = reinterpret_cast<RGBType const*>(dst1.data());
+    for(size_t i = 0; i < dst0.stride() * height / sizeof(RGBType); ++i) {
+      ASSERT_EQ(e[i], a[i]) << "RGB[" << i << "]";
+    }
+  };
+  // Compare with the scalar templates.
+  simd::useInstructionSet(simd::InstructionSet::None);
+  check(std::integral_constant<uint8_t, 8>{}, std::true_type{}, std::false_type{});
+  check(std::integral_constant<uint8_t, 8>{}, std::false_type{}, std::false_type{});
+  check(std::integral_constant<uint8_t, 16>{}, std::true_type{}, std::false_type{});
+  check(std::integral_constant<uint8_t, 16>{}, std::false_type{}, std::true_type{});
+  simd::useInstructionSet(simd::detectInstructionSet());
+}
+
+TEST(ColorTest, ParallelConversionMatchesSerial) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  uint32_t const width = 45;
+  uint32_t const height = 101; // Odd, so the last band has a chroma row of its own.
+  size_t const chromaWidth = (width + 1) / 2;
+  size_t const chromaHeight = (height + 1) / 2;
+  auto src = makeNoiseImage<8>(PixelOrder::RGBA, width, height);
+  std::vector<uint8_t> y0(width * height), u0(chromaWidth * chromaHeight), v0(chromaWidth * chromaHeight);
+  std::vector<uint8_t> y1(y0.size()), u1(u0.size()), v1(v0.size());
+  auto rgb0 = Image<8>::createEmptyImage(PixelOrder::RGBA, width, height);
+  auto rgb1 = Image<8>::createEmptyImage(PixelOrder::RGBA, width, height);
+  using From = FromRGB<Converter, 8, 8, false, true>;
+  using To = ToRGB<Converter, 8, 8, false, true>;
+
+  From::toI420(src, y0.data(), width, u0.data(), chromaWidth, v0.data(), chromaWidth);
+  To::fromI420(rgb0, y0.data(), width, u0.data(), chromaWidth, v0.data(), chromaWidth);
+
+  ConversionOptions options;
+  options.threads = 3;
+  From::toI420(src, y1.data(), width, u1.data(), chromaWidth, v1.data(), chromaWidth, options);
+  To::fromI420(rgb1, y1.data(), width, u1.data(), chromaWidth, v1.data(), chromaWidth, options);
+  ASSERT_EQ(y0, y1);
+  ASSERT_EQ(u0, u1);
+  ASSERT_EQ(v0, v1);
+  ASSERT_TRUE(std::equal(rgb0.data(), rgb0.data() + rgb0.stride() * height, rgb1.data()));
+
+  // A caller-provided executor gets the bands.
+  size_t bands = 0;
+  options.threads = 4;
+  options.executor = [&](size_t const count, std::function<void(size_t)> const& task) {
+    bands = count;
+    for(size_t i = count; i > 0; --i) {
+      task(i - 1);
+    }
+  };
+  std::fill(u1.begin(), u1.end(), 0);
+  From::toI420(src, y1.data(), width, u1.data(), chromaWidth, v1.data(), chromaWidth, options);
+  ASSERT_EQ(4, bands);
+  ASSERT_EQ(u0, u1);
+}
+
+TEST(ColorTest, ParallelConversionRethrows) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_SMPTE_YCGCO>;
+  auto src = makeNoiseImage<8>(PixelOrder::RGB, 8, 64);
+  std::vector<uint8_t> y(8 * 64);
+  ConversionOptions options;
+  options.threads = 4;
+  ASSERT_THROW((FromRGB<Converter, 8, 8, false, true>::toI400(src, y.data(), 8, options)), std::logic_error);
+}
+
+TEST(ColorTest, BoxChromaDownsamplingAveragesPixels) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  using From = FromRGB<Converter, 8, 8, false, true>;
+  uint32_t const width = 16;
+  uint32_t const height = 12;
+  size_t const chromaSize = (width / 2) * (height / 2);
+  // A black and red checkerboard averages to flat dark red around every chroma sample position but Colocated.
+  auto checker = Image<8>::createEmptyImage(PixelOrder::RGB, width, height);
+  auto flat = Image<8>::createEmptyImage(PixelOrder::RGB, width, height);
+  for(uint32_t y = 0; y < height; ++y) {
+    for(uint32_t x = 0; x < width; ++x) {
+      checker.data()[y * checker.stride() + x * 3] = (x + y) % 2 == 0 ? 0 : 254;
+      flat.data()[y * flat.stride() + x * 3] = 127;
+    }
+  }
+  std::vector<uint8_t> y(width * height), u0(chromaSize), v0(chromaSize), u1(chromaSize), v1(chromaSize);
+  for(auto const arithmetic : {Arithmetic::Float, Arithmetic::FixedPoint}) {
+    ConversionOptions options;
+    options.arithmetic = arithmetic;
+    From::toI420(flat, y.data(), width, u0.data(), width / 2, v0.data(), width / 2, options);
+    options.chromaDownsampling = ChromaDownsampling::Box;
+    for(auto const position : {ChromaSamplePosition::Unknown, ChromaSamplePosition::Vertical}) {
+      options.chromaSamplePosition = position;
+      From::toI420(checker, y.data(), width, u1.data(), width / 2, v1.data(), width / 2, options);
+      ASSERT_EQ(u0, u1);
+      ASSERT_EQ(v0, v1);
+    }
+  }
+
+  // Flat images stay flat, and bands give the same result.
+  auto noise = makeNoiseImage<8>(PixelOrder::RGBA, 45, 101);
+  size_t const chromaWidth = 23;
+  size_t const noiseChromaSize = chromaWidth * 51;
+  std::vector<uint8_t> ny(45 * 101), nu0(noiseChromaSize), nv0(noiseChromaSize), nu1(noiseChromaSize), nv1(noiseChromaSize);
+  From::toI420(flat, y.data(), width, u0.data(), width / 2, v0.data(), width / 2);
+  for(auto const position : {ChromaSamplePosition::Unknown, ChromaSamplePosition::Vertical, ChromaSamplePosition::Colocated}) {
+    ConversionOptions options;
+    options.chromaDownsampling = ChromaDownsampling::Box;
+    options.chromaSamplePosition = position;
+    From::toI420(flat, y.data(), width, u1.data(), width / 2, v1.data(), width / 2, options);
+    ASSERT_EQ(u0, u1);
+    ASSERT_EQ(v0, v1);
+    From::toI420(noise, ny.data(), 45, nu0.data(), chromaWidth, nv0.data(), chromaWidth, options);
+    options.threads = 3;
+    From::toI420(noise, ny.data(), 45, nu1.data(), chromaWidth, nv1.data(), chromaWidth, options);
+    ASSERT_EQ(nu0, nu1);
+    ASSERT_EQ(nv0, nv1);
+  }
+}
+
+TEST(ColorTest, BilinearChromaUpsamplingInterpolates) {
+  using namespace avif::img;
+  std::vector<uint32_t> scratch(3);
+  std::vector<uint8_t> row(6);
+  // Two rows of three chroma samples for 6x4 pixels.
+  uint8_t const chroma[] = {0, 100, 200, 100, 200, 240};
+  detail::upsampleChroma<8, true, false>(ChromaSamplePosition::Vertical, 6, 2, chroma, 3, 0, scratch, row.data());
+  ASSERT_EQ((std::vector<uint8_t>{0, 50, 100, 150, 200, 200}), row);
+  detail::upsampleChroma<8, true, false>(ChromaSamplePosition::Unknown, 6, 2, chroma, 3, 0, scratch, row.data());
+  ASSERT_EQ((std::vector<uint8_t>{0, 25, 75, 125, 175, 200}), row);
+  detail::upsampleChroma<8, true, true>(ChromaSamplePosition::Colocated, 6, 4, chroma, 3, 1, scratch, row.data());
+  ASSERT_EQ((std::vector<uint8_t>{50, 100, 150, 185, 220, 220}), row);
+  detail::upsampleChroma<8, true, true>(ChromaSamplePosition::Unknown, 6, 4, chroma, 3, 2, scratch, row.data());
+  ASSERT_EQ((std::vector<uint8_t>{75, 100, 150, 189, 216, 230}), row);
+}
+
+TEST(ColorTest, BilinearChromaUpsamplingKeepsFlatChroma) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_BT_709>;
+  using To = ToRGB<Converter, 8, 10, false, false>;
+  uint32_t const width = 45;
+  uint32_t const height = 101;
+  size_t const chromaWidth = 23;
+  auto y = makeNoisePlane<10>(width * height, 1);
+  std::vector<uint16_t> u(chromaWidth * 51, 300), v(chromaWidth * 51, 700);
+  auto rgb0 = Image<8>::createEmptyImage(PixelOrder::RGBA, width, height);
+  auto rgb1 = Image<8>::createEmptyImage(PixelOrder::RGBA, width, height);
+  auto rgb2 = Image<8>::createEmptyImage(PixelOrder::RGBA, width, height);
+  auto* const pu = reinterpret_cast<uint8_t*>(u.data());
+  auto* const pv = reinterpret_cast<uint8_t*>(v.data());
+  To::fromI420(rgb0, y.data(), width * 2, pu, chromaWidth * 2, pv, chromaWidth * 2);
+  for(auto const position : {ChromaSamplePosition::Unknown, ChromaSamplePosition::Vertical, ChromaSamplePosition::Colocated}) {
+    ConversionOptions options;
+    options.chromaUpsampling = ChromaUpsampling::Bilinear;
+    options.chromaSamplePosition = position;
+    To::fromI420(rgb1, y.data(), width * 2, pu, chromaWidth * 2, pv, chromaWidth * 2, options);
+    options.threads = 3;
+    To::fromI420(rgb2, y.data(), width * 2, pu, chromaWidth * 2, pv, chromaWidth * 2, options);
+    ASSERT_TRUE(std::equal(rgb0.data(), rgb0.data() + rgb0.stride() * height, rgb1.data()));
+    ASSERT_TRUE(std::equal(rgb0.data(), rgb0.data() + rgb0.stride() * height, rgb2.data()));
+  }
+}
+
+TEST(ColorTest, SIMDIsNotUsedForIdentityMatrix) {
+  using namespace avif::img;
+  using Converter = color::ColorConverter<color::MatrixCoefficients::MC_IDENTITY>;
+  uint8_t y = 0;
+  ASSERT_FALSE((detail::convertFromRGBWithSIMD<Converter, 8, 8, false, true>(0, 0, 3, nullptr, 0, &y, 0, nullptr, 0, nullptr, 0, false, false)));
+}
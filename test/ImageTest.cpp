@@ -0,0 +1,103 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <cstdint>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include "../src/avif/img/Image.hpp"
+
+TEST(ImageTest, DefaultPolicyKeepsPackedZeros) {
+  using namespace avif::img;
+  auto const img = Image<8>::createEmptyImage(PixelOrder::RGB, 5, 3);
+  ASSERT_EQ(15u, img.stride());
+  ASSERT_TRUE(std::all_of(img.data(), img.data() + img.stride() * img.height(), [](uint8_t const v) { return v == 0; }));
+}
+
+TEST(ImageTest, AlignedRowsArePadded) {
+  using namespace avif::img;
+  auto img = Image<16>::createEmptyImage(PixelOrder::RGBA, 5, 3, AllocationPolicy::uninitialized());
+  ASSERT_EQ(64u, img.stride());
+  ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(img.data()) % 64u);
+  std::fill_n(img.data(), img.stride() * img.height(), static_cast<uint8_t>(7));
+  // Copies are deep, and keep the layout.
+  auto const copy = img;
+  ASSERT_NE(img.data(), copy.data());
+  ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(copy.data()) % 64u);
+  ASSERT_TRUE(std::equal(img.data(), img.data() + img.stride() * img.height(), copy.data()));
+  ASSERT_THROW(Image<8>::createEmptyImage(PixelOrder::RGB, 5, 3, AllocationPolicy{true, 3, false}), std::invalid_argument);
+}
+
+TEST(ImageTest, PooledBuffersAreRecycled) {
+  using namespace avif::img;
+  BufferPool::clear();
+  AllocationPolicy policy = AllocationPolicy::uninitialized();
+  policy.pooled = true;
+  uint8_t const* first = nullptr;
+  {
+    auto const img = Image<8>::createEmptyImage(PixelOrder::RGBA, 64, 64, policy);
+    first = img.data();
+    ASSERT_EQ(0u, BufferPool::size());
+  }
+  ASSERT_EQ(1u, BufferPool::size());
+  {
+    // Another size does not take it.
+    auto const other = Image<8>::createEmptyImage(PixelOrder::RGBA, 32, 64, policy);
+    ASSERT_EQ(1u, BufferPool::size());
+  }
+  ASSERT_EQ(2u, BufferPool::size());
+  {
+    policy.zeroFill = true;
+    auto const img = Image<8>::createEmptyImage(PixelOrder::RGBA, 64, 64, policy);
+    ASSERT_EQ(first, img.data());
+    ASSERT_TRUE(std::all_of(img.data(), img.data() + img.stride() * img.height(), [](uint8_t const v) { return v == 0; }));
+  }
+  BufferPool::clear();
+  ASSERT_EQ(0u, BufferPool::size());
+}
+
+TEST(ImageTest, MovedFromBuffersAreEmpty) {
+  using namespace avif::img;
+  for(auto const& buffer : {PixelBuffer(std::vector<uint8_t>(16)), PixelBuffer::allocate(16, AllocationPolicy::uninitialized())}) {
+    auto src = buffer;
+    auto dst = std::move(src);
+    ASSERT_EQ(16u, dst.size());
+    ASSERT_EQ(0u, src.size());
+    ASSERT_TRUE(src.empty());
+    PixelBuffer assigned;
+    assigned = std::move(dst);
+    ASSERT_EQ(16u, assigned.size());
+    ASSERT_TRUE(dst.empty());
+  }
+}
+
+TEST(ImageTest, ViewsSharePixels) {
+  using namespace avif::img;
+  Image<8> view;
+  {
+    auto img = Image<8>::createEmptyImage(PixelOrder::MonoA, 10, 6);
+    for(size_t i = 0; i < img.stride() * img.height(); ++i) {
+      img.data()[i] = static_cast<uint8_t>(i);
+    }
+    view = img.view(3, 2, 4, 3);
+    ASSERT_TRUE(view.isView());
+    ASSERT_FALSE(img.isView());
+    ASSERT_EQ(img.stride(), view.stride());
+    ASSERT_EQ(img.data() + img.stride() * 2 + 3 * 2, view.data());
+    view.data()[0] = 0xff;
+    ASSERT_EQ(0xff, img.data()[img.stride() * 2 + 3 * 2]);
+    // Views of views stay in the original image.
+    ASSERT_EQ(img.data() + img.stride() * 3 + 4 * 2, view.view(1, 1, 2, 2).data());
+    ASSERT_THROW(img.view(7, 0, 4, 1), std::out_of_range);
+  }
+  // The parent is gone, but its pixels are not.
+  ASSERT_EQ(0xff, view.data()[0]);
+  ASSERT_EQ(static_cast<uint8_t>(20 * 4 + 3 * 2 + 1), view.data()[view.stride() * 2 + 1]);
+  // Copies are packed images of their own.
+  auto const copy = view;
+  ASSERT_FALSE(copy.isView());
+  ASSERT_EQ(8u, copy.stride());
+  for(size_t y = 0; y < view.height(); ++y) {
+    ASSERT_TRUE(std::equal(view.data() + view.stride() * y, view.data() + view.stride() * y + 8, copy.data() + copy.stride() * y));
+  }
+}
@@ -0,0 +1,247 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <memory>
+#include <gtest/gtest.h>
+#include "../src/avif/Parser.hpp"
+#include "../src/avif/IncrementalParser.hpp"
+#include "../src/avif/Query.hpp"
+#include "../src/avif/util/FileLogger.hpp"
+#include "SampleFile.hpp"
+
+namespace {
+
+avif::util::FileLogger& logger() {
+  static avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::WARN);
+  return log;
+}
+
+}
+
+TEST(ParserTest, ParseWrittenFile) {
+  using avif::Parser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  std::vector<uint8_t> data = avif::test::writeFileBox(logger(), fileBox);
+
+  Parser parser(logger(), data.data(), data.size());
+  std::shared_ptr<Parser::Result> result = parser.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(data.data(), result->buffer().data());
+  auto ispe = avif::util::query::findProperty<avif::ImageSpatialExtentsProperty>(result->fileBox(), 1);
+  ASSERT_TRUE(ispe.has_value());
+  ASSERT_EQ(640, ispe->imageWidth);
+  ASSERT_EQ(480, ispe->imageHeight);
+}
+
+TEST(ParserTest, ProbeWithPrefix) {
+  using avif::Parser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  std::vector<uint8_t> data = avif::test::writeFileBox(logger(), fileBox);
+  size_t const metaEnd = fileBox.metaBox.hdr.end();
+
+  size_t prefixSize = 16;
+  std::shared_ptr<Parser::ProbeResult> result;
+  for(int i = 0; i < 4; ++i) {
+    result = Parser::probe(logger(), avif::util::Buffer(data.data(), prefixSize));
+    if(!result->needsMoreData()) {
+      break;
+    }
+    ASSERT_GT(result->requiredSize(), prefixSize);
+    ASSERT_LE(result->requiredSize(), metaEnd);
+    prefixSize = result->requiredSize();
+  }
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(metaEnd, prefixSize);
+  ASSERT_EQ("avif", result->fileBox().fileTypeBox.majorBrand);
+  auto ispe = avif::util::query::findProperty<avif::ImageSpatialExtentsProperty>(result->fileBox(), 1);
+  ASSERT_TRUE(ispe.has_value());
+  ASSERT_EQ(640, ispe->imageWidth);
+}
+
+TEST(ParserTest, ProbeSkipsMediaDataBeforeMeta) {
+  using avif::Parser;
+  auto fileBox = avif::test::makeSampleFileBox(320, 240, 100);
+  std::vector<uint8_t> const written = avif::test::writeFileBox(logger(), fileBox);
+  auto const& ftyp = fileBox.fileTypeBox.hdr;
+  auto const& meta = fileBox.metaBox.hdr;
+
+  // ftyp, mdat, meta
+  uint32_t const mdatSize = 1u << 20u;
+  std::vector<uint8_t> data(std::next(written.begin(), ftyp.offset), std::next(written.begin(), ftyp.end()));
+  data.insert(data.end(), {
+      static_cast<uint8_t>(mdatSize >> 24u), static_cast<uint8_t>(mdatSize >> 16u),
+      static_cast<uint8_t>(mdatSize >> 8u), static_cast<uint8_t>(mdatSize >> 0u),
+      'm', 'd', 'a', 't'});
+  data.resize(data.size() + mdatSize - 8);
+  data.insert(data.end(), std::next(written.begin(), meta.offset), std::next(written.begin(), meta.end()));
+
+  size_t bytesRead = 0;
+  auto result = Parser::probe(logger(), [&](size_t const offset, size_t const size, uint8_t* const dst) -> size_t {
+    if(offset >= data.size()) {
+      return 0;
+    }
+    size_t const len = std::min(size, data.size() - offset);
+    std::copy(std::next(data.begin(), offset), std::next(data.begin(), offset + len), dst);
+    bytesRead += len;
+    return len;
+  });
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_LT(bytesRead, 1024);
+  ASSERT_EQ(1, result->fileBox().mediaDataBoxes.size());
+  ASSERT_EQ(ftyp.size, result->fileBox().mediaDataBoxes.at(0).hdr.offset);
+  ASSERT_EQ(ftyp.size + mdatSize, result->fileBox().metaBox.hdr.offset);
+  auto ispe = avif::util::query::findProperty<avif::ImageSpatialExtentsProperty>(result->fileBox(), 1);
+  ASSERT_TRUE(ispe.has_value());
+  ASSERT_EQ(240, ispe->imageHeight);
+}
+
+TEST(ParserTest, ProbeDoesNotTrustBoxSize) {
+  using avif::Parser;
+  auto fileBox = avif::test::makeSampleFileBox(320, 240, 100);
+  std::vector<uint8_t> data = avif::test::writeFileBox(logger(), fileBox);
+  size_t const metaOffset = fileBox.metaBox.hdr.offset;
+  // 'meta' claiming almost 4 GiB, in a file far smaller than that.
+  std::fill_n(std::next(data.begin(), static_cast<ptrdiff_t>(metaOffset)), 4, 0xff);
+
+  size_t largestRead = 0;
+  auto result = Parser::probe(logger(), [&](size_t const offset, size_t const size, uint8_t* const dst) -> size_t {
+    largestRead = std::max(largestRead, size);
+    if(offset >= data.size()) {
+      return 0;
+    }
+    size_t const len = std::min(size, data.size() - offset);
+    std::copy(std::next(data.begin(), offset), std::next(data.begin(), offset + len), dst);
+    return len;
+  });
+  ASSERT_TRUE(result->needsMoreData());
+  ASSERT_EQ(metaOffset + 0xffffffffu, result->requiredSize());
+  ASSERT_LE(largestRead, 64u * 1024u);
+}
+
+namespace {
+
+struct RecordingListener final : public avif::IncrementalParser::Listener {
+  std::vector<std::string> events;
+  void onFileTypeBox(avif::FileTypeBox const& box) override { events.emplace_back("ftyp:" + box.majorBrand); }
+  void onMetaBox(avif::MetaBox const& /* box */) override { events.emplace_back("meta"); }
+  void onItemLocationBox(avif::ItemLocationBox const& box) override { events.emplace_back("iloc:" + std::to_string(box.items.size())); }
+  void onMediaDataBox(avif::MediaDataBox const& box) override { events.emplace_back("mdat:" + std::to_string(box.size)); }
+};
+
+}
+
+TEST(ParserTest, IncrementalParserEmitsEventsPerBox) {
+  using avif::IncrementalParser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  std::vector<uint8_t> const data = avif::test::writeFileBox(logger(), fileBox);
+
+  RecordingListener listener;
+  IncrementalParser parser(logger(), listener);
+  size_t const chunk = 7;
+  for(size_t offset = 0; offset < data.size(); offset += chunk) {
+    ASSERT_TRUE(parser.feed(data.data() + offset, std::min(chunk, data.size() - offset))) << parser.error();
+    if(offset + chunk < fileBox.metaBox.hdr.end()) {
+      ASSERT_LE(listener.events.size(), 1);
+    }
+  }
+  ASSERT_TRUE(parser.finish()) << parser.error();
+  ASSERT_EQ((std::vector<std::string>{"ftyp:avif", "meta", "iloc:1", "mdat:100"}), listener.events);
+  ASSERT_EQ(data.size(), parser.consumed());
+  ASSERT_EQ(fileBox.mediaDataBoxes.at(0).offset, parser.fileBox().mediaDataBoxes.at(0).offset);
+  auto ispe = avif::util::query::findProperty<avif::ImageSpatialExtentsProperty>(parser.fileBox(), 1);
+  ASSERT_TRUE(ispe.has_value());
+  ASSERT_EQ(480, ispe->imageHeight);
+}
+
+TEST(ParserTest, IncrementalParserRejectsBrokenStream) {
+  using avif::IncrementalParser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  std::vector<uint8_t> const data = avif::test::writeFileBox(logger(), fileBox);
+  {
+    RecordingListener listener;
+    IncrementalParser parser(logger(), listener);
+    ASSERT_TRUE(parser.feed(data.data(), data.size() - 1));
+    ASSERT_FALSE(parser.finish());
+  }
+  {
+    std::vector<uint8_t> broken = data;
+    broken[3] = 4; // ftyp with size = 4
+    RecordingListener listener;
+    IncrementalParser parser(logger(), listener);
+    ASSERT_FALSE(parser.feed(broken.data(), broken.size()));
+    ASSERT_FALSE(parser.ok());
+    ASSERT_TRUE(listener.events.empty());
+  }
+}
+
+TEST(ParserTest, IncrementalParserReportsTruncatedHeader) {
+  using avif::IncrementalParser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  std::vector<uint8_t> const data = avif::test::writeFileBox(logger(), fileBox);
+  size_t const metaOffset = fileBox.metaBox.hdr.offset;
+
+  RecordingListener listener;
+  IncrementalParser parser(logger(), listener);
+  ASSERT_TRUE(parser.feed(data.data(), metaOffset + 3));
+  ASSERT_FALSE(parser.finish());
+  // Not the 'ftyp' before it, which is complete.
+  ASSERT_EQ(std::string::npos, parser.error().find("ftyp")) << parser.error();
+  ASSERT_NE(std::string::npos, parser.error().find(std::to_string(metaOffset))) << parser.error();
+}
+
+TEST(ParserTest, IncrementalParserLimitsBuffering) {
+  using avif::IncrementalParser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  std::vector<uint8_t> const data = avif::test::writeFileBox(logger(), fileBox);
+  size_t const metaSize = fileBox.metaBox.hdr.size;
+  {
+    RecordingListener listener;
+    IncrementalParser parser(logger(), listener, metaSize);
+    ASSERT_TRUE(parser.feed(data.data(), data.size())) << parser.error();
+    ASSERT_TRUE(parser.finish()) << parser.error();
+  }
+  {
+    RecordingListener listener;
+    IncrementalParser parser(logger(), listener, metaSize - 1);
+    ASSERT_FALSE(parser.feed(data.data(), data.size()));
+    ASSERT_EQ((std::vector<std::string>{"ftyp:avif"}), listener.events);
+  }
+  {
+    // A 'meta' lasting until the end of file is cut off as it grows.
+    std::vector<uint8_t> untilEnd(data.begin(), std::next(data.begin(), static_cast<ptrdiff_t>(fileBox.metaBox.hdr.end())));
+    size_t const sizeAt = fileBox.metaBox.hdr.offset;
+    std::fill_n(std::next(untilEnd.begin(), static_cast<ptrdiff_t>(sizeAt)), 4, 0);
+    untilEnd.resize(untilEnd.size() + 4096);
+    RecordingListener listener;
+    IncrementalParser parser(logger(), listener, metaSize + 1024);
+    ASSERT_FALSE(parser.feed(untilEnd.data(), untilEnd.size()));
+    ASSERT_NE(std::string::npos, parser.error().find("limit")) << parser.error();
+  }
+}
+
+TEST(ParserTest, ICCProfileRefersToParsedBuffer) {
+  using avif::Parser;
+  auto fileBox = avif::test::makeSampleFileBox(640, 480, 100);
+  avif::ColourInformationBox colr{};
+  std::vector<uint8_t> const icc(4096, 0x5a);
+  colr.profile = avif::ColourInformationBox::UnrestrictedICC{icc};
+  fileBox.metaBox.itemPropertiesBox.propertyContainers.properties.emplace_back(colr);
+  fileBox.metaBox.itemPropertiesBox.associations.at(0).items.at(0).entries.emplace_back(
+      avif::ItemPropertyAssociation::Item::Entry{true, 2});
+  std::vector<uint8_t> data = avif::test::writeFileBox(logger(), fileBox);
+
+  std::shared_ptr<Parser::Result> result = Parser(logger(), std::move(data)).parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  auto parsed = avif::util::query::findProperty<avif::ColourInformationBox>(result->fileBox(), 1);
+  ASSERT_TRUE(parsed.has_value());
+  auto const& payload = std::get<avif::ColourInformationBox::UnrestrictedICC>(parsed->profile).payload;
+  ASSERT_EQ(icc, payload.toVector());
+  ASSERT_GE(payload.data(), result->buffer().begin());
+  ASSERT_LE(payload.end(), result->buffer().end());
+  // The view keeps the storage alive after the result is gone.
+  result.reset();
+  ASSERT_TRUE(payload.owned());
+  ASSERT_EQ(0x5a, payload[4095]);
+}
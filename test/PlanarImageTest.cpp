@@ -0,0 +1,164 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include "../src/avif/img/Conversion.hpp"
+#include "../src/avif/img/Crop.hpp"
+#include "../src/avif/img/Transform.hpp"
+
+namespace {
+
+using Converter = avif::img::color::ColorConverter<avif::img::color::MatrixCoefficients::MC_BT_709>;
+
+avif::img::Image<8> makeImage(avif::img::PixelOrder const pixelOrder, uint32_t const width, uint32_t const height) {
+  auto img = avif::img::Image<8>::createEmptyImage(pixelOrder, width, height);
+  for(size_t i = 0; i < img.stride() * img.height(); ++i) {
+    img.data()[i] = static_cast<uint8_t>(i * 7u + i / 61u);
+  }
+  return img;
+}
+
+template <size_t bits>
+void expectPlanesEqual(avif::img::PlanarImage<bits> const& expected, avif::img::PlanarImage<bits> const& actual) {
+  using namespace avif::img;
+  ASSERT_EQ(expected.chromaFormat(), actual.chromaFormat());
+  ASSERT_EQ(expected.width(), actual.width());
+  ASSERT_EQ(expected.height(), actual.height());
+  for(Plane const plane : {Plane::Y, Plane::U, Plane::V, Plane::A}) {
+    ASSERT_EQ(expected.data(plane) == nullptr, actual.data(plane) == nullptr);
+    if(expected.data(plane) == nullptr) {
+      continue;
+    }
+    size_t const rowBytes = expected.planeWidth(plane) * sizeof(typename PlanarImage<bits>::Type);
+    for(size_t y = 0; y < expected.planeHeight(plane); ++y) {
+      uint8_t const* e = expected.data(plane) + expected.stride(plane) * y;
+      uint8_t const* a = actual.data(plane) + actual.stride(plane) * y;
+      ASSERT_EQ(std::vector<uint8_t>(e, e + rowBytes), std::vector<uint8_t>(a, a + rowBytes)) << "plane " << static_cast<int>(plane) << ", row " << y;
+    }
+  }
+}
+
+}
+
+TEST(PlanarImageTest, CreateAlignsEveryPlane) {
+  using namespace avif::img;
+  auto img = PlanarImage<10>::create(ChromaFormat::I420, 101, 51, false, true);
+  ASSERT_TRUE(img.ownsData());
+  ASSERT_TRUE(img.hasAlpha());
+  ASSERT_EQ(51u, img.planeWidth(Plane::U));
+  ASSERT_EQ(26u, img.planeHeight(Plane::V));
+  ASSERT_EQ(101u, img.planeWidth(Plane::A));
+  for(Plane const plane : {Plane::Y, Plane::U, Plane::V, Plane::A}) {
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(img.data(plane)) % PlanarImage<10>::defaultAlignment);
+    ASSERT_EQ(0u, img.stride(plane) % PlanarImage<10>::defaultAlignment);
+    ASSERT_LE(img.planeWidth(plane) * sizeof(uint16_t), img.stride(plane));
+  }
+  auto mono = PlanarImage<8>::create(ChromaFormat::I400, 16, 16, true, false, AllocationPolicy{true, 16, false});
+  ASSERT_TRUE(mono.isMonochrome());
+  ASSERT_EQ(nullptr, mono.data(Plane::U));
+  ASSERT_EQ(nullptr, mono.data(Plane::A));
+  ASSERT_EQ(16u, mono.stride(Plane::Y));
+  ASSERT_THROW(PlanarImage<8>::create(ChromaFormat::I400, 16, 16, true, false, AllocationPolicy{true, 24, false}), std::invalid_argument);
+}
+
+TEST(PlanarImageTest, ConversionMatchesRawPlanes) {
+  using namespace avif::img;
+  auto src = makeImage(PixelOrder::RGBA, 67, 35);
+  for(ChromaFormat const format : {ChromaFormat::I400, ChromaFormat::I444, ChromaFormat::I422, ChromaFormat::I420}) {
+    auto planar = PlanarImage<8>::create(format, src.width(), src.height(), false, true);
+    FromRGB<Converter, 8, 8, false, false>::toPlanar(src, planar);
+    FromAlpha<Converter, 8, 8, false>::toPlanar(src, planar);
+
+    // The same conversion into buffers of the caller, wrapped without copies.
+    auto const strideC = planar.planeWidth(Plane::U);
+    std::vector<uint8_t> y(src.width() * src.height()), u(strideC * planar.planeHeight(Plane::U)), v(u.size()), a(y.size());
+    using FromRGB = FromRGB<Converter, 8, 8, false, false>;
+    switch(format) {
+      case ChromaFormat::I400: FromRGB::toI400(src, y.data(), src.width()); break;
+      case ChromaFormat::I444: FromRGB::toI444(src, y.data(), src.width(), u.data(), strideC, v.data(), strideC); break;
+      case ChromaFormat::I422: FromRGB::toI422(src, y.data(), src.width(), u.data(), strideC, v.data(), strideC); break;
+      case ChromaFormat::I420: FromRGB::toI420(src, y.data(), src.width(), u.data(), strideC, v.data(), strideC); break;
+    }
+    FromAlpha<Converter, 8, 8, false>::toI400(src, a.data(), src.width());
+    bool const mono = format == ChromaFormat::I400;
+    auto const wrapped = PlanarImage<8>::wrap(format, src.width(), src.height(), false,
+        {y.data(), mono ? nullptr : u.data(), mono ? nullptr : v.data(), a.data()},
+        {src.width(), mono ? 0 : strideC, mono ? 0 : strideC, src.width()});
+    ASSERT_FALSE(wrapped.ownsData());
+    expectPlanesEqual(wrapped, planar);
+
+    auto dst = Image<8>::createEmptyImage(PixelOrder::RGBA, src.width(), src.height());
+    auto expected = Image<8>::createEmptyImage(PixelOrder::RGBA, src.width(), src.height());
+    ToRGB<Converter, 8, 8, false, false>::fromPlanar(dst, planar);
+    ToAlpha<Converter, 8, 8, false>::fromPlanar(dst, planar);
+    ToRGB<Converter, 8, 8, false, false>::fromPlanar(expected, wrapped);
+    ToAlpha<Converter, 8, 8, false>::fromI400(expected, a.data(), src.width());
+    ASSERT_EQ(std::vector<uint8_t>(expected.data(), expected.data() + expected.stride() * expected.height()),
+              std::vector<uint8_t>(dst.data(), dst.data() + dst.stride() * dst.height()));
+  }
+}
+
+TEST(PlanarImageTest, ConversionChecksRangeAndSize) {
+  using namespace avif::img;
+  auto src = makeImage(PixelOrder::RGB, 8, 8);
+  auto full = PlanarImage<8>::create(ChromaFormat::I420, 8, 8, true, false);
+  ASSERT_THROW((FromRGB<Converter, 8, 8, false, false>::toPlanar(src, full)), std::invalid_argument);
+  auto small = PlanarImage<8>::create(ChromaFormat::I420, 4, 8, false, false);
+  ASSERT_THROW((FromRGB<Converter, 8, 8, false, false>::toPlanar(src, small)), std::invalid_argument);
+  auto limited = PlanarImage<8>::create(ChromaFormat::I420, 8, 8, false, false);
+  ASSERT_THROW((FromAlpha<Converter, 8, 8, false>::toPlanar(src, limited)), std::domain_error);
+}
+
+TEST(PlanarImageTest, CropMatchesView) {
+  using namespace avif::img;
+  auto src = makeImage(PixelOrder::RGB, 40, 30);
+  auto planar = PlanarImage<8>::create(ChromaFormat::I420, 40, 30, true, false);
+  FromRGB<Converter, 8, 8, false, true>::toPlanar(src, planar);
+
+  // 20x10 at (6, 4).
+  avif::CleanApertureBox clap{};
+  clap.cleanApertureWidthN = 20;
+  clap.cleanApertureWidthD = 1;
+  clap.cleanApertureHeightN = 10;
+  clap.cleanApertureHeightD = 1;
+  clap.horizOffN = -4;
+  clap.horizOffD = 1;
+  clap.vertOffN = -6;
+  clap.vertOffD = 1;
+  auto const cropped = crop(planar, clap);
+  ASSERT_TRUE(cropped.ownsData());
+  expectPlanesEqual(planar.view(6, 4, 20, 10), cropped);
+
+  clap.horizOffN = -3;
+  ASSERT_THROW(crop(planar, clap), std::domain_error);
+  ASSERT_THROW(planar.view(5, 4, 20, 10), std::domain_error);
+  ASSERT_THROW(planar.view(30, 4, 20, 10), std::out_of_range);
+  // The sums would wrap around in 32 bits.
+  ASSERT_THROW(planar.view(UINT32_MAX - 1, 4, 20, 10), std::out_of_range);
+  ASSERT_THROW(planar.view(6, UINT32_MAX - 1, 20, 10), std::out_of_range);
+}
+
+TEST(PlanarImageTest, TransformMatchesImage) {
+  using namespace avif::img;
+  auto src = makeImage(PixelOrder::RGB, 23, 17);
+  auto planar = PlanarImage<8>::create(ChromaFormat::I444, 23, 17, true, false);
+  FromRGB<Converter, 8, 8, false, true>::toPlanar(src, planar);
+  for(auto const rotation : {avif::ImageRotationBox::Rotation::Rot90, avif::ImageRotationBox::Rotation::Rot180, avif::ImageRotationBox::Rotation::Rot270}) {
+    auto const rotated = rotate(src, rotation);
+    auto expected = PlanarImage<8>::create(ChromaFormat::I444, rotated.width(), rotated.height(), true, false);
+    FromRGB<Converter, 8, 8, false, true>::toPlanar(rotated, expected);
+    expectPlanesEqual(expected, rotate(planar, rotation));
+  }
+  {
+    auto const flipped = flip(src, avif::ImageMirrorBox::Axis::Vertical);
+    auto expected = PlanarImage<8>::create(ChromaFormat::I444, 23, 17, true, false);
+    FromRGB<Converter, 8, 8, false, true>::toPlanar(flipped, expected);
+    expectPlanesEqual(expected, flip(planar, avif::ImageMirrorBox::Axis::Vertical));
+  }
+  auto const i422 = PlanarImage<8>::create(ChromaFormat::I422, 24, 16, true, false);
+  ASSERT_THROW(rotate(i422, avif::ImageRotationBox::Rotation::Rot90), std::domain_error);
+  ASSERT_EQ(12u, rotate(i422, avif::ImageRotationBox::Rotation::Rot180).planeWidth(Plane::U));
+}
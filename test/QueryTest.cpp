@@ -0,0 +1,180 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <gtest/gtest.h>
+#include "../src/avif/ItemIndex.hpp"
+#include "../src/avif/Parser.hpp"
+#include "../src/avif/Query.hpp"
+#include "../src/avif/util/FourCC.hpp"
+#include "../src/avif/util/FileLogger.hpp"
+#include "SampleFile.hpp"
+
+namespace {
+
+avif::util::FileLogger& logger() {
+  static avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::WARN);
+  return log;
+}
+
+// Item 1 is the color image, item 7 is its alpha plane (auxl) and item 3 is a thumbnail (thmb).
+// The thumbnail refers to item 1 too, and it has an auxC of the other type.
+avif::FileBox makeFileBoxWithAuxItems() {
+  using namespace avif;
+  FileBox fileBox = avif::test::makeSampleFileBox(64, 64, 100);
+  auto& props = fileBox.metaBox.itemPropertiesBox.propertyContainers.properties;
+  AuxiliaryTypeProperty depth{};
+  depth.auxType = "urn:mpeg:hevc:2015:auxid:2";
+  props.emplace_back(depth); // 2
+  AuxiliaryTypeProperty alpha{};
+  alpha.auxType = "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha";
+  props.emplace_back(alpha); // 3
+  auto& items = fileBox.metaBox.itemPropertiesBox.associations.at(0).items;
+  items.emplace_back(ItemPropertyAssociation::Item{7, {{true, 1}, {true, 3}}});
+  items.emplace_back(ItemPropertyAssociation::Item{3, {{false, 0}, {true, 2}}});
+  fileBox.metaBox.itemLocationBox.items.emplace_back(ItemLocationBox::Item{7, 0, 0, 10, {ItemLocationBox::Item::Extent{0, 20, 30}}});
+
+  ItemReferenceBox iref{};
+  SingleItemTypeReferenceBox thmb{};
+  thmb.hdr.type = util::str2uint("thmb");
+  thmb.fromItemID = 3;
+  thmb.toItemIDs = {1};
+  SingleItemTypeReferenceBox auxl{};
+  auxl.hdr.type = util::str2uint("auxl");
+  auxl.fromItemID = 7;
+  auxl.toItemIDs = {1};
+  iref.references = std::vector<SingleItemTypeReferenceBox>{thmb, auxl};
+  fileBox.metaBox.itemReferenceBox = iref;
+  return fileBox;
+}
+
+}
+
+TEST(QueryTest, ItemIndexSortsItems) {
+  avif::FileBox const fileBox = makeFileBoxWithAuxItems();
+  avif::ItemIndex const index(fileBox);
+  ASSERT_EQ(3, index.entries().size());
+  ASSERT_EQ(1, index.entries().at(0).itemID);
+  ASSERT_EQ(3, index.entries().at(1).itemID);
+  ASSERT_EQ(7, index.entries().at(2).itemID);
+  ASSERT_EQ(nullptr, index.find(2));
+  ASSERT_NE(nullptr, index.find(1)->info);
+  ASSERT_EQ(nullptr, index.find(7)->info);
+  ASSERT_EQ(&fileBox.metaBox.itemLocationBox.items.at(1), index.find(7)->location);
+  ASSERT_EQ(2, index.properties(7).size());
+  ASSERT_EQ(1, index.properties(3).size());
+  ASSERT_EQ(2, index.incomingReferences(1).size());
+  ASSERT_EQ(1, index.outgoingReferences(7).size());
+  ASSERT_EQ(avif::util::str2uint("auxl"), index.outgoingReferences(7).begin()->type);
+  ASSERT_TRUE(index.outgoingReferences(1).empty());
+}
+
+TEST(QueryTest, FindAuxItemChecksPropertiesOfReferringItem) {
+  avif::FileBox const fileBox = makeFileBoxWithAuxItems();
+  avif::ItemIndex const index(fileBox);
+  using avif::util::query::findAuxItemID;
+  ASSERT_EQ(7, findAuxItemID(index, 1, "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha"));
+  ASSERT_EQ(3, findAuxItemID(fileBox, 1, "urn:mpeg:hevc:2015:auxid:2"));
+  ASSERT_FALSE(findAuxItemID(index, 7, "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha").has_value());
+}
+
+TEST(QueryTest, FindItemRegionByItemID) {
+  avif::FileBox const fileBox = makeFileBoxWithAuxItems();
+  auto const region = avif::util::query::findItemRegion(fileBox, 7);
+  ASSERT_EQ(30, region.first);
+  ASSERT_EQ(60, region.second);
+  ASSERT_THROW(avif::util::query::findItemRegion(fileBox, 2), std::out_of_range);
+  auto const ispe = avif::util::query::findProperty<avif::ImageSpatialExtentsProperty>(avif::ItemIndex(fileBox), 7);
+  ASSERT_TRUE(ispe.has_value());
+  ASSERT_EQ(64, ispe->imageWidth);
+}
+
+TEST(QueryTest, ItemIndexSkipsPropertiesOutOfContainer) {
+  avif::FileBox fileBox = makeFileBoxWithAuxItems();
+  auto& items = fileBox.metaBox.itemPropertiesBox.associations.at(0).items;
+  // Item 3 refers to a property 'ipco' does not have, item 7 to another one and marks it essential.
+  items.at(2).entries.emplace_back(avif::ItemPropertyAssociation::Item::Entry{false, 100});
+  items.at(1).entries.insert(items.at(1).entries.begin(), avif::ItemPropertyAssociation::Item::Entry{true, 4});
+  avif::ItemIndex const index(fileBox);
+  ASSERT_EQ(0, index.find(1)->invalidProperties);
+  ASSERT_EQ(1, index.find(3)->invalidProperties);
+  ASSERT_FALSE(index.find(3)->invalidEssentialProperty);
+  ASSERT_EQ(1, index.properties(3).size());
+  ASSERT_EQ(1, index.find(7)->invalidProperties);
+  ASSERT_TRUE(index.find(7)->invalidEssentialProperty);
+  ASSERT_EQ(2, index.properties(7).size());
+
+  using avif::util::query::findAuxItemID;
+  using avif::util::query::findItemRegion;
+  using avif::util::query::findPrimaryItemID;
+  using avif::util::query::findProperty;
+  // Item 7 must not be processed, so it is not the alpha plane of item 1 any more.
+  ASSERT_FALSE(findAuxItemID(index, 1, "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha").has_value());
+  ASSERT_FALSE(findAuxItemID(fileBox, 1, "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha").has_value());
+  ASSERT_EQ(3, findAuxItemID(index, 1, "urn:mpeg:hevc:2015:auxid:2"));
+  ASSERT_EQ(3, findAuxItemID(fileBox, 1, "urn:mpeg:hevc:2015:auxid:2"));
+  ASSERT_TRUE(findProperty<avif::ImageSpatialExtentsProperty>(fileBox, 7).has_value());
+  ASSERT_FALSE(findProperty<avif::ImageSpatialExtentsProperty>(fileBox, 3).has_value());
+  ASSERT_EQ(64, findProperty<avif::ImageSpatialExtentsProperty>(fileBox, std::nullopt)->imageWidth);
+
+  // Same for the primary item, and for the item findItemRegion picks.
+  ASSERT_EQ(1, findPrimaryItemID(index));
+  ASSERT_EQ(findItemRegion(fileBox, 1), findItemRegion(index, std::nullopt));
+  ASSERT_EQ(findItemRegion(fileBox, 1), findItemRegion(fileBox, std::nullopt));
+  items.at(0).entries.emplace_back(avif::ItemPropertyAssociation::Item::Entry{true, 100});
+  avif::ItemIndex const broken(fileBox);
+  ASSERT_FALSE(findPrimaryItemID(broken).has_value());
+  ASSERT_FALSE(findPrimaryItemID(fileBox).has_value());
+  // Item 7 is out too, and item 3 has no location.
+  ASSERT_THROW(findItemRegion(broken, std::nullopt), std::out_of_range);
+  ASSERT_THROW(findItemRegion(fileBox, std::nullopt), std::out_of_range);
+}
+
+TEST(QueryTest, CopyItemWithMultipleExtentsAndItemData) {
+  using namespace avif;
+  FileBox fileBox = avif::test::makeSampleFileBox(64, 64, 100);
+  ItemLocationBox& iloc = fileBox.metaBox.itemLocationBox;
+  iloc.setFullBoxHeader(1, 0);
+  // Item 9 is split into two extents in mdat, in reverse order.
+  iloc.items.at(0).itemID = 9;
+  iloc.items.at(0).extents = {ItemLocationBox::Item::Extent{0, 50, 50}, ItemLocationBox::Item::Extent{0, 0, 50}};
+  // Item 5 is in idat.
+  iloc.items.emplace_back(ItemLocationBox::Item{5, 1, 0, 0, {ItemLocationBox::Item::Extent{0, 2, 3}, ItemLocationBox::Item::Extent{0, 0, 2}}});
+  ItemDataBox idat{};
+  idat.data = std::vector<uint8_t>{'a', 'b', 'c', 'd', 'e'};
+  fileBox.metaBox.itemDataBox = idat;
+
+  // Writer leaves the extent offsets to us.
+  {
+    util::StreamWriter out;
+    Writer(logger(), out).write(fileBox);
+  }
+  size_t const mdatOffset = fileBox.mediaDataBoxes.at(0).offset;
+  iloc.items.at(0).extents.at(0).extentOffset += mdatOffset;
+  iloc.items.at(0).extents.at(1).extentOffset += mdatOffset;
+  util::StreamWriter out;
+  Writer(logger(), out).write(fileBox);
+  std::vector<uint8_t> data = out.buffer();
+  for(size_t i = 0; i < 100; ++i) {
+    data.at(mdatOffset + i) = static_cast<uint8_t>(i);
+  }
+
+  std::shared_ptr<Parser::Result> result = Parser(logger(), data.data(), data.size()).parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ItemIndex const index(result->fileBox());
+  using avif::util::query::findItemExtents;
+  using avif::util::query::copyItem;
+  ASSERT_EQ(2, findItemExtents(index, 9).size());
+  ASSERT_EQ(100, avif::util::query::findItemSize(index, 9));
+  std::vector<uint8_t> item(100);
+  ASSERT_EQ(100, copyItem(index, 9, result->buffer(), item.data(), item.size()));
+  ASSERT_EQ(50, item.at(0));
+  ASSERT_EQ(0, item.at(50));
+  ASSERT_THROW((void)copyItem(index, 9, result->buffer(), item.data(), 99), std::out_of_range);
+
+  auto const idatExtents = findItemExtents(index, 5);
+  ASSERT_EQ(result->fileBox().metaBox.itemDataBox->offset + 2, idatExtents.at(0).first);
+  std::vector<uint8_t> small(5);
+  ASSERT_EQ(5, copyItem(index, 5, result->buffer(), small.data(), small.size()));
+  ASSERT_EQ((std::vector<uint8_t>{'c', 'd', 'e', 'a', 'b'}), small);
+}
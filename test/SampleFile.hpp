@@ -0,0 +1,76 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "../src/avif/FileBox.hpp"
+#include "../src/avif/Writer.hpp"
+#include "../src/avif/util/StreamWriter.hpp"
+
+namespace avif::test {
+
+// Builds a minimal still image: ftyp, meta(hdlr, iloc, iinf, pitm, iprp) and one mdat.
+inline avif::FileBox makeSampleFileBox(uint32_t const width, uint32_t const height, size_t const mdatSize) {
+  using namespace avif;
+  FileBox fileBox{};
+  fileBox.fileTypeBox.majorBrand = "avif";
+  fileBox.fileTypeBox.minorVersion = 0;
+  fileBox.fileTypeBox.compatibleBrands = {"avif", "mif1", "miaf"};
+
+  MetaBox& meta = fileBox.metaBox;
+  meta.handlerBox.handler = "pict";
+  meta.handlerBox.name = "libavif-container";
+
+  ItemLocationBox& iloc = meta.itemLocationBox;
+  iloc.offsetSize = 4;
+  iloc.lengthSize = 4;
+  iloc.baseOffsetSize = 0;
+  iloc.indexSize = 0;
+  iloc.items.emplace_back(ItemLocationBox::Item{1, 0, 0, 0, {ItemLocationBox::Item::Extent{0, 0, mdatSize}}});
+
+  ItemInfoEntry infe{};
+  infe.setFullBoxHeader(2, 0);
+  infe.itemID = 1;
+  infe.itemProtectionIndex = 0;
+  infe.itemType = "av01";
+  infe.itemName = "Image";
+  meta.itemInfoBox.itemInfos.emplace_back(infe);
+
+  PrimaryItemBox pitm{};
+  pitm.itemID = 1;
+  meta.primaryItemBox = pitm;
+
+  ImageSpatialExtentsProperty ispe{};
+  ispe.imageWidth = width;
+  ispe.imageHeight = height;
+  meta.itemPropertiesBox.propertyContainers.properties.emplace_back(ispe);
+  ItemPropertyAssociation ipma{};
+  ipma.items.emplace_back(ItemPropertyAssociation::Item{1, {ItemPropertyAssociation::Item::Entry{true, 1}}});
+  meta.itemPropertiesBox.associations.emplace_back(ipma);
+
+  MediaDataBox mdat{};
+  mdat.size = mdatSize;
+  fileBox.mediaDataBoxes.emplace_back(mdat);
+  return fileBox;
+}
+
+// Writer fills box sizes and offsets as it goes, so we have to write twice.
+inline std::vector<uint8_t> writeFileBox(util::Logger& log, avif::FileBox& fileBox) {
+  {
+    util::StreamWriter out;
+    Writer(log, out).write(fileBox);
+  }
+  for(auto& item : fileBox.metaBox.itemLocationBox.items) {
+    for(auto& extent : item.extents) {
+      extent.extentOffset = fileBox.mediaDataBoxes.at(0).offset;
+    }
+  }
+  util::StreamWriter out;
+  Writer(log, out).write(fileBox);
+  return out.buffer();
+}
+
+}
@@ -0,0 +1,148 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include "../src/avif/img/Transform.hpp"
+
+namespace {
+
+template <size_t bits>
+avif::img::Image<bits> makeImage(avif::img::PixelOrder const pixelOrder, uint32_t const width, uint32_t const height) {
+  auto img = avif::img::Image<bits>::createEmptyImage(pixelOrder, width, height);
+  for(size_t i = 0; i < img.stride() * img.height(); ++i) {
+    img.data()[i] = static_cast<uint8_t>(i * 7u + i / 251u);
+  }
+  return img;
+}
+
+// The original per-pixel loop.
+template <size_t bits, typename Trans>
+void expectTransformed(avif::img::Image<bits> const& src, avif::img::Image<bits> const& dst) {
+  Trans trans;
+  size_t const bytesPerPixel = src.bytesPerPixel();
+  for(size_t y = 0; y < dst.height(); ++y) {
+    for(size_t x = 0; x < dst.width(); ++x) {
+      auto const from = trans(src.width(), x, src.height(), y);
+      uint8_t const* srcPixel = src.data() + src.stride() * std::get<1>(from) + bytesPerPixel * std::get<0>(from);
+      uint8_t const* dstPixel = dst.data() + dst.stride() * y + bytesPerPixel * x;
+      ASSERT_TRUE(std::equal(srcPixel, srcPixel + bytesPerPixel, dstPixel)) << "(" << x << ", " << y << ")";
+    }
+  }
+}
+
+template <size_t bits>
+void checkEveryTransform(avif::img::PixelOrder const pixelOrder) {
+  using avif::ImageRotationBox;
+  using avif::ImageMirrorBox;
+  using namespace avif::img;
+  // Spans two tiles each way, with partial 8x8 blocks at the edges.
+  auto const src = makeImage<bits>(pixelOrder, 133, 70);
+  expectTransformed<bits, transform::RotateTrans<ImageRotationBox::Rotation::Rot0>>(src, rotate(src, ImageRotationBox::Rotation::Rot0));
+  expectTransformed<bits, transform::RotateTrans<ImageRotationBox::Rotation::Rot90>>(src, rotate(src, ImageRotationBox::Rotation::Rot90));
+  expectTransformed<bits, transform::RotateTrans<ImageRotationBox::Rotation::Rot180>>(src, rotate(src, ImageRotationBox::Rotation::Rot180));
+  expectTransformed<bits, transform::RotateTrans<ImageRotationBox::Rotation::Rot270>>(src, rotate(src, ImageRotationBox::Rotation::Rot270));
+  expectTransformed<bits, transform::FlipTrans<ImageMirrorBox::Axis::Horizontal>>(src, flip(src, ImageMirrorBox::Axis::Horizontal));
+  expectTransformed<bits, transform::FlipTrans<ImageMirrorBox::Axis::Vertical>>(src, flip(src, ImageMirrorBox::Axis::Vertical));
+}
+
+template <size_t bits>
+void expectSameImage(avif::img::Image<bits> const& expected, avif::img::Image<bits> const& actual) {
+  ASSERT_EQ(expected.width(), actual.width());
+  ASSERT_EQ(expected.height(), actual.height());
+  size_t const rowBytes = expected.width() * expected.bytesPerPixel();
+  for(size_t y = 0; y < expected.height(); ++y) {
+    uint8_t const* e = expected.data() + expected.stride() * y;
+    uint8_t const* a = actual.data() + actual.stride() * y;
+    ASSERT_TRUE(std::equal(e, e + rowBytes, a)) << "row " << y;
+  }
+}
+
+}
+
+TEST(TransformTest, FusedTransformsMatchOneByOne) {
+  using avif::ImageRotationBox;
+  using avif::ImageMirrorBox;
+  using namespace avif::img;
+  auto src = makeImage<8>(PixelOrder::RGB, 37, 22);
+  src.colorProfile().cicp = avif::ColourInformationBox::CICP{9, 16, 9, false};
+  // 9x7 at (11, 10), or at (4, 17) once turned.
+  avif::CleanApertureBox clap{};
+  clap.cleanApertureWidthN = 9;
+  clap.cleanApertureWidthD = 1;
+  clap.cleanApertureHeightN = 7;
+  clap.cleanApertureHeightD = 1;
+  clap.horizOffN = -3;
+  clap.horizOffD = 1;
+  clap.vertOffN = 2;
+  clap.vertOffD = 1;
+  for(auto const angle : {ImageRotationBox::Rotation::Rot0, ImageRotationBox::Rotation::Rot90, ImageRotationBox::Rotation::Rot180, ImageRotationBox::Rotation::Rot270}) {
+    for(auto const axis : {ImageMirrorBox::Axis::Vertical, ImageMirrorBox::Axis::Horizontal}) {
+      SCOPED_TRACE(::testing::Message() << "angle " << static_cast<int>(angle) << ", axis " << static_cast<int>(axis));
+      ImageRotationBox irot{};
+      irot.angle = angle;
+      ImageMirrorBox imir{};
+      imir.axis = axis;
+      expectSameImage(flip(rotate(crop(src, clap), angle), axis), applyTransforms(src, clap, irot, imir));
+      expectSameImage(rotate(crop(src, clap), angle), applyTransforms(src, clap, irot, std::nullopt));
+      // In the order of the properties.
+      std::vector<avif::ItemPropertyContainer::Property> const properties{imir, irot, clap};
+      expectSameImage(crop(rotate(flip(src, axis), angle), clap), applyTransforms(src, properties));
+      ASSERT_EQ(9, applyTransforms(src, clap, irot, imir).colorProfile().cicp.value().colourPrimaries);
+      ASSERT_EQ(16, applyTransforms(src, properties).colorProfile().cicp.value().transferCharacteristics);
+    }
+  }
+  expectSameImage(src, applyTransforms(src, std::nullopt, std::nullopt, std::nullopt));
+  clap.horizOffN = 30;
+  ASSERT_THROW(applyTransforms(src, clap, std::nullopt, std::nullopt), std::out_of_range);
+}
+
+TEST(TransformTest, CropCopiesAndCropViewShares) {
+  using namespace avif::img;
+  auto src = makeImage<8>(PixelOrder::RGBA, 37, 22);
+  avif::CleanApertureBox clap{};
+  clap.cleanApertureWidthN = 9;
+  clap.cleanApertureWidthD = 1;
+  clap.cleanApertureHeightN = 7;
+  clap.cleanApertureHeightD = 1;
+  clap.horizOffN = -3;
+  clap.horizOffD = 1;
+  clap.vertOffN = 2;
+  clap.vertOffD = 1;
+  auto copy = crop(src, clap);
+  auto view = cropView(src, clap);
+  ASSERT_FALSE(copy.isView());
+  ASSERT_TRUE(view.isView());
+  expectSameImage(view, copy);
+  ASSERT_FALSE(applyTransforms(src, clap, std::nullopt, std::nullopt).isView());
+
+  uint8_t const before = view.data()[0];
+  copy.data()[0] = static_cast<uint8_t>(before + 1);
+  ASSERT_EQ(before, view.data()[0]);
+  view.data()[0] = static_cast<uint8_t>(before + 2);
+  ASSERT_EQ(static_cast<uint8_t>(before + 2), src.data()[view.data() - src.data()]);
+}
+
+TEST(TransformTest, EveryPixelOrderAndInstructionSet) {
+  using namespace avif::img;
+  for(auto const set : {simd::InstructionSet::None, simd::InstructionSet::SSE41, simd::detectInstructionSet()}) {
+    simd::useInstructionSet(set);
+    for(auto const pixelOrder : {PixelOrder::Mono, PixelOrder::MonoA, PixelOrder::RGB, PixelOrder::RGBA}) {
+      SCOPED_TRACE(::testing::Message() << "instruction set " << static_cast<int>(set) << ", pixel order " << static_cast<int>(pixelOrder));
+      checkEveryTransform<8>(pixelOrder);
+      checkEveryTransform<16>(pixelOrder);
+    }
+  }
+  simd::useInstructionSet(simd::detectInstructionSet());
+}
+
+TEST(TransformTest, EmptyImage) {
+  using namespace avif::img;
+  auto const src = Image<8>::createEmptyImage(PixelOrder::RGBA, 0, 3);
+  auto const dst = rotate(src, avif::ImageRotationBox::Rotation::Rot90);
+  ASSERT_EQ(3u, dst.width());
+  ASSERT_EQ(0u, dst.height());
+}
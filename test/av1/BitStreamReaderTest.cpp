@@ -0,0 +1,72 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "../../src/avif/av1/BitStreamReader.hpp"
+#include "../../src/avif/util/FileLogger.hpp"
+
+namespace {
+
+avif::util::FileLogger& logger() {
+  static avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::INFO);
+  return log;
+}
+
+}
+
+TEST(BitStreamReaderTest, ReadsAcrossBytesAndRefills) {
+  using avif::av1::BitStreamReader;
+  std::vector<uint8_t> buffer(21);
+  for(size_t i = 0; i < buffer.size(); ++i) {
+    buffer[i] = static_cast<uint8_t>(i * 37u + 11u);
+  }
+  // The same bits, one by one.
+  auto const bitAt = [&](size_t const pos) -> uint64_t {
+    return (buffer[pos / 8] >> (7u - pos % 8u)) & 1u;
+  };
+  BitStreamReader reader(logger(), buffer);
+  size_t pos = 0;
+  for(size_t bits : {3, 1, 8, 13, 0, 64, 5, 33, 7, 2}) {
+    uint64_t expected = 0;
+    for(size_t i = 0; i < bits; ++i) {
+      expected = expected << 1u | bitAt(pos + i);
+    }
+    ASSERT_EQ(expected, reader.readUint(bits)) << bits << " bits at " << pos;
+    pos += bits;
+    ASSERT_EQ(pos, reader.posInBits());
+    ASSERT_EQ(pos / 8, reader.posInBytes());
+  }
+  reader.seekInBytes(17);
+  ASSERT_EQ(buffer[17], reader.readU8());
+  ASSERT_EQ(static_cast<uint16_t>(buffer[18] << 8u | buffer[19]), reader.readU16());
+  ASSERT_FALSE(reader.consumed());
+  ASSERT_THROW(static_cast<void>(reader.readU16()), std::range_error);
+  ASSERT_EQ(buffer[20], reader.readU8());
+  ASSERT_TRUE(reader.consumed());
+  ASSERT_EQ(21u, reader.posInBytes());
+}
+
+TEST(BitStreamReaderTest, ReadsLEB128AndUVLC) {
+  using avif::av1::BitStreamReader;
+  // leb128: 300, 5, then 0 written in 8 bytes.
+  std::vector<uint8_t> const lebs = {0xac, 0x02, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+  BitStreamReader leb(logger(), lebs);
+  ASSERT_EQ(300u, leb.readLEB128());
+  ASSERT_EQ(5u, leb.readLEB128());
+  ASSERT_EQ(0u, leb.readLEB128());
+  ASSERT_EQ(11u, leb.posInBytes());
+
+  // uvlc: "1" = 0, "010" = 1, "00100" = 3, 40 zeros then a one = 0xffffffff, then "0001000" = 7.
+  std::vector<uint8_t> const uvlcs = {0b10100010, 0b00000000, 0, 0, 0, 0, 0b01000100, 0b00000000};
+  BitStreamReader uvlc(logger(), uvlcs);
+  ASSERT_EQ(0u, uvlc.readUVLC());
+  ASSERT_EQ(1u, uvlc.readUVLC());
+  ASSERT_EQ(3u, uvlc.readUVLC());
+  ASSERT_EQ(0xffffffffu, uvlc.readUVLC());
+  ASSERT_EQ(7u, uvlc.readUVLC());
+  ASSERT_THROW(static_cast<void>(uvlc.readUVLC()), std::range_error);
+}
@@ -0,0 +1,73 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "../../src/avif/av1/OBUScanner.hpp"
+#include "../../src/avif/av1/Parser.hpp"
+#include "../../src/avif/util/FileLogger.hpp"
+
+TEST(OBUScannerTest, FindsTheBoundariesParserFinds) {
+  using avif::av1::OBU;
+  using avif::av1::Header;
+  // A temporal delimiter and a sequence header with obu_size,
+  // a padding OBU with an extension header (temporal_id 5, spatial_id 2),
+  // then a padding OBU without obu_size, which extends to the end.
+  static std::vector<uint8_t> const TEST_OBU = {
+      0x12, 0x00,
+      0x0a, 0x0b, 0x20, 0x00, 0x00, 0x42, 0x6b, 0xbf, 0xbc, 0x6f, 0xff, 0xcc, 0x10,
+      0x7e, 0xb0, 0x82, 0x00, 0x80, 0x00,
+      0x78, 0x80,
+  };
+  std::vector<OBU> obus;
+  for(OBU const& obu : avif::av1::scanOBUs(TEST_OBU)) {
+    obus.emplace_back(obu);
+  }
+  ASSERT_EQ(4, obus.size());
+  ASSERT_EQ(Header::Type::TemporalDelimiter, obus[0].type);
+  ASSERT_EQ(0, obus[0].payloadSize);
+  ASSERT_EQ(Header::Type::SequenceHeader, obus[1].type);
+  ASSERT_EQ(2, obus[1].headerOffset);
+  ASSERT_EQ(4, obus[1].payloadOffset);
+  ASSERT_EQ(11, obus[1].payloadSize);
+  ASSERT_EQ(Header::Type::Padding, obus[2].type);
+  ASSERT_EQ(5, obus[2].temporalID);
+  ASSERT_EQ(2, obus[2].spatialID);
+  // obu_size in two bytes, with a redundant continuation.
+  ASSERT_EQ(19, obus[2].payloadOffset);
+  ASSERT_EQ(2, obus[2].payloadSize);
+  ASSERT_EQ(Header::Type::Padding, obus[3].type);
+  ASSERT_EQ(22, obus[3].payloadOffset);
+  ASSERT_EQ(TEST_OBU.size(), obus[3].end());
+
+  avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::INFO);
+  avif::av1::Parser parser(log, TEST_OBU);
+  auto const result = parser.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(obus.size(), result->packets().size());
+  for(size_t i = 0; i < obus.size(); ++i) {
+    ASSERT_EQ(result->packets()[i].type(), obus[i].type);
+    ASSERT_EQ(result->packets()[i].beg(), obus[i].headerOffset);
+    ASSERT_EQ(result->packets()[i].end(), obus[i].end());
+  }
+}
+
+TEST(OBUScannerTest, ThrowsWhenAnOBURunsPastTheEnd) {
+  auto const count = [](std::vector<uint8_t> const& buffer) {
+    size_t n = 0;
+    for(auto it = avif::av1::scanOBUs(buffer).begin(); it != avif::av1::scanOBUs(buffer).end(); ++it) {
+      ++n;
+    }
+    return n;
+  };
+  ASSERT_EQ(0, count({}));
+  // obu_size says 3, but only 2 bytes follow.
+  ASSERT_THROW(count({0x12, 0x00, 0x7a, 0x03, 0x80, 0x00}), std::out_of_range);
+  // obu_size is cut off.
+  ASSERT_THROW(count({0x7a, 0x80}), std::out_of_range);
+  // The extension header is missing.
+  ASSERT_THROW(count({0x7c}), std::out_of_range);
+}
@@ -0,0 +1,73 @@
+//
+// Created by psi on 2026/10/17.
+//
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include "../../src/avif/av1/OperatingPoint.hpp"
+#include "../../src/avif/av1/Parser.hpp"
+#include "../../src/avif/util/FileLogger.hpp"
+
+namespace {
+
+// A sequence header with two operating points: 0 has spatial layers 0 and 1, 1 has only spatial layer 0.
+// Each temporal unit has padding OBUs in place of the frames of both layers.
+std::vector<uint8_t> const TD = {0x12, 0x00};
+std::vector<uint8_t> const SH = {0x0a, 0x0c, 0x00, 0x13, 0x03, 0x20, 0x80, 0x91, 0x99, 0xfa, 0xf3, 0x09, 0xe4, 0x01};
+std::vector<uint8_t> const L0 = {0x7e, 0x00, 0x02, 0x80, 0x00};
+std::vector<uint8_t> const L1 = {0x7e, 0x08, 0x01, 0x80};
+
+std::vector<uint8_t> concat(std::initializer_list<std::vector<uint8_t>> const parts) {
+  std::vector<uint8_t> buffer;
+  for(auto const& part : parts) {
+    buffer.insert(buffer.end(), part.begin(), part.end());
+  }
+  return buffer;
+}
+
+}
+
+TEST(OperatingPointTest, ParserDropsOtherLayers) {
+  avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::INFO);
+  std::vector<uint8_t> const stream = concat({TD, SH, L0, L1, TD, L0, L1});
+  {
+    avif::av1::Parser parser(log, stream);
+    auto const result = parser.parse();
+    ASSERT_TRUE(result->ok()) << result->error();
+    ASSERT_EQ(7, result->packets().size());
+    auto const shdr = std::get<avif::av1::SequenceHeader>(result->packets().at(1).content());
+    ASSERT_EQ(2, shdr.operatingPoints.size());
+    ASSERT_EQ(0x303, shdr.operatingPoints[0].idc);
+    ASSERT_EQ(0x101, shdr.operatingPoints[1].idc);
+    ASSERT_EQ(1, result->packets().at(3).header().extensionHeader->spatialID);
+  }
+  {
+    avif::av1::Parser parser(log, stream, 1);
+    auto const result = parser.parse();
+    ASSERT_TRUE(result->ok()) << result->error();
+    ASSERT_EQ(5, result->packets().size());
+    for(auto const& packet : result->packets()) {
+      ASSERT_TRUE(!packet.header().extensionFlag || packet.header().extensionHeader->spatialID == 0);
+    }
+  }
+  avif::av1::Parser parser(log, stream, 2);
+  ASSERT_FALSE(parser.parse()->ok());
+}
+
+TEST(OperatingPointTest, ExtractsTheOBUsOfTheLayer) {
+  avif::util::FileLogger log(stdout, stderr, avif::util::FileLogger::Level::INFO);
+  avif::util::Buffer const stream(concat({TD, SH, L0, L1, TD, L0, L1}));
+
+  avif::util::Buffer const base = avif::av1::extractOperatingPoint(log, stream, 1);
+  ASSERT_EQ(concat({TD, SH, L0, TD, L0}), base.toVector());
+
+  // Every OBU is in operating point 0, so it shares the bytes of the stream.
+  avif::util::Buffer const all = avif::av1::extractOperatingPoint(log, stream, 0);
+  ASSERT_EQ(stream.data(), all.data());
+  ASSERT_EQ(stream.size(), all.size());
+
+  ASSERT_THROW(static_cast<void>(avif::av1::extractOperatingPoint(log, stream, 2)), std::out_of_range);
+  ASSERT_THROW(static_cast<void>(avif::av1::extractOperatingPoint(log, avif::util::Buffer(concat({TD, L0})), 0)), std::invalid_argument);
+}
@@ -2,12 +2,29 @@
 // Created by psi on 2020/01/11.
 //
 
+#include <set>
 #include <vector>
 #include <memory>
 #include <gtest/gtest.h>
 #include "../../src/avif/av1/Parser.hpp"
 #include "../../src/avif/util/FileLogger.hpp"
 
+namespace {
+
+// Two 16x16 frames: temporal delimiter, sequence header and a key frame, then temporal delimiter and an inter frame.
+std::vector<uint8_t> const TWO_FRAMES = {
+    0x12, 0x00, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0xf8, 0xcf, 0xfc, 0x42, 0x14,
+    0x01, 0x40, 0x32, 0x31, 0x10, 0x02, 0x9f, 0x23, 0x89, 0xfa, 0xed, 0xe3,
+    0x60, 0x00, 0x10, 0xa8, 0x0f, 0xac, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x41, 0x04, 0x10, 0x10, 0x09, 0xae, 0x1f, 0x80, 0xbb, 0x31, 0xf7, 0x63,
+    0x0b, 0x1b, 0xff, 0xbf, 0x6a, 0xed, 0x2f, 0x9a, 0x10, 0xa5, 0xdc, 0xbb,
+    0x12, 0x18, 0x2c, 0x9e, 0xc0, 0x12, 0x00, 0x32, 0x16, 0x30, 0x0a, 0x20,
+    0x01, 0x40, 0x10, 0x06, 0x2a, 0x43, 0xf9, 0xdd, 0xc9, 0xb0, 0xc0, 0xe3,
+    0x8e, 0x38, 0x70, 0x00, 0x7a, 0x7d, 0x50,
+};
+
+}
+
 TEST(AV1Test, parsingSequenceHeaderOBU) {
   using avif::util::FileLogger;
   FileLogger log(stdout, stderr, FileLogger::Level::TRACE);
@@ -30,4 +47,251 @@ TEST(AV1Test, parsingSequenceHeaderOBU) {
   ASSERT_TRUE(seq.use128x128Superblock);
   ASSERT_FALSE(seq.filmGrainParamsPresent);
   ASSERT_FALSE(seq.enableSuperres);
-}
\ No newline at end of file
+}
+TEST(AV1Test, parsingFrameOBUs) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::TRACE);
+  using avif::av1::Parser;
+  using avif::av1::Header;
+  using avif::av1::Frame;
+  using avif::av1::FrameHeader;
+
+  Parser p = Parser(log, TWO_FRAMES);
+  std::shared_ptr<Parser::Result> result = p.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(5, result->packets().size());
+
+  Parser::Result::Packet const& key = result->packets().at(2);
+  ASSERT_EQ(Header::Type::Frame, key.type());
+  ASSERT_TRUE(std::holds_alternative<Frame>(key.content()));
+  auto const& keyFrame = std::get<Frame>(key.content());
+  ASSERT_EQ(FrameHeader::FrameType::KeyFrame, keyFrame.frameHeader.frameType);
+  ASSERT_TRUE(keyFrame.frameHeader.showFrame);
+  ASSERT_EQ(16, keyFrame.frameHeader.frameWidth);
+  ASSERT_EQ(16, keyFrame.frameHeader.frameHeight);
+  ASSERT_EQ(16, keyFrame.frameHeader.renderWidth);
+  ASSERT_EQ(0xff, keyFrame.frameHeader.refreshFrameFlags);
+  ASSERT_EQ(FrameHeader::PRIMARY_REF_NONE, keyFrame.frameHeader.primaryRefFrame);
+  ASSERT_EQ(79, keyFrame.frameHeader.quantizationParams.baseQIdx);
+  ASSERT_EQ(1, keyFrame.frameHeader.tileInfo.tileCols);
+  ASSERT_EQ(1, keyFrame.frameHeader.tileInfo.tileRows);
+  ASSERT_EQ(16, keyFrame.frameHeader.tileWidth(0));
+  ASSERT_EQ(1, keyFrame.tileGroup.tiles.size());
+  ASSERT_EQ(40, keyFrame.tileGroup.tiles.at(0).offset);
+  ASSERT_EQ(key.end(), keyFrame.tileGroup.tiles.at(0).offset + keyFrame.tileGroup.tiles.at(0).size);
+
+  Parser::Result::Packet const& inter = result->packets().at(4);
+  ASSERT_TRUE(std::holds_alternative<Frame>(inter.content()));
+  auto const& interFrame = std::get<Frame>(inter.content());
+  ASSERT_EQ(FrameHeader::FrameType::InterFrame, interFrame.frameHeader.frameType);
+  ASSERT_EQ(1, interFrame.frameHeader.orderHint);
+  ASSERT_EQ(0x20, interFrame.frameHeader.refreshFrameFlags);
+  // Sizes of frames without frame_size_override_flag come from the sequence header.
+  ASSERT_EQ(16, interFrame.frameHeader.frameWidth);
+  ASSERT_EQ(138, interFrame.frameHeader.quantizationParams.baseQIdx);
+  ASSERT_EQ(inter.end(), interFrame.tileGroup.tiles.at(0).offset + interFrame.tileGroup.tiles.at(0).size);
+}
+
+TEST(AV1Test, parsingReducedStillPictureWithScreenContentTools) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::TRACE);
+  // A 16x16 still picture with reduced_still_picture_header, whose key frame turns allow_screen_content_tools on.
+  // Both seq_force_screen_content_tools and seq_force_integer_mv are SELECT, so the frame header has force_integer_mv.
+  static std::vector<uint8_t> const TEST_OBU = {
+      0x12, 0x00, 0x0a, 0x06, 0x1f, 0xcc, 0xff, 0xc8, 0x02, 0x80, 0x32, 0x30,
+      0x65, 0x3e, 0x47, 0x13, 0xf5, 0xdb, 0xc6, 0xc0, 0x00, 0x21, 0x50, 0x1f,
+      0x58, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x82, 0x08, 0x20, 0x20, 0x09,
+      0xae, 0x1e, 0x57, 0xbb, 0x1c, 0x01, 0xef, 0x15, 0x5f, 0xff, 0xc0, 0xee,
+      0x0c, 0xd5, 0xf7, 0x47, 0xfb, 0x43, 0x16, 0x1c, 0xdf, 0x6a, 0x2d, 0x40,
+  };
+  using avif::av1::Parser;
+  using avif::av1::Frame;
+  using avif::av1::SequenceHeader;
+
+  Parser p = Parser(log, TEST_OBU);
+  std::shared_ptr<Parser::Result> result = p.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(3, result->packets().size());
+  auto const& seq = std::get<SequenceHeader>(result->packets().at(1).content());
+  ASSERT_TRUE(seq.reducedStillPictureHeader);
+  ASSERT_EQ(SequenceHeader::SELECT_INTEGER_MV, seq.seqForceIntegerMV);
+
+  Parser::Result::Packet const& packet = result->packets().at(2);
+  auto const& frame = std::get<Frame>(packet.content());
+  ASSERT_TRUE(frame.frameHeader.allowScreenContentTools);
+  ASSERT_TRUE(frame.frameHeader.forceIntegerMV);
+  ASSERT_EQ(16, frame.frameHeader.renderWidth);
+  ASSERT_EQ(16, frame.frameHeader.renderHeight);
+  ASSERT_EQ(79, frame.frameHeader.quantizationParams.baseQIdx);
+  ASSERT_EQ(35, frame.tileGroup.tiles.at(0).offset);
+  ASSERT_EQ(packet.end(), frame.tileGroup.tiles.at(0).offset + frame.tileGroup.tiles.at(0).size);
+}
+
+TEST(AV1Test, parsingFrameWithFilmGrain) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::TRACE);
+  // A flat 16x16 key frame with film grain: 14 luma points, the most film_grain_params() allows, then chroma points
+  // and auto-regression coefficients for every plane.
+  static std::vector<uint8_t> const TEST_OBU = {
+      0x12, 0x00, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x01, 0x9f, 0xf9, 0xb5, 0xf2,
+      0x01, 0x80, 0x32, 0x76, 0x10, 0x00, 0x80, 0x01, 0xbd, 0xe4, 0xe1, 0x00,
+      0x01, 0x98, 0x82, 0x19, 0x02, 0x9a, 0x03, 0x0a, 0x83, 0x88, 0x84, 0x38,
+      0x05, 0x29, 0x06, 0x19, 0x87, 0x19, 0x08, 0x0b, 0x08, 0xfa, 0x89, 0xeb,
+      0x0b, 0x2b, 0x84, 0x08, 0x00, 0x0a, 0x20, 0x0e, 0x2c, 0x1e, 0x34, 0x2d,
+      0x44, 0x34, 0xd0, 0x43, 0x54, 0x54, 0x68, 0x48, 0x80, 0x00, 0xe3, 0x01,
+      0xc2, 0x82, 0x13, 0x02, 0x83, 0x43, 0x63, 0x03, 0xd3, 0x84, 0x4b, 0x85,
+      0x4d, 0x87, 0x40, 0x40, 0x23, 0x40, 0x40, 0x40, 0x1a, 0x72, 0x2a, 0xc0,
+      0x26, 0xe9, 0x40, 0x40, 0x27, 0xc0, 0x40, 0x40, 0x2e, 0x4b, 0x31, 0x40,
+      0x2d, 0x43, 0xd3, 0xc0, 0x40, 0x28, 0xc0, 0x40, 0x40, 0x30, 0xcf, 0xb3,
+      0xc0, 0x30, 0x46, 0x8e, 0x47, 0xbe, 0x00, 0x4b, 0x97, 0x00, 0x6c, 0x80,
+      0x0e, 0x90,
+  };
+  using avif::av1::Parser;
+  using avif::av1::Frame;
+  using avif::av1::SequenceHeader;
+
+  Parser p = Parser(log, TEST_OBU);
+  std::shared_ptr<Parser::Result> result = p.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(3, result->packets().size());
+  ASSERT_TRUE(std::get<SequenceHeader>(result->packets().at(1).content()).filmGrainParamsPresent);
+  Parser::Result::Packet const& packet = result->packets().at(2);
+  auto const& frame = std::get<Frame>(packet.content());
+  ASSERT_EQ(16, frame.frameHeader.frameWidth);
+  ASSERT_EQ(132, frame.tileGroup.tiles.at(0).offset);
+  ASSERT_EQ(packet.end(), frame.tileGroup.tiles.at(0).offset + frame.tileGroup.tiles.at(0).size);
+}
+
+TEST(AV1Test, parsingMetadataOBUs) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::TRACE);
+  static std::vector<uint8_t> const TEST_OBU = {
+      // HDR_CLL: 1000 and 400 cd/m^2.
+      0x2a, 0x06, 0x01, 0x03, 0xe8, 0x01, 0x90, 0x80,
+      // HDR_MDCV: BT.2020 primaries, D65, 1000 to 0.005 cd/m^2.
+      0x2a, 0x1a, 0x02,
+      0xb5, 0x3f, 0x4a, 0xc0, 0x2b, 0x85, 0xcc, 0x08, 0x21, 0x89, 0x0b, 0xc7,
+      0x50, 0x0d, 0x54, 0x39, 0x00, 0x03, 0xe8, 0x00, 0x00, 0x00, 0x00, 0x52, 0x80,
+      // SCALABILITY: L2T1 with 320x180 and 640x360.
+      0x2a, 0x0c, 0x03, 0x0e, 0x60, 0x01, 0x40, 0x00, 0xb4, 0x02, 0x80, 0x01, 0x68, 0x80,
+      // ITUT_T35: a payload which ends with a zero.
+      0x2a, 0x08, 0x04, 0xb5, 0x00, 0x3c, 0x00, 0x01, 0x00, 0x80,
+      // TIMECODE: 01:15:30, frame 24.
+      0x2a, 0x06, 0x05, 0x04, 0x0c, 0x3c, 0x78, 0x41,
+      // Unregistered user private metadata: skipped.
+      0x2a, 0x03, 0x06, 0x12, 0x34,
+  };
+  using avif::av1::Parser;
+  using namespace avif::av1;
+  Parser p = Parser(log, TEST_OBU);
+  std::shared_ptr<Parser::Result> result = p.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(6, result->packets().size());
+
+  auto const cll = std::get<MetadataHDRCLL>(result->packets().at(0).content()).toBox();
+  ASSERT_EQ(1000, cll.maxContentLightLevel);
+  ASSERT_EQ(400, cll.maxPicAverageLightLevel);
+
+  auto const& mdcv = std::get<MetadataHDRMDCV>(result->packets().at(1).content());
+  ASSERT_EQ(46399, mdcv.primaryChromaticityX[0]);
+  auto const box = mdcv.toBox();
+  // G, B, R in 0.00002.
+  ASSERT_EQ(8500, box.displayPrimariesX[0]);
+  ASSERT_EQ(39850, box.displayPrimariesY[0]);
+  ASSERT_EQ(6550, box.displayPrimariesX[1]);
+  ASSERT_EQ(35400, box.displayPrimariesX[2]);
+  ASSERT_EQ(15635, box.whitePointX);
+  ASSERT_EQ(16450, box.whitePointY);
+  ASSERT_EQ(10000000, box.maxDisplayMasteringLuminance);
+  ASSERT_EQ(50, box.minDisplayMasteringLuminance);
+
+  auto const& scalability = std::get<MetadataScalability>(result->packets().at(2).content());
+  ASSERT_TRUE(scalability.scalabilityStructure.has_value());
+  ASSERT_EQ(2, scalability.scalabilityStructure->spatialLayers.size());
+  ASSERT_EQ(640, scalability.scalabilityStructure->spatialLayers[1].maxWidth);
+  ASSERT_EQ(360, scalability.scalabilityStructure->spatialLayers[1].maxHeight);
+
+  auto const& t35 = std::get<MetadataITUTT35>(result->packets().at(3).content());
+  ASSERT_EQ(0xb5, t35.countryCode);
+  ASSERT_FALSE(t35.countryCodeExtensionByte.has_value());
+  ASSERT_EQ(std::vector<uint8_t>({0x00, 0x3c, 0x00, 0x01, 0x00}), t35.payloadBytes);
+
+  auto const& tc = std::get<MetadataTimecode>(result->packets().at(4).content());
+  ASSERT_TRUE(tc.fullTimestampFlag);
+  ASSERT_EQ(24, tc.nFrames);
+  ASSERT_EQ(1, tc.hoursValue);
+  ASSERT_EQ(15, tc.minutesValue);
+  ASSERT_EQ(30, tc.secondsValue);
+
+  ASSERT_TRUE(std::holds_alternative<std::monostate>(result->packets().at(5).content()));
+  ASSERT_EQ(Header::Type::Metadata, result->packets().at(5).type());
+}
+
+TEST(AV1Test, droppingBrokenMetadataOBUs) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::WARN);
+  static std::vector<uint8_t> const TEST_OBU = {
+      // ITUT_T35 without trailing bits: nothing but zeros after the country code.
+      0x2a, 0x04, 0x04, 0xb5, 0x00, 0x00,
+      // HDR_CLL with a trailing_one_bit of 0.
+      0x2a, 0x06, 0x01, 0x03, 0xe8, 0x01, 0x90, 0x00,
+      // HDR_CLL cut in the middle of max_fall.
+      0x2a, 0x04, 0x01, 0x03, 0xe8, 0x01,
+      // TIMECODE with no room for its trailing bits.
+      0x2a, 0x05, 0x05, 0x04, 0x0c, 0x3c, 0x78,
+      // HDR_CLL: 1000 and 400 cd/m^2.
+      0x2a, 0x06, 0x01, 0x03, 0xe8, 0x01, 0x90, 0x80,
+  };
+  using avif::av1::Parser;
+  using avif::av1::MetadataHDRCLL;
+  Parser p = Parser(log, TEST_OBU);
+  std::shared_ptr<Parser::Result> result = p.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  ASSERT_EQ(1, result->packets().size());
+  ASSERT_EQ(TEST_OBU.size() - 8, result->packets().at(0).beg());
+  ASSERT_EQ(400, std::get<MetadataHDRCLL>(result->packets().at(0).content()).maxFALL);
+}
+
+TEST(AV1Test, droppingBrokenFrameOBUs) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::WARN);
+  using avif::av1::Parser;
+  using avif::av1::Header;
+  std::vector<uint8_t> stream = TWO_FRAMES;
+  // The key frame turns into a frame OBU showing an existing frame, which only frame header OBUs may do.
+  stream.at(16) |= 0x80u;
+  // HDR_CLL: 1000 and 400 cd/m^2.
+  stream.insert(stream.end(), {0x2a, 0x06, 0x01, 0x03, 0xe8, 0x01, 0x90, 0x80});
+  Parser p = Parser(log, stream);
+  std::shared_ptr<Parser::Result> result = p.parse();
+  ASSERT_TRUE(result->ok()) << result->error();
+  auto const& packets = result->packets();
+  ASSERT_EQ(Header::Type::SequenceHeader, packets.at(1).type());
+  ASSERT_EQ(Header::Type::TemporalDelimiter, packets.at(2).type());
+  ASSERT_EQ(65, packets.at(2).beg());
+  ASSERT_EQ(400, std::get<avif::av1::MetadataHDRCLL>(packets.back().content()).maxFALL);
+}
+
+TEST(AV1Test, parsingTruncatedStreams) {
+  using avif::util::FileLogger;
+  FileLogger log(stdout, stderr, FileLogger::Level::INFO);
+  using avif::av1::Parser;
+  std::set<size_t> boundaries;
+  {
+    Parser p = Parser(log, TWO_FRAMES);
+    for (auto const& packet : p.parse()->packets()) {
+      boundaries.emplace(packet.end());
+    }
+  }
+  // Streams cut between OBUs are fine, but no OBU may run past the end of the stream.
+  for (size_t size = 1; size < TWO_FRAMES.size(); ++size) {
+    Parser p = Parser(log, std::vector<uint8_t>(TWO_FRAMES.begin(), std::next(TWO_FRAMES.begin(), static_cast<ptrdiff_t>(size))));
+    ASSERT_EQ(boundaries.count(size) > 0, p.parse()->ok()) << "size=" << size;
+  }
+
+  // An ITU-T T.35 metadata OBU whose obu_size claims more bytes than there are.
+  Parser t35 = Parser(log, std::vector<uint8_t>({0x2a, 0x08, 0x04, 0xb5, 0x00, 0x3c}));
+  std::shared_ptr<Parser::Result> const result = t35.parse();
+  ASSERT_FALSE(result->ok());
+  ASSERT_NE(std::string::npos, result->error().find("runs past the end")) << result->error();
+}